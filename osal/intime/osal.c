@@ -5,6 +5,7 @@
 
 #include <rt.h>
 #include <sys/time.h>
+#include <stdlib.h>
 #include <osal.h>
 
 static int64_t sysfrequency;
@@ -63,6 +64,16 @@ int osal_usleep(uint32 usec)
    return 1;
 }
 
+void *osal_malloc(size_t size)
+{
+   return malloc(size);
+}
+
+void osal_free(void *ptr)
+{
+   free(ptr);
+}
+
 /* Mutex is not needed when running single threaded */
 
 void osal_mtx_lock(osal_mutex_t * mtx)
@@ -110,7 +110,14 @@ void ecx_setbufstat(ecx_portt *port, uint8 idx, int bufstat);
 uint8 ecx_getindex(ecx_portt *port);
 int ecx_outframe(ecx_portt *port, uint8 idx, int sock);
 int ecx_outframe_red(ecx_portt *port, uint8 idx);
+int ecx_outframe_gather(ecx_portt *port, uint8 idx, const void *data, int offset, int length);
+void ecx_txbatch_begin(ecx_portt *port);
+int ecx_txbatch_flush(ecx_portt *port);
+void ecx_setlaunchtime(ecx_portt *port, int64 launchtime);
+int64 ecx_txclocktime(ecx_portt *port);
+int ecx_inframe_scatter(ecx_portt *port, uint8 idx, void *data, int offset, int length);
 int ecx_waitinframe(ecx_portt *port, uint8 idx, int timeout);
+int ecx_waitinframe_timer(ecx_portt *port, uint8 idx, osal_timert *timer);
 int ecx_srconfirm(ecx_portt *port, uint8 idx,int timeout);
 
 int ecx_inframe(ecx_portt *port, uint8 idx, int stacknumber);
@@ -421,6 +421,71 @@ int ecx_outframe_red(ecx_portt *port, uint8 idx)
    return rval;
 }
 
+/** Transmit process data frame set up without data. This driver copies the
+ * data into the tx buffer and transmits it with ecx_outframe_red().
+ * @param[in] port        = port context struct
+ * @param[in] idx         = index in tx buffer array
+ * @param[in] data        = data of datagram
+ * @param[in] offset      = offset of data in tx buffer
+ * @param[in] length      = length of data
+ * @return socket send result
+ */
+int ecx_outframe_gather(ecx_portt *port, uint8 idx, const void *data, int offset, int length)
+{
+   memcpy(&(port->txbuf[idx][offset]), data, length);
+   return ecx_outframe_red(port, idx);
+}
+
+/** Start collecting frames for a single transmit. This driver transmits
+ * every frame immediately, so there is nothing to collect.
+ * @param[in] port        = port context struct
+ */
+void ecx_txbatch_begin(ecx_portt *port)
+{
+}
+
+/** Transmit frames collected since ecx_txbatch_begin().
+ * @param[in] port        = port context struct
+ * @return number of frames transmitted
+ */
+int ecx_txbatch_flush(ecx_portt *port)
+{
+   return 0;
+}
+
+/** Set launch time of the frames transmitted next. This driver has no time
+ * triggered transmit, frames are transmitted immediately.
+ * @param[in] port        = port context struct
+ * @param[in] launchtime  = launch time in ns, 0 = immediately
+ */
+void ecx_setlaunchtime(ecx_portt *port, int64 launchtime)
+{
+}
+
+/** Current time of the clock of the launch times. This driver has no time
+ * triggered transmit.
+ * @param[in] port        = port context struct
+ * @return 0
+ */
+int64 ecx_txclocktime(ecx_portt *port)
+{
+   return 0;
+}
+
+/** Receive the payload of a frame straight into its destination. This driver
+ * keeps received frames in the rx buffers, the caller copies the payload.
+ * @param[in] port        = port context struct
+ * @param[in] idx         = index in rx buffer array
+ * @param[in] data        = destination of payload
+ * @param[in] offset      = offset of payload in frame
+ * @param[in] length      = length of payload
+ * @return FALSE, payload stays in the rx buffer
+ */
+int ecx_inframe_scatter(ecx_portt *port, uint8 idx, void *data, int offset, int length)
+{
+   return FALSE;
+}
+
 /** Non blocking read of socket. Put frame in temporary buffer.
  * @param[in] stacknumber = 0=primary 1=secondary stack
  * @return >0 if frame is available and read
@@ -670,6 +735,19 @@ int ecx_waitinframe(ecx_portt *port, uint8 idx, int timeout)
    return wkc;
 }
 
+/** Blocking receive frame function with a timer started by the caller, so
+ * several frames can share one deadline. Calls ec_waitinframe_red().
+ * @param[in] port        = port context struct
+ * @param[in] idx         = requested index of frame
+ * @param[in] timer       = absolute timeout time
+ * @return Workcounter if a frame is found with corresponding index, otherwise
+ * EC_NOFRAME.
+ */
+int ecx_waitinframe_timer(ecx_portt *port, uint8 idx, osal_timert *timer)
+{
+   return ecx_waitinframe_red(port, idx, timer);
+}
+
 /** Blocking send and receive frame function. Used for non processdata frames.
  * A datagram is build into a frame and transmitted via this function. It waits
  * for an answer and returns the workcounter. The function retries if time is
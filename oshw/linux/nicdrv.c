@@ -28,8 +28,28 @@
  * packets. The software layer will detect the possible failure modes and
  * compensate. If needed the packets from interface A are resent through interface B.
  * This layer if fully transparent for the higher layers.
+ *
+ * Each socket can use a memory mapped rx and tx ring (PACKET_MMAP) instead of
+ * plain send() and recv() calls. Select it by prefixing the interface name
+ * with "mmap:", f.e. "mmap:eth0". Frames are then copied straight into and
+ * parsed straight from the ring slots shared with the kernel. Polling for a
+ * received frame costs no system call and transmit only needs a zero length
+ * send() to kick the kernel. If the rings can not be set up the socket falls
+ * back to plain send() and recv().
+ *
+ * With the "xdp:" prefix, f.e. "xdp:eth1", frames go through an AF_XDP socket
+ * bound to rx queue 0 of the NIC. A minimal XDP program redirects only frames
+ * with EtherType 0x88A4 to the socket, all other traffic continues to the
+ * network stack. Zero-copy driver mode is used when the NIC supports it,
+ * otherwise generic (SKB) copy mode, so it also runs on a veth pair. The NIC
+ * must deliver EtherCAT frames on rx queue 0, f.e. by using a single queue.
+ *
+ * Frames transmitted between ecx_txbatch_begin() and ecx_txbatch_flush() are
+ * queued and sent with one system call per socket: sendmmsg() for a plain
+ * socket, a single kick of the tx ring for packet rings and AF_XDP.
  */
 
+#define _GNU_SOURCE
 #include <sys/types.h>
 #include <sys/ioctl.h>
 #include <net/if.h>
@@ -41,8 +61,20 @@
 #include <stdio.h>
 #include <fcntl.h>
 #include <string.h>
-#include <netpacket/packet.h>
+#include <linux/if_packet.h>
+#include <linux/if_xdp.h>
+#include <linux/if_link.h>
+#include <linux/bpf.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <poll.h>
+#include <linux/futex.h>
+#include <linux/io_uring.h>
+#include <linux/net_tstamp.h>
+#include <linux/sockios.h>
+#include <limits.h>
 #include <pthread.h>
+#include <stdlib.h>
 
 #include "oshw.h"
 #include "osal.h"
@@ -72,205 +104,2264 @@ const uint16 secMAC[3] = { 0x0404, 0x0404, 0x0404 };
 /** second MAC word is used for identification */
 #define RX_SEC secMAC[1]
 
-static void ecx_clear_rxbufstat(int *rxbufstat)
+/** size of one PACKET_MMAP frame slot, holds the largest EtherCAT frame */
+#define EC_RINGFRAMESIZE  2048
+/** min. number of frame slots in each PACKET_MMAP ring, raised to the frame
+ * pool size of the port */
+#define EC_RINGFRAMES     64
+/** number of frame slots in one PACKET_MMAP ring block */
+#define EC_RINGBLOCKFRAMES 4
+/** offset of frame data in a PACKET_MMAP tx slot */
+#define EC_RINGTXOFFSET   TPACKET_ALIGN(sizeof(struct tpacket2_hdr))
+/** size of one AF_XDP UMEM chunk, holds the largest EtherCAT frame */
+#define EC_XSKCHUNKSIZE   2048
+/** number of rx queues the XSKMAP of the XDP program can hold */
+#define EC_XSKMAXQUEUES   64
+/** user data flag of io_uring send requests, receives carry their buffer */
+#define EC_URINGTX        ((uint64)1 << 32)
+/** size of the control buffer that receives SCM_TIMESTAMPING */
+#define EC_TSCTLSIZE      CMSG_SPACE(3 * sizeof(struct timespec))
+/** size of the control buffer that carries SCM_TXTIME, in uint64 */
+#define EC_TXTIMECTLSIZE  (CMSG_SPACE(sizeof(uint64)) / sizeof(uint64))
+/** max. number of frames read from the error queue per call */
+#define EC_TSMAXREAD      (2 * EC_MAXBUF)
+
+static void ecx_clear_rxbufstat(int *rxbufstat, int maxbuf)
 {
    int i;
-   for(i = 0; i < EC_MAXBUF; i++)
+   for(i = 0; i < maxbuf; i++)
    {
       rxbufstat[i] = EC_BUF_EMPTY;
    }
 }
 
-/** Basic setup to connect NIC to socket.
- * @param[in] port        = port context struct
- * @param[in] ifname      = Name of NIC device, f.e. "eth0"
- * @param[in] secondary   = if >0 then use secondary stack instead of primary
- * @return >0 if succeeded
+/** Read rx buffer status. The acquire pairs with the release in
+ * ecx_storebufstat(), so buffer contents written before a status change are
+ * visible to the thread that sees the new status.
+ * @param[in] bufstat  = rx buffer status field
+ * @return status
  */
-int ecx_setupnic(ecx_portt *port, const char *ifname, int secondary)
+static int ecx_loadbufstat(int *bufstat)
 {
-   int i;
-   int r, rval, ifindex;
-   struct timeval timeout;
-   struct ifreq ifr;
-   struct sockaddr_ll sll;
-   int *psock;
-   pthread_mutexattr_t mutexattr;
+   return __atomic_load_n(bufstat, __ATOMIC_ACQUIRE);
+}
 
-   rval = 0;
-   if (secondary)
+/** Write rx buffer status.
+ * @param[in] bufstat  = rx buffer status field
+ * @param[in] value    = status to set
+ */
+static void ecx_storebufstat(int *bufstat, int value)
+{
+   __atomic_store_n(bufstat, value, __ATOMIC_RELEASE);
+}
+
+/** Add to a counter of port->stats, the counters are updated by all threads
+ * using the port.
+ * @param[in] counter  = counter in port->stats
+ * @param[in] n        = amount to add
+ */
+static void ecx_statadd(uint64 *counter, uint64 n)
+{
+   __atomic_fetch_add(counter, n, __ATOMIC_RELAXED);
+}
+
+/** Release rx buffers of a socket allocated by ecx_rxpool_setup().
+ * @param[in] pool       = built in rx buffers of the socket
+ * @param[in] rxbuf      = rx buffers
+ * @param[in] rxbufstat  = rx buffer status fields
+ * @param[in] rxsa       = rx MAC source address fields
+ * @param[in] frametime  = wire times
+ */
+static void ecx_rxpool_free(ec_rxpoolt *pool, ec_bufT **rxbuf, int **rxbufstat, int **rxsa,
+   ec_frametimet **frametime)
+{
+   if (*rxbuf != pool->rxbuf)
    {
-      /* secondary port struct available? */
-      if (port->redport)
+      free(*rxbuf);
+      free(*rxbufstat);
+      free(*rxsa);
+      free(*frametime);
+   }
+   *rxbuf = pool->rxbuf;
+   *rxbufstat = pool->rxbufstat;
+   *rxsa = pool->rxsa;
+   *frametime = pool->frametime;
+}
+
+/** Select rx buffers of a socket. Up to EC_MAXBUF frames the built in buffers
+ * are used, larger pools are allocated. Pointers left by an earlier setup are
+ * not released here, that is done by ecx_closenic().
+ * @param[in]  pool       = built in rx buffers of the socket
+ * @param[in]  maxbuf     = number of frame buffers
+ * @param[out] rxbuf      = rx buffers
+ * @param[out] rxbufstat  = rx buffer status fields
+ * @param[out] rxsa       = rx MAC source address fields
+ * @param[out] frametime  = wire times
+ * @return >0 if succeeded
+ */
+static int ecx_rxpool_setup(ec_rxpoolt *pool, int maxbuf, ec_bufT **rxbuf, int **rxbufstat, int **rxsa,
+   ec_frametimet **frametime)
+{
+   *rxbuf = pool->rxbuf;
+   *rxbufstat = pool->rxbufstat;
+   *rxsa = pool->rxsa;
+   *frametime = pool->frametime;
+   if (maxbuf > EC_MAXBUF)
+   {
+      *rxbuf = malloc(maxbuf * sizeof(ec_bufT));
+      *rxbufstat = malloc(maxbuf * sizeof(int));
+      *rxsa = malloc(maxbuf * sizeof(int));
+      *frametime = malloc(maxbuf * sizeof(ec_frametimet));
+      if (!*rxbuf || !*rxbufstat || !*rxsa || !*frametime)
       {
-         /* when using secondary socket it is automatically a redundant setup */
-         psock = &(port->redport->sockhandle);
-         *psock = -1;
-         port->redstate                   = ECT_RED_DOUBLE;
-         port->redport->stack.sock        = &(port->redport->sockhandle);
-         port->redport->stack.txbuf       = &(port->txbuf);
-         port->redport->stack.txbuflength = &(port->txbuflength);
-         port->redport->stack.tempbuf     = &(port->redport->tempinbuf);
-         port->redport->stack.rxbuf       = &(port->redport->rxbuf);
-         port->redport->stack.rxbufstat   = &(port->redport->rxbufstat);
-         port->redport->stack.rxsa        = &(port->redport->rxsa);
-         ecx_clear_rxbufstat(&(port->redport->rxbufstat[0]));
+         ecx_rxpool_free(pool, rxbuf, rxbufstat, rxsa, frametime);
+         return 0;
       }
-      else
+   }
+   memset(*frametime, 0, maxbuf * sizeof(ec_frametimet));
+
+   return 1;
+}
+
+/** Release tx buffers and rx payload destinations of a port allocated by
+ * ecx_txpool_setup().
+ * @param[in] port        = port context struct
+ */
+static void ecx_txpool_free(ecx_portt *port)
+{
+   if (port->txbuf != port->txpool.txbuf)
+   {
+      free(port->txbuf);
+      free(port->txbuflength);
+   }
+   free(port->rxdest);
+   free(port->txbatch);
+   port->txbuf = port->txpool.txbuf;
+   port->txbuflength = port->txpool.txbuflength;
+   port->rxdest = NULL;
+   port->txbatch = NULL;
+}
+
+/** Select tx buffers of a port. Up to EC_MAXBUF frames the built in buffers
+ * are used, larger pools are allocated. The rx payload destinations of
+ * ecx_inframe_scatter() and the batches of ecx_txbatch_begin() are always
+ * allocated. Pointers left by an earlier
+ * setup are not released here, that is done by ecx_closenic().
+ * @param[in] port        = port context struct
+ * @return >0 if succeeded
+ */
+static int ecx_txpool_setup(ecx_portt *port)
+{
+   port->txbuf = port->txpool.txbuf;
+   port->txbuflength = port->txpool.txbuflength;
+   port->txbatch = NULL;
+   port->rxdest = malloc(port->maxbuf * sizeof(ec_rxdestt));
+   if (!port->rxdest)
+   {
+      return 0;
+   }
+   memset(port->rxdest, 0, port->maxbuf * sizeof(ec_rxdestt));
+   port->txbatch = malloc(EC_TXBATCHES * sizeof(ec_txbatcht));
+   if (!port->txbatch)
+   {
+      ecx_txpool_free(port);
+      return 0;
+   }
+   memset(port->txbatch, 0, EC_TXBATCHES * sizeof(ec_txbatcht));
+   if (port->maxbuf > EC_MAXBUF)
+   {
+      port->txbuf = malloc(port->maxbuf * sizeof(ec_bufT));
+      port->txbuflength = malloc(port->maxbuf * sizeof(int));
+      if (!port->txbuf || !port->txbuflength)
       {
-         /* fail */
+         ecx_txpool_free(port);
          return 0;
       }
    }
-   else
+
+   return 1;
+}
+
+/** Allocate the receive buffers of drain mode, kept until ecx_closenic().
+ * @param[in] port        = port context struct
+ * @return >0 if available
+ */
+static int ecx_rxdrain_alloc(ecx_portt *port)
+{
+   if (!port->rxdrainbuf)
    {
-      pthread_mutexattr_init(&mutexattr);
-      pthread_mutexattr_setprotocol(&mutexattr  , PTHREAD_PRIO_INHERIT);
-      pthread_mutex_init(&(port->getindex_mutex), &mutexattr);
-      pthread_mutex_init(&(port->tx_mutex)      , &mutexattr);
-      pthread_mutex_init(&(port->rx_mutex)      , &mutexattr);
-      port->sockhandle        = -1;
-      port->lastidx           = 0;
-      port->redstate          = ECT_RED_NONE;
-      port->stack.sock        = &(port->sockhandle);
-      port->stack.txbuf       = &(port->txbuf);
-      port->stack.txbuflength = &(port->txbuflength);
-      port->stack.tempbuf     = &(port->tempinbuf);
-      port->stack.rxbuf       = &(port->rxbuf);
-      port->stack.rxbufstat   = &(port->rxbufstat);
-      port->stack.rxsa        = &(port->rxsa);
-      ecx_clear_rxbufstat(&(port->rxbufstat[0]));
-      psock = &(port->sockhandle);
+      port->rxdrainbuf = malloc(EC_MAXBUF * sizeof(ec_bufT));
    }
-   /* we use RAW packet socket, with packet type ETH_P_ECAT */
-   *psock = socket(PF_PACKET, SOCK_RAW, htons(ETH_P_ECAT));
 
-   timeout.tv_sec =  0;
-   timeout.tv_usec = 1;
-   r = setsockopt(*psock, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
-   r = setsockopt(*psock, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
-   i = 1;
-   r = setsockopt(*psock, SOL_SOCKET, SO_DONTROUTE, &i, sizeof(i));
-   /* connect socket to NIC by name */
-   strcpy(ifr.ifr_name, ifname);
-   r = ioctl(*psock, SIOCGIFINDEX, &ifr);
-   ifindex = ifr.ifr_ifindex;
-   strcpy(ifr.ifr_name, ifname);
-   ifr.ifr_flags = 0;
-   /* reset flags of NIC interface */
-   r = ioctl(*psock, SIOCGIFFLAGS, &ifr);
-   /* set flags of NIC interface, here promiscuous and broadcast */
-   ifr.ifr_flags = ifr.ifr_flags | IFF_PROMISC | IFF_BROADCAST;
-   r = ioctl(*psock, SIOCSIFFLAGS, &ifr);
-   /* bind socket to protocol, in this case RAW EtherCAT */
-   sll.sll_family = AF_PACKET;
-   sll.sll_ifindex = ifindex;
-   sll.sll_protocol = htons(ETH_P_ECAT);
-   r = bind(*psock, (struct sockaddr *)&sll, sizeof(sll));
-   /* setup ethernet headers in tx buffers so we don't have to repeat it */
-   for (i = 0; i < EC_MAXBUF; i++)
+   return (port->rxdrainbuf != NULL);
+}
+
+/** Ring size for a frame pool, so all frames in flight fit in the ring.
+ * @param[in] maxbuf  = number of frame buffers of the port
+ * @param[in] min     = minimum ring size, a power of two
+ * @return power of two of at least min and maxbuf
+ */
+static uint32 ecx_ringsize(int maxbuf, uint32 min)
+{
+   uint32 n;
+
+   n = min;
+   while (n < (uint32)maxbuf)
    {
-      ec_setupheader(&(port->txbuf[i]));
-      port->rxbufstat[i] = EC_BUF_EMPTY;
+      n <<= 1;
    }
-   ec_setupheader(&(port->txbuf2));
-   if (r == 0) rval = 1;
 
-   return rval;
+   return n;
 }
 
-/** Close sockets used
- * @param[in] port        = port context struct
- * @return 0
+/** Strip the transport prefix from an interface name.
+ * @param[in]  ifname    = Name of NIC device, optionally with transport prefix
+ * @param[out] transport = transport selected by prefix
+ * @return interface name without prefix
  */
-int ecx_closenic(ecx_portt *port)
+static const char *ecx_parse_ifname(const char *ifname, int *transport)
 {
-   if (port->sockhandle >= 0)
-      close(port->sockhandle);
-   if ((port->redport) && (port->redport->sockhandle >= 0))
-      close(port->redport->sockhandle);
+   *transport = ECT_TRANSPORT_SOCKET;
+   if (strncmp(ifname, "mmap:", 5) == 0)
+   {
+      *transport = ECT_TRANSPORT_MMAP;
+      ifname += 5;
+   }
+   else if (strncmp(ifname, "xdp:", 4) == 0)
+   {
+      *transport = ECT_TRANSPORT_XDP;
+      ifname += 4;
+   }
+   else if (strncmp(ifname, "uring:", 6) == 0)
+   {
+      *transport = ECT_TRANSPORT_URING;
+      ifname += 6;
+   }
+
+   return ifname;
+}
+
+/** Setup memory mapped rx and tx ring on a bound packet socket.
+ * TPACKET_V2 is used, TPACKET_V3 only hands rx blocks to user space after they
+ * are full or retired by a timer with millisecond resolution.
+ * @param[in]  sock  = packet socket
+ * @param[out] ring  = ring administration
+ * @param[in]  frames = number of frame slots in each ring
+ * @return >0 if succeeded
+ */
+static int ecx_ring_setup(int sock, ec_ringt *ring, uint32 frames)
+{
+   struct tpacket_req req;
+   int version;
+   size_t ringlen;
+
+   memset(ring, 0, sizeof(*ring));
+   version = TPACKET_V2;
+   if (setsockopt(sock, SOL_PACKET, PACKET_VERSION, &version, sizeof(version)) < 0)
+   {
+      return 0;
+   }
+   req.tp_block_size = EC_RINGFRAMESIZE * EC_RINGBLOCKFRAMES;
+   req.tp_block_nr = frames / EC_RINGBLOCKFRAMES;
+   req.tp_frame_size = EC_RINGFRAMESIZE;
+   req.tp_frame_nr = frames;
+   if ((setsockopt(sock, SOL_PACKET, PACKET_RX_RING, &req, sizeof(req)) < 0) ||
+       (setsockopt(sock, SOL_PACKET, PACKET_TX_RING, &req, sizeof(req)) < 0))
+   {
+      return 0;
+   }
+   ringlen = (size_t)req.tp_block_size * req.tp_block_nr;
+   ring->map = mmap(NULL, 2 * ringlen, PROT_READ | PROT_WRITE, MAP_SHARED, sock, 0);
+   if (ring->map == MAP_FAILED)
+   {
+      ring->map = NULL;
+      return 0;
+   }
+   ring->maplen = 2 * ringlen;
+   ring->framesize = EC_RINGFRAMESIZE;
+   ring->framecount = frames;
+
+   return 1;
+}
+
+/** Release memory mapped rings of a socket.
+ * @param[in] ring  = ring administration
+ */
+static void ecx_ring_close(ec_ringt *ring)
+{
+   if (ring->map)
+   {
+      munmap(ring->map, ring->maplen);
+      ring->map = NULL;
+   }
+}
+
+/** Gather the parts of a frame into one buffer.
+ * @param[out] dst   = buffer
+ * @param[in] iov    = parts of frame
+ * @param[in] iovcnt = number of parts
+ * @return length of frame
+ */
+static int ecx_gather(uint8 *dst, const struct iovec *iov, int iovcnt)
+{
+   int i, len;
+
+   len = 0;
+   for (i = 0; i < iovcnt; i++)
+   {
+      memcpy(dst + len, iov[i].iov_base, iov[i].iov_len);
+      len += iov[i].iov_len;
+   }
+
+   return len;
+}
+
+/** Copy frame into next free tx ring slot and hand it to the kernel.
+ * The frame is not transmitted before the socket is kicked with send().
+ * @param[in] ring   = ring administration
+ * @param[in] iov    = parts of frame to transmit
+ * @param[in] iovcnt = number of parts
+ * @return length of frame or -1 if ring is full
+ */
+static int ecx_ring_queue(ec_ringt *ring, const struct iovec *iov, int iovcnt)
+{
+   struct tpacket2_hdr *hdr;
+   int len;
+
+   hdr = (struct tpacket2_hdr *)(ring->map + (ring->framecount + ring->txhead) * ring->framesize);
+   if (__atomic_load_n(&hdr->tp_status, __ATOMIC_ACQUIRE) != TP_STATUS_AVAILABLE)
+   {
+      return -1;
+   }
+   len = ecx_gather((uint8 *)hdr + EC_RINGTXOFFSET, iov, iovcnt);
+   hdr->tp_len = len;
+   __atomic_store_n(&hdr->tp_status, TP_STATUS_SEND_REQUEST, __ATOMIC_RELEASE);
+   ring->txhead = (ring->txhead + 1) % ring->framecount;
+
+   return len;
+}
+
+/** Issue bpf() system call.
+ * @param[in] cmd   = bpf command
+ * @param[in] attr  = command attributes
+ * @return system call result
+ */
+static int ecx_bpf(int cmd, union bpf_attr *attr)
+{
+   return (int)syscall(__NR_bpf, cmd, attr, sizeof(*attr));
+}
+
+/** Load XDP program that redirects EtherCAT frames to the XSKMAP entry of
+ * their rx queue. All other frames, and EtherCAT frames on a queue without
+ * socket, are passed on to the network stack.
+ * @param[in] mapfd  = XSKMAP
+ * @return program fd or -1 on failure
+ */
+static int ecx_xsk_loadprog(int mapfd)
+{
+   struct bpf_insn prog[] =
+   {
+      /* r2 = data, r3 = data_end */
+      { BPF_LDX | BPF_MEM | BPF_W, 2, 1, offsetof(struct xdp_md, data), 0 },
+      { BPF_LDX | BPF_MEM | BPF_W, 3, 1, offsetof(struct xdp_md, data_end), 0 },
+      /* pass frames shorter than an ethernet header */
+      { BPF_ALU64 | BPF_MOV | BPF_X, 4, 2, 0, 0 },
+      { BPF_ALU64 | BPF_ADD | BPF_K, 4, 0, 0, ETH_HEADERSIZE },
+      { BPF_JMP | BPF_JGT | BPF_X, 4, 3, 8, 0 },
+      /* pass frames that are not EtherCAT */
+      { BPF_LDX | BPF_MEM | BPF_H, 4, 2, 12, 0 },
+      { BPF_JMP | BPF_JNE | BPF_K, 4, 0, 6, htons(ETH_P_ECAT) },
+      /* redirect to socket of rx queue, pass if there is none */
+      { BPF_LDX | BPF_MEM | BPF_W, 2, 1, offsetof(struct xdp_md, rx_queue_index), 0 },
+      { BPF_LD | BPF_IMM | BPF_DW, 1, BPF_PSEUDO_MAP_FD, 0, mapfd },
+      { 0, 0, 0, 0, 0 },
+      { BPF_ALU64 | BPF_MOV | BPF_K, 3, 0, 0, XDP_PASS },
+      { BPF_JMP | BPF_CALL, 0, 0, 0, BPF_FUNC_redirect_map },
+      { BPF_JMP | BPF_EXIT, 0, 0, 0, 0 },
+      { BPF_ALU64 | BPF_MOV | BPF_K, 0, 0, 0, XDP_PASS },
+      { BPF_JMP | BPF_EXIT, 0, 0, 0, 0 }
+   };
+   union bpf_attr attr;
+
+   memset(&attr, 0, sizeof(attr));
+   attr.prog_type = BPF_PROG_TYPE_XDP;
+   attr.insns = (uint64)(uintptr_t)prog;
+   attr.insn_cnt = sizeof(prog) / sizeof(prog[0]);
+   attr.license = (uint64)(uintptr_t)"GPL";
+
+   return ecx_bpf(BPF_PROG_LOAD, &attr);
+}
+
+/** Map one ring of an AF_XDP socket.
+ * @param[in]  fd       = AF_XDP socket
+ * @param[out] xring    = ring administration
+ * @param[in]  off      = ring offsets reported by the kernel
+ * @param[in]  nframes  = number of ring entries
+ * @param[in]  descsize = size of one ring entry
+ * @param[in]  pgoff    = mmap offset selecting the ring
+ * @return >0 if succeeded
+ */
+static int ecx_xsk_mapring(int fd, ec_xskringt *xring, const struct xdp_ring_offset *off,
+   uint32 nframes, size_t descsize, off_t pgoff)
+{
+   xring->maplen = off->desc + nframes * descsize;
+   xring->map = mmap(NULL, xring->maplen, PROT_READ | PROT_WRITE,
+      MAP_SHARED | MAP_POPULATE, fd, pgoff);
+   if (xring->map == MAP_FAILED)
+   {
+      xring->map = NULL;
+      return 0;
+   }
+   xring->producer = (uint32 *)((uint8 *)xring->map + off->producer);
+   xring->consumer = (uint32 *)((uint8 *)xring->map + off->consumer);
+   xring->ring = (uint8 *)xring->map + off->desc;
+   xring->mask = nframes - 1;
+
+   return 1;
+}
+
+/** Release AF_XDP socket, rings, UMEM and detach XDP program.
+ * @param[in] xsk  = AF_XDP socket administration
+ */
+static void ecx_xsk_close(ec_xskt *xsk)
+{
+   ec_xskringt *xring[4];
+   int i;
+
+   if (xsk->linkfd >= 0)
+      close(xsk->linkfd);
+   if (xsk->progfd >= 0)
+      close(xsk->progfd);
+   if (xsk->mapfd >= 0)
+      close(xsk->mapfd);
+   xring[0] = &(xsk->rx);
+   xring[1] = &(xsk->tx);
+   xring[2] = &(xsk->fill);
+   xring[3] = &(xsk->comp);
+   for (i = 0; i < 4; i++)
+   {
+      if (xring[i]->map)
+         munmap(xring[i]->map, xring[i]->maplen);
+      xring[i]->map = NULL;
+   }
+   if (xsk->fd >= 0)
+      close(xsk->fd);
+   if (xsk->umem)
+      munmap(xsk->umem, xsk->umemlen);
+   free(xsk->txfree);
+   xsk->linkfd = xsk->progfd = xsk->mapfd = xsk->fd = -1;
+   xsk->umem = NULL;
+   xsk->txfree = NULL;
+}
+
+/** Setup AF_XDP socket on rx queue 0 of a NIC and attach the XDP program
+ * that feeds it. Tries zero-copy driver mode first, then generic copy mode.
+ * @param[out] xsk      = AF_XDP socket administration
+ * @param[in]  ifindex  = NIC interface index
+ * @param[in]  nframes  = number of ring entries, a power of two
+ * @return >0 if succeeded
+ */
+static int ecx_xsk_setup(ec_xskt *xsk, int ifindex, uint32 nframes)
+{
+   struct xdp_umem_reg mr;
+   struct xdp_mmap_offsets off;
+   struct sockaddr_xdp sxdp;
+   union bpf_attr attr;
+   socklen_t optlen;
+   uint64 *fillp;
+   uint32 n, key;
+   int i;
+
+   memset(xsk, 0, sizeof(*xsk));
+   xsk->linkfd = xsk->progfd = xsk->mapfd = -1;
+   xsk->fd = socket(AF_XDP, SOCK_RAW, 0);
+   if (xsk->fd < 0)
+      return 0;
+   xsk->txfree = malloc(nframes * sizeof(uint64));
+   if (!xsk->txfree)
+      goto fail;
+   /* UMEM, first half is handed to the fill ring, second half is for tx */
+   xsk->nframes = nframes;
+   xsk->umemlen = 2 * nframes * EC_XSKCHUNKSIZE;
+   xsk->umem = mmap(NULL, xsk->umemlen, PROT_READ | PROT_WRITE,
+      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+   if (xsk->umem == MAP_FAILED)
+   {
+      xsk->umem = NULL;
+      goto fail;
+   }
+   memset(&mr, 0, sizeof(mr));
+   mr.addr = (uint64)(uintptr_t)xsk->umem;
+   mr.len = xsk->umemlen;
+   mr.chunk_size = EC_XSKCHUNKSIZE;
+   n = nframes;
+   if ((setsockopt(xsk->fd, SOL_XDP, XDP_UMEM_REG, &mr, sizeof(mr)) < 0) ||
+       (setsockopt(xsk->fd, SOL_XDP, XDP_UMEM_FILL_RING, &n, sizeof(n)) < 0) ||
+       (setsockopt(xsk->fd, SOL_XDP, XDP_UMEM_COMPLETION_RING, &n, sizeof(n)) < 0) ||
+       (setsockopt(xsk->fd, SOL_XDP, XDP_RX_RING, &n, sizeof(n)) < 0) ||
+       (setsockopt(xsk->fd, SOL_XDP, XDP_TX_RING, &n, sizeof(n)) < 0))
+   {
+      goto fail;
+   }
+   optlen = sizeof(off);
+   if ((getsockopt(xsk->fd, SOL_XDP, XDP_MMAP_OFFSETS, &off, &optlen) < 0) ||
+       !ecx_xsk_mapring(xsk->fd, &(xsk->rx), &off.rx, n, sizeof(struct xdp_desc), XDP_PGOFF_RX_RING) ||
+       !ecx_xsk_mapring(xsk->fd, &(xsk->tx), &off.tx, n, sizeof(struct xdp_desc), XDP_PGOFF_TX_RING) ||
+       !ecx_xsk_mapring(xsk->fd, &(xsk->fill), &off.fr, n, sizeof(uint64), XDP_UMEM_PGOFF_FILL_RING) ||
+       !ecx_xsk_mapring(xsk->fd, &(xsk->comp), &off.cr, n, sizeof(uint64), XDP_UMEM_PGOFF_COMPLETION_RING))
+   {
+      goto fail;
+   }
+   /* hand all rx chunks to the kernel */
+   fillp = xsk->fill.ring;
+   for (i = 0; i < (int)nframes; i++)
+   {
+      fillp[i] = (uint64)i * EC_XSKCHUNKSIZE;
+      xsk->txfree[i] = (uint64)(nframes + i) * EC_XSKCHUNKSIZE;
+   }
+   __atomic_store_n(xsk->fill.producer, nframes, __ATOMIC_RELEASE);
+   xsk->ntxfree = nframes;
+   memset(&sxdp, 0, sizeof(sxdp));
+   sxdp.sxdp_family = AF_XDP;
+   sxdp.sxdp_ifindex = ifindex;
+   sxdp.sxdp_queue_id = 0;
+   sxdp.sxdp_flags = XDP_ZEROCOPY;
+   if (bind(xsk->fd, (struct sockaddr *)&sxdp, sizeof(sxdp)) < 0)
+   {
+      sxdp.sxdp_flags = XDP_COPY;
+      if (bind(xsk->fd, (struct sockaddr *)&sxdp, sizeof(sxdp)) < 0)
+         goto fail;
+   }
+   /* XSKMAP with our socket on queue 0 */
+   memset(&attr, 0, sizeof(attr));
+   attr.map_type = BPF_MAP_TYPE_XSKMAP;
+   attr.key_size = sizeof(uint32);
+   attr.value_size = sizeof(uint32);
+   attr.max_entries = EC_XSKMAXQUEUES;
+   xsk->mapfd = ecx_bpf(BPF_MAP_CREATE, &attr);
+   if (xsk->mapfd < 0)
+      goto fail;
+   key = 0;
+   memset(&attr, 0, sizeof(attr));
+   attr.map_fd = xsk->mapfd;
+   attr.key = (uint64)(uintptr_t)&key;
+   attr.value = (uint64)(uintptr_t)&(xsk->fd);
+   attr.flags = BPF_ANY;
+   if (ecx_bpf(BPF_MAP_UPDATE_ELEM, &attr) < 0)
+      goto fail;
+   xsk->progfd = ecx_xsk_loadprog(xsk->mapfd);
+   if (xsk->progfd < 0)
+      goto fail;
+   /* attach in driver mode, fall back to generic mode */
+   memset(&attr, 0, sizeof(attr));
+   attr.link_create.prog_fd = xsk->progfd;
+   attr.link_create.target_ifindex = ifindex;
+   attr.link_create.attach_type = BPF_XDP;
+   attr.link_create.flags = XDP_FLAGS_DRV_MODE;
+   xsk->linkfd = ecx_bpf(BPF_LINK_CREATE, &attr);
+   if (xsk->linkfd < 0)
+   {
+      attr.link_create.flags = XDP_FLAGS_SKB_MODE;
+      xsk->linkfd = ecx_bpf(BPF_LINK_CREATE, &attr);
+   }
+   if (xsk->linkfd < 0)
+      goto fail;
+
+   return 1;
 
+fail:
+   ecx_xsk_close(xsk);
    return 0;
 }
 
-/** Fill buffer with ethernet header structure.
- * Destination MAC is always broadcast.
- * Ethertype is always ETH_P_ECAT.
- * @param[out] p = buffer
+/** Copy frame into a free UMEM tx chunk and put it on the tx ring.
+ * The frame is not transmitted before the socket is kicked with sendto().
+ * @param[in] xsk    = AF_XDP socket administration
+ * @param[in] iov    = parts of frame to transmit
+ * @param[in] iovcnt = number of parts
+ * @return length of frame or -1 if no tx chunk is free
  */
-void ec_setupheader(void *p)
+static int ecx_xsk_queue(ec_xskt *xsk, const struct iovec *iov, int iovcnt)
 {
-   ec_etherheadert *bp;
-   bp = p;
-   bp->da0 = htons(0xffff);
-   bp->da1 = htons(0xffff);
-   bp->da2 = htons(0xffff);
-   bp->sa0 = htons(priMAC[0]);
-   bp->sa1 = htons(priMAC[1]);
-   bp->sa2 = htons(priMAC[2]);
-   bp->etype = htons(ETH_P_ECAT);
+   struct xdp_desc *desc;
+   uint64 *compp;
+   uint64 addr;
+   uint32 prod, cons;
+   int len;
+
+   /* reclaim chunks the kernel has finished transmitting */
+   compp = xsk->comp.ring;
+   cons = *xsk->comp.consumer;
+   while (cons != __atomic_load_n(xsk->comp.producer, __ATOMIC_ACQUIRE))
+   {
+      xsk->txfree[xsk->ntxfree++] = compp[cons & xsk->comp.mask];
+      cons++;
+   }
+   __atomic_store_n(xsk->comp.consumer, cons, __ATOMIC_RELEASE);
+   if (xsk->ntxfree == 0)
+   {
+      return -1;
+   }
+   addr = xsk->txfree[--xsk->ntxfree];
+   len = ecx_gather(xsk->umem + addr, iov, iovcnt);
+   prod = *xsk->tx.producer;
+   desc = (struct xdp_desc *)xsk->tx.ring + (prod & xsk->tx.mask);
+   desc->addr = addr;
+   desc->len = len;
+   desc->options = 0;
+   __atomic_store_n(xsk->tx.producer, prod + 1, __ATOMIC_RELEASE);
+
+   return len;
 }
 
-/** Get new frame identifier index and allocate corresponding rx buffer.
- * @param[in] port        = port context struct
- * @return new index.
+/** Submit queued io_uring requests and reap completions.
+ * @param[in] uring      = io_uring
+ * @param[in] mincomplete = number of completions to wait for
+ * @param[in] timeout    = max. time to wait in ns, only used with mincomplete
+ * @return io_uring_enter() result
  */
-uint8 ecx_getindex(ecx_portt *port)
+static int ecx_uring_enter(ec_uringt *uring, uint32 mincomplete, int64 timeout)
 {
-   uint8 idx;
-   uint8 cnt;
+   struct io_uring_getevents_arg arg;
+   struct __kernel_timespec ts;
+   uint32 tosubmit;
 
-   pthread_mutex_lock( &(port->getindex_mutex) );
+   tosubmit = *uring->sqtail - __atomic_load_n(uring->sqhead, __ATOMIC_ACQUIRE);
+   if (mincomplete == 0)
+   {
+      return (int)syscall(__NR_io_uring_enter, uring->fd, tosubmit, 0,
+         IORING_ENTER_GETEVENTS, NULL, 0);
+   }
+   memset(&arg, 0, sizeof(arg));
+   ts.tv_sec = timeout / 1000000000;
+   ts.tv_nsec = timeout % 1000000000;
+   arg.ts = (uint64)(uintptr_t)&ts;
 
-   idx = port->lastidx + 1;
-   /* index can't be larger than buffer array */
-   if (idx >= EC_MAXBUF)
+   return (int)syscall(__NR_io_uring_enter, uring->fd, tosubmit, mincomplete,
+      IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG, &arg, sizeof(arg));
+}
+
+/** Get free submission queue entry, submits queued requests when the queue
+ * is full. The entry is handed to the kernel with ecx_uring_commit().
+ * Caller must hold tx_mutex.
+ * @param[in] uring  = io_uring
+ * @return entry, NULL if queue is full
+ */
+static struct io_uring_sqe *ecx_uring_getsqe(ec_uringt *uring)
+{
+   struct io_uring_sqe *sqe;
+   uint32 tail;
+
+   tail = *uring->sqtail;
+   if (tail - __atomic_load_n(uring->sqhead, __ATOMIC_ACQUIRE) > uring->sqmask)
+   {
+      ecx_uring_enter(uring, 0, 0);
+      if (tail - __atomic_load_n(uring->sqhead, __ATOMIC_ACQUIRE) > uring->sqmask)
+      {
+         return NULL;
+      }
+   }
+   sqe = (struct io_uring_sqe *)uring->sqes + (tail & uring->sqmask);
+   memset(sqe, 0, sizeof(*sqe));
+
+   return sqe;
+}
+
+/** Queue entry taken with ecx_uring_getsqe() for the next submit.
+ * @param[in] uring  = io_uring
+ */
+static void ecx_uring_commit(ec_uringt *uring)
+{
+   __atomic_store_n(uring->sqtail, *uring->sqtail + 1, __ATOMIC_RELEASE);
+}
+
+/** Post a receive into a receive buffer of the io_uring. Caller must hold
+ * tx_mutex.
+ * @param[in] uring  = io_uring
+ * @param[in] slot   = receive buffer
+ */
+static void ecx_uring_postrecv(ec_uringt *uring, uint32 slot)
+{
+   struct io_uring_sqe *sqe;
+
+   sqe = ecx_uring_getsqe(uring);
+   if (sqe)
+   {
+      sqe->opcode = IORING_OP_RECV;
+      sqe->fd = uring->sock;
+      sqe->addr = (uint64)(uintptr_t)&(uring->rxslots[slot]);
+      sqe->len = sizeof(ec_bufT);
+      sqe->user_data = slot;
+      ecx_uring_commit(uring);
+   }
+}
+
+/** Queue send of a frame on the io_uring. The frame must stay unchanged until
+ * it is submitted. Caller must hold tx_mutex.
+ * @param[in] uring  = io_uring
+ * @param[in] iov    = frame to transmit, in a single part
+ * @param[in] iovcnt = number of parts
+ * @return length of frame if queued, -1 if queue is full
+ */
+static int ecx_uring_queue(ec_uringt *uring, const struct iovec *iov, int iovcnt)
+{
+   struct io_uring_sqe *sqe;
+
+   /* a send request takes a single buffer */
+   if (iovcnt != 1)
+   {
+      return -1;
+   }
+   sqe = ecx_uring_getsqe(uring);
+   if (!sqe)
+   {
+      return -1;
+   }
+   sqe->opcode = IORING_OP_SEND;
+   sqe->fd = uring->sock;
+   sqe->addr = (uint64)(uintptr_t)iov[0].iov_base;
+   sqe->len = iov[0].iov_len;
+   sqe->flags = uring->txflags;
+   sqe->user_data = EC_URINGTX;
+   ecx_uring_commit(uring);
+
+   return iov[0].iov_len;
+}
+
+/** Release io_uring, pending requests are cancelled.
+ * @param[in] uring  = io_uring
+ */
+static void ecx_uring_close(ec_uringt *uring)
+{
+   if (uring->fd >= 0)
+      close(uring->fd);
+   if (uring->sqes)
+      munmap(uring->sqes, uring->sqeslen);
+   if (uring->cqmap && (uring->cqmap != uring->sqmap))
+      munmap(uring->cqmap, uring->cqmaplen);
+   if (uring->sqmap)
+      munmap(uring->sqmap, uring->sqmaplen);
+   free(uring->rxslots);
+   memset(uring, 0, sizeof(*uring));
+   uring->fd = -1;
+}
+
+/** Create io_uring for a socket and post receives into all its receive
+ * buffers, so frames are received without a system call per frame.
+ * @param[in] uring  = io_uring
+ * @param[in] sock   = bound socket
+ * @param[in] nrx    = number of receive buffers
+ * @return >0 if succeeded
+ */
+static int ecx_uring_setup(ec_uringt *uring, int sock, uint32 nrx)
+{
+   struct io_uring_params p;
+   uint32 i;
+
+   memset(uring, 0, sizeof(*uring));
+   memset(&p, 0, sizeof(p));
+   uring->sock = sock;
+   /* room for all receives plus a send and a repost per frame */
+   uring->fd = (int)syscall(__NR_io_uring_setup, 4 * nrx, &p);
+   if (uring->fd < 0)
+   {
+      return 0;
+   }
+   uring->sqmaplen = p.sq_off.array + p.sq_entries * sizeof(uint32);
+   uring->cqmaplen = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+   if (p.features & IORING_FEAT_SINGLE_MMAP)
+   {
+      if (uring->cqmaplen > uring->sqmaplen)
+         uring->sqmaplen = uring->cqmaplen;
+      uring->cqmaplen = uring->sqmaplen;
+   }
+   uring->sqmap = mmap(NULL, uring->sqmaplen, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+      uring->fd, IORING_OFF_SQ_RING);
+   if (uring->sqmap == MAP_FAILED)
+   {
+      uring->sqmap = NULL;
+      ecx_uring_close(uring);
+      return 0;
+   }
+   uring->cqmap = uring->sqmap;
+   if (!(p.features & IORING_FEAT_SINGLE_MMAP))
+   {
+      uring->cqmap = mmap(NULL, uring->cqmaplen, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+         uring->fd, IORING_OFF_CQ_RING);
+      if (uring->cqmap == MAP_FAILED)
+      {
+         uring->cqmap = NULL;
+         ecx_uring_close(uring);
+         return 0;
+      }
+   }
+   uring->sqeslen = p.sq_entries * sizeof(struct io_uring_sqe);
+   uring->sqes = mmap(NULL, uring->sqeslen, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+      uring->fd, IORING_OFF_SQES);
+   if (uring->sqes == MAP_FAILED)
+   {
+      uring->sqes = NULL;
+      ecx_uring_close(uring);
+      return 0;
+   }
+   uring->sqhead = (uint32 *)(uring->sqmap + p.sq_off.head);
+   uring->sqtail = (uint32 *)(uring->sqmap + p.sq_off.tail);
+   uring->sqarray = (uint32 *)(uring->sqmap + p.sq_off.array);
+   uring->sqmask = *(uint32 *)(uring->sqmap + p.sq_off.ring_mask);
+   uring->cqhead = (uint32 *)(uring->cqmap + p.cq_off.head);
+   uring->cqtail = (uint32 *)(uring->cqmap + p.cq_off.tail);
+   uring->cqes = uring->cqmap + p.cq_off.cqes;
+   uring->cqmask = *(uint32 *)(uring->cqmap + p.cq_off.ring_mask);
+   /* submission queue entries are used in ring order */
+   for (i = 0; i < p.sq_entries; i++)
+   {
+      uring->sqarray[i] = i;
+   }
+   /* only failed sends need a completion */
+   if (p.features & IORING_FEAT_CQE_SKIP)
+   {
+      uring->txflags = IOSQE_CQE_SKIP_SUCCESS;
+   }
+   uring->nrx = nrx;
+   uring->rxslots = malloc(nrx * sizeof(ec_bufT));
+   if (!uring->rxslots)
+   {
+      ecx_uring_close(uring);
+      return 0;
+   }
+   for (i = 0; i < nrx; i++)
+   {
+      ecx_uring_postrecv(uring, i);
+   }
+   if (ecx_uring_enter(uring, 0, 0) < 0)
+   {
+      ecx_uring_close(uring);
+      return 0;
+   }
+
+   return 1;
+}
+
+/** Read next received frame from the completion queue of an io_uring. Failed
+ * receives are posted again, completions of failed sends are skipped. The
+ * receive buffer of the frame must be posted again with ecx_releasepkt().
+ * @param[in] port   = port context struct
+ * @param[in] uring  = io_uring
+ * @param[out] frame = received frame
+ * @return number of bytes received, 0 if none
+ */
+static int ecx_uring_recv(ecx_portt *port, ec_uringt *uring, uint8 **frame)
+{
+   struct io_uring_cqe *cqe;
+   uint32 head;
+   uint64 userdata;
+   int res, entered;
+
+   entered = FALSE;
+   for (;;)
+   {
+      head = *uring->cqhead;
+      if (head == __atomic_load_n(uring->cqtail, __ATOMIC_ACQUIRE))
+      {
+         /* completions of socket requests are posted when the kernel runs
+          * the task work of the ring, a waiting port leaves that to
+          * ecx_waitpkt() */
+         if (entered || (port->waitmode == ECT_WAIT_POLL))
+         {
+            return 0;
+         }
+         ecx_uring_enter(uring, 0, 0);
+         ecx_statadd(&(port->stats.rxcalls), 1);
+         entered = TRUE;
+         continue;
+      }
+      cqe = (struct io_uring_cqe *)uring->cqes + (head & uring->cqmask);
+      userdata = cqe->user_data;
+      res = cqe->res;
+      __atomic_store_n(uring->cqhead, head + 1, __ATOMIC_RELEASE);
+      if (userdata & EC_URINGTX)
+      {
+         continue;
+      }
+      if (res > 0)
+      {
+         uring->rxslot = (uint32)userdata;
+         *frame = uring->rxslots[uring->rxslot];
+         return res;
+      }
+      pthread_mutex_lock( &(port->tx_mutex) );
+      ecx_uring_postrecv(uring, (uint32)userdata);
+      pthread_mutex_unlock( &(port->tx_mutex) );
+   }
+}
+
+/** Enable kernel and NIC timestamps of a socket. Hardware timestamping of
+ * the NIC is switched on when the driver supports it, otherwise only software
+ * timestamps are taken.
+ * @param[in] sock      = socket to timestamp
+ * @param[in] ifname    = name of NIC the socket is bound to
+ * @param[in] transport = transport of the socket
+ * @return >0 if succeeded
+ */
+static int ecx_ts_setup(int sock, const char *ifname, int transport)
+{
+   struct ifreq ifr;
+   struct hwtstamp_config hwc;
+   int flags;
+
+   memset(&ifr, 0, sizeof(ifr));
+   memset(&hwc, 0, sizeof(hwc));
+   strncpy(ifr.ifr_name, ifname, IFNAMSIZ - 1);
+   hwc.tx_type = HWTSTAMP_TX_ON;
+   hwc.rx_filter = HWTSTAMP_FILTER_ALL;
+   ifr.ifr_data = (void *)&hwc;
+   /* fails on NICs without hardware timestamps, software ones still work */
+   ioctl(sock, SIOCSHWTSTAMP, &ifr);
+   flags = SOF_TIMESTAMPING_TX_SOFTWARE | SOF_TIMESTAMPING_RX_SOFTWARE |
+           SOF_TIMESTAMPING_SOFTWARE |
+           SOF_TIMESTAMPING_TX_HARDWARE | SOF_TIMESTAMPING_RX_HARDWARE |
+           SOF_TIMESTAMPING_RAW_HARDWARE;
+   if (setsockopt(sock, SOL_SOCKET, SO_TIMESTAMPING, &flags, sizeof(flags)) < 0)
+   {
+      return 0;
+   }
+   if (transport == ECT_TRANSPORT_MMAP)
+   {
+      /* put hardware rx timestamps in the ring slots when available */
+      flags = SOF_TIMESTAMPING_RAW_HARDWARE;
+      setsockopt(sock, SOL_PACKET, PACKET_TIMESTAMP, &flags, sizeof(flags));
+   }
+
+   return 1;
+}
+
+/** Get software and hardware timestamp from the control messages of a
+ * received message.
+ * @param[in] msg  = message with control buffer
+ * @param[out] sw  = software timestamp in ns, 0 if none
+ * @param[out] hw  = hardware timestamp in ns, 0 if none
+ */
+static void ecx_ts_parse(struct msghdr *msg, int64 *sw, int64 *hw)
+{
+   struct cmsghdr *cmsg;
+   struct timespec ts[3];
+
+   *sw = 0;
+   *hw = 0;
+   for (cmsg = CMSG_FIRSTHDR(msg); cmsg; cmsg = CMSG_NXTHDR(msg, cmsg))
+   {
+      if ((cmsg->cmsg_level == SOL_SOCKET) && (cmsg->cmsg_type == SCM_TIMESTAMPING))
+      {
+         /* ts[0] is software, ts[2] raw hardware, ts[1] is unused */
+         memcpy(ts, CMSG_DATA(cmsg), sizeof(ts));
+         *sw = (int64)ts[0].tv_sec * 1000000000 + ts[0].tv_nsec;
+         *hw = (int64)ts[2].tv_sec * 1000000000 + ts[2].tv_nsec;
+      }
+   }
+}
+
+/** Read tx timestamps of transmitted frames from the error queue of a
+ * socket and store them with the index of the frame. The kernel loops back
+ * a copy of the frame with each timestamp, which carries the index.
+ * @param[in] port   = port context struct
+ * @param[in] stack  = stack of socket to read
+ */
+static void ecx_ts_readtx(ecx_portt *port, ec_stackT *stack)
+{
+   struct msghdr msg;
+   struct iovec iov;
+   ec_bufT frame;
+   char ctl[EC_TSCTLSIZE * 2];
+   ec_comt *ecp;
+   int64 sw, hw;
+   int i, n;
+
+   if (!port->timestamps || (*stack->transport == ECT_TRANSPORT_XDP))
+   {
+      return;
+   }
+   for (i = 0; i < EC_TSMAXREAD; i++)
+   {
+      memset(&msg, 0, sizeof(msg));
+      iov.iov_base = frame;
+      iov.iov_len = sizeof(frame);
+      msg.msg_iov = &iov;
+      msg.msg_iovlen = 1;
+      msg.msg_control = ctl;
+      msg.msg_controllen = sizeof(ctl);
+      n = recvmsg(*stack->sock, &msg, MSG_ERRQUEUE | MSG_DONTWAIT);
+      if (n <= 0)
+      {
+         break;
+      }
+      if (n < (int)(ETH_HEADERSIZE + sizeof(ec_comt)))
+      {
+         continue;
+      }
+      ecp = (ec_comt *)&frame[ETH_HEADERSIZE];
+      if (ecp->index < port->maxbuf)
+      {
+         ecx_ts_parse(&msg, &sw, &hw);
+         if (sw)
+         {
+            stack->frametime[ecp->index].txsw = sw;
+         }
+         if (hw)
+         {
+            stack->frametime[ecp->index].txhw = hw;
+         }
+      }
+   }
+}
+
+/** Attach the launch time of the port to a message to transmit.
+ * @param[in] port   = port context struct
+ * @param[in] msg    = message to transmit
+ * @param[in] ctl    = control buffer of EC_TXTIMECTLSIZE
+ */
+static void ecx_txtime_cmsg(ecx_portt *port, struct msghdr *msg, uint64 *ctl)
+{
+   struct cmsghdr *cmsg;
+   uint64 txtime;
+
+   txtime = port->launchtime;
+   msg->msg_control = ctl;
+   msg->msg_controllen = EC_TXTIMECTLSIZE * sizeof(uint64);
+   cmsg = CMSG_FIRSTHDR(msg);
+   cmsg->cmsg_level = SOL_SOCKET;
+   cmsg->cmsg_type = SCM_TXTIME;
+   cmsg->cmsg_len = CMSG_LEN(sizeof(txtime));
+   memcpy(CMSG_DATA(cmsg), &txtime, sizeof(txtime));
+}
+
+/** Load eBPF socket filter that passes EtherCAT frames returning from the
+ * slaves to the master. Returning frames have the source MAC of the master
+ * with the locally administered bit set by the slaves, our own and foreign
+ * frames are dropped and counted.
+ * @param[in] mapfd  = array map holding the drop counter
+ * @return program fd, -1 if failed
+ */
+static int ecx_rxfilter_loadprog(int mapfd)
+{
+   struct bpf_insn prog[] =
+   {
+      /* ctx in r6 for the packet loads */
+      { BPF_ALU64 | BPF_MOV | BPF_X, 6, 1, 0, 0 },
+      /* drop frames that are not EtherCAT */
+      { BPF_LD | BPF_ABS | BPF_H, 0, 0, 0, 12 },
+      { BPF_JMP | BPF_JNE | BPF_K, 0, 0, 6, ETH_P_ECAT },
+      /* drop frames not modified by a slave */
+      { BPF_LD | BPF_ABS | BPF_B, 0, 0, 0, 6 },
+      { BPF_ALU64 | BPF_AND | BPF_K, 0, 0, 0, 0x02 },
+      { BPF_JMP | BPF_JEQ | BPF_K, 0, 0, 3, 0 },
+      /* pass frames with source MAC word 1 of primary or secondary */
+      { BPF_LD | BPF_ABS | BPF_H, 0, 0, 0, 8 },
+      { BPF_JMP | BPF_JEQ | BPF_K, 0, 0, 12, RX_PRIM },
+      { BPF_JMP | BPF_JEQ | BPF_K, 0, 0, 11, RX_SEC },
+      /* count dropped frame in map[0] */
+      { BPF_ST | BPF_MEM | BPF_W, 10, 0, -4, 0 },
+      { BPF_ALU64 | BPF_MOV | BPF_X, 2, 10, 0, 0 },
+      { BPF_ALU64 | BPF_ADD | BPF_K, 2, 0, 0, -4 },
+      { BPF_LD | BPF_IMM | BPF_DW, 1, BPF_PSEUDO_MAP_FD, 0, mapfd },
+      { 0, 0, 0, 0, 0 },
+      { BPF_JMP | BPF_CALL, 0, 0, 0, BPF_FUNC_map_lookup_elem },
+      { BPF_JMP | BPF_JEQ | BPF_K, 0, 0, 2, 0 },
+      { BPF_ALU64 | BPF_MOV | BPF_K, 1, 0, 0, 1 },
+      { BPF_STX | BPF_ATOMIC | BPF_DW, 0, 1, 0, BPF_ADD },
+      { BPF_ALU64 | BPF_MOV | BPF_K, 0, 0, 0, 0 },
+      { BPF_JMP | BPF_EXIT, 0, 0, 0, 0 },
+      /* pass whole frame */
+      { BPF_ALU64 | BPF_MOV | BPF_K, 0, 0, 0, 0xffff },
+      { BPF_JMP | BPF_EXIT, 0, 0, 0, 0 }
+   };
+   union bpf_attr attr;
+
+   memset(&attr, 0, sizeof(attr));
+   attr.prog_type = BPF_PROG_TYPE_SOCKET_FILTER;
+   attr.insns = (uint64)(uintptr_t)prog;
+   attr.insn_cnt = sizeof(prog) / sizeof(prog[0]);
+   attr.license = (uint64)(uintptr_t)"GPL";
+
+   return ecx_bpf(BPF_PROG_LOAD, &attr);
+}
+
+/** Attach rx filter to a socket, so the kernel drops frames that are not
+ * returning from the slaves before they wake up the master. The eBPF filter
+ * counts the dropped frames. If eBPF is not permitted nothing is attached and
+ * the caller filters in user space with ecx_rxsoftfilter(), a classic BPF
+ * filter could not count its drops.
+ * @param[in] sock    = socket to filter
+ * @param[out] mapfd  = drop counter map, -1 if not attached
+ * @return >0 if succeeded
+ */
+static int ecx_rxfilter_setup(int sock, int *mapfd)
+{
+   union bpf_attr attr;
+   int progfd, r;
+
+   memset(&attr, 0, sizeof(attr));
+   attr.map_type = BPF_MAP_TYPE_ARRAY;
+   attr.key_size = sizeof(uint32);
+   attr.value_size = sizeof(uint64);
+   attr.max_entries = 1;
+   *mapfd = ecx_bpf(BPF_MAP_CREATE, &attr);
+   if (*mapfd >= 0)
+   {
+      progfd = ecx_rxfilter_loadprog(*mapfd);
+      r = -1;
+      if (progfd >= 0)
+      {
+         r = setsockopt(sock, SOL_SOCKET, SO_ATTACH_BPF, &progfd, sizeof(progfd));
+         /* the socket holds a reference to the program */
+         close(progfd);
+      }
+      if (r == 0)
+      {
+         return 1;
+      }
+      close(*mapfd);
+      *mapfd = -1;
+   }
+
+   return 0;
+}
+
+/** Rx filter in user space, used when the eBPF filter could not be attached.
+ * Same rule as ecx_rxfilter_loadprog(), dropped frames are counted in the
+ * port statistics.
+ * @param[in] port   = port context struct
+ * @param[in] frame  = received EtherCAT frame including ethernet header
+ * @return TRUE if the frame returns from the slaves
+ */
+static int ecx_rxsoftfilter(ecx_portt *port, const uint8 *frame)
+{
+   ec_etherheadert *ehp;
+
+   ehp = (ec_etherheadert *)frame;
+   if ((frame[6] & 0x02) &&
+       ((ntohs(ehp->sa1) == RX_PRIM) || (ntohs(ehp->sa1) == RX_SEC)))
+   {
+      return TRUE;
+   }
+   ecx_statadd(&(port->stats.rxfilterdrops), 1);
+
+   return FALSE;
+}
+
+/** Transmit one frame gathered from parts on a socket. Caller must hold
+ * tx_mutex.
+ * @param[in] port   = port context struct
+ * @param[in] stack  = stack of socket to use
+ * @param[in] iov    = parts of frame to transmit
+ * @param[in] iovcnt = number of parts
+ * @return socket send result
+ */
+static int ecx_sendpktv(ecx_portt *port, ec_stackT *stack, const struct iovec *iov, int iovcnt)
+{
+   int rval;
+   struct msghdr msg;
+   uint64 ctl[EC_TXTIMECTLSIZE];
+
+   if (*stack->transport == ECT_TRANSPORT_MMAP)
+   {
+      rval = ecx_ring_queue(stack->ring, iov, iovcnt);
+      /* kick kernel to transmit queued ring slots */
+      if ((rval > 0) && (send(*stack->sock, NULL, 0, MSG_DONTWAIT) < 0))
+      {
+         rval = -1;
+      }
+   }
+   else if (*stack->transport == ECT_TRANSPORT_XDP)
+   {
+      rval = ecx_xsk_queue(stack->xsk, iov, iovcnt);
+      /* kick kernel to transmit queued descriptors, a busy ring is retried later */
+      if (rval > 0)
+      {
+         sendto(stack->xsk->fd, NULL, 0, MSG_DONTWAIT, NULL, 0);
+      }
+   }
+   else if (*stack->transport == ECT_TRANSPORT_URING)
+   {
+      rval = ecx_uring_queue(stack->uring, iov, iovcnt);
+      if ((rval > 0) && (ecx_uring_enter(stack->uring, 0, 0) < 0))
+      {
+         rval = -1;
+      }
+   }
+   else
+   {
+      memset(&msg, 0, sizeof(msg));
+      msg.msg_iov = (struct iovec *)iov;
+      msg.msg_iovlen = iovcnt;
+      if (port->txtime && port->launchtime)
+      {
+         ecx_txtime_cmsg(port, &msg, ctl);
+      }
+      rval = sendmsg(*stack->sock, &msg, 0);
+   }
+   ecx_statadd(&(port->stats.txcalls), 1);
+   if (rval > 0)
+   {
+      ecx_statadd(&(port->stats.txframes), 1);
+   }
+
+   return rval;
+}
+
+/** Transmit one frame on a socket. Caller must hold tx_mutex.
+ * @param[in] port   = port context struct
+ * @param[in] stack  = stack of socket to use
+ * @param[in] frame  = frame to transmit
+ * @param[in] len    = length of frame in bytes
+ * @return socket send result
+ */
+static int ecx_sendpkt(ecx_portt *port, ec_stackT *stack, const void *frame, int len)
+{
+   struct iovec iov;
+
+   iov.iov_base = (void *)frame;
+   iov.iov_len = len;
+
+   return ecx_sendpktv(port, stack, &iov, 1);
+}
+
+/** Transmit all frames of a queue on a socket. With packet rings, AF_XDP
+ * or io_uring the kernel is kicked, which also transmits frames other
+ * threads have put on the ring. Caller must hold tx_mutex.
+ * @param[in] port    = port context struct
+ * @param[in] stack   = stack of socket to use
+ * @param[in] txqueue = frames queued for the socket
+ * @return number of frames transmitted
+ */
+static int ecx_flushpkt(ecx_portt *port, ec_stackT *stack, ec_txqueuet *txqueue)
+{
+   struct mmsghdr msg[EC_MAXBUF];
+   uint64 ctl[EC_TXTIMECTLSIZE];
+   int i, r, sent;
+
+   if (txqueue->count == 0)
+   {
+      return 0;
+   }
+   sent = 0;
+   if (*stack->transport == ECT_TRANSPORT_MMAP)
+   {
+      if (send(*stack->sock, NULL, 0, MSG_DONTWAIT) >= 0)
+      {
+         sent = txqueue->count;
+      }
+      ecx_statadd(&(port->stats.txcalls), 1);
+   }
+   else if (*stack->transport == ECT_TRANSPORT_XDP)
+   {
+      /* a busy ring is retried on the next kick */
+      sendto(stack->xsk->fd, NULL, 0, MSG_DONTWAIT, NULL, 0);
+      sent = txqueue->count;
+      ecx_statadd(&(port->stats.txcalls), 1);
+   }
+   else if (*stack->transport == ECT_TRANSPORT_URING)
+   {
+      sent = txqueue->count;
+      /* submit at once, the frames must not wait for the next receive */
+      if (ecx_uring_enter(stack->uring, 0, 0) < 0)
+      {
+         sent = 0;
+      }
+      ecx_statadd(&(port->stats.txcalls), 1);
+   }
+   else
+   {
+      memset(msg, 0, txqueue->count * sizeof(struct mmsghdr));
+      for (i = 0; i < txqueue->count; i++)
+      {
+         msg[i].msg_hdr.msg_iov = txqueue->iov[i];
+         msg[i].msg_hdr.msg_iovlen = txqueue->iovcnt[i];
+         /* all frames of a batch share the launch time */
+         if (port->txtime && port->launchtime)
+         {
+            ecx_txtime_cmsg(port, &msg[i].msg_hdr, ctl);
+         }
+      }
+      while (sent < txqueue->count)
+      {
+         r = sendmmsg(*stack->sock, &msg[sent], txqueue->count - sent, 0);
+         ecx_statadd(&(port->stats.txcalls), 1);
+         if (r <= 0)
+         {
+            break;
+         }
+         sent += r;
+      }
+   }
+   /* frames that are not transmitted will not return */
+   for (i = sent; i < txqueue->count; i++)
+   {
+      ecx_storebufstat(&stack->rxbufstat[txqueue->idx[i]], EC_BUF_EMPTY);
+   }
+   ecx_statadd(&(port->stats.txframes), sent);
+   ecx_statadd(&(port->stats.txflushes), 1);
+   ecx_statadd(&(port->stats.txflushframes), sent);
+   txqueue->count = 0;
+
+   return sent;
+}
+
+/** Queue one frame for transmit by ecx_txbatch_flush(). With packet rings or
+ * AF_XDP the frame is put on the tx ring right away and only the kick of the
+ * kernel is deferred. Caller must hold tx_mutex.
+ * @param[in] port    = port context struct
+ * @param[in] stack   = stack of socket to use
+ * @param[in] txqueue = frames queued for the socket
+ * @param[in] iov     = parts of frame to transmit, must stay valid until flushed
+ * @param[in] iovcnt  = number of parts
+ * @param[in] idx     = index in tx buffer array
+ * @return length of frame or -1 on failure
+ */
+static int ecx_queuepktv(ecx_portt *port, ec_stackT *stack, ec_txqueuet *txqueue,
+   const struct iovec *iov, int iovcnt, uint8 idx)
+{
+   int i, rval;
+
+   /* queue full, transmit what is queued so far */
+   if (txqueue->count >= EC_MAXBUF)
+   {
+      ecx_flushpkt(port, stack, txqueue);
+   }
+   if (*stack->transport == ECT_TRANSPORT_MMAP)
+   {
+      rval = ecx_ring_queue(stack->ring, iov, iovcnt);
+   }
+   else if (*stack->transport == ECT_TRANSPORT_XDP)
+   {
+      rval = ecx_xsk_queue(stack->xsk, iov, iovcnt);
+   }
+   else if (*stack->transport == ECT_TRANSPORT_URING)
+   {
+      rval = ecx_uring_queue(stack->uring, iov, iovcnt);
+   }
+   else
+   {
+      rval = 0;
+      for (i = 0; i < iovcnt; i++)
+      {
+         txqueue->iov[txqueue->count][i] = iov[i];
+         rval += iov[i].iov_len;
+      }
+      txqueue->iovcnt[txqueue->count] = iovcnt;
+   }
+   if (rval > 0)
+   {
+      txqueue->idx[txqueue->count++] = idx;
+   }
+
+   return rval;
+}
+
+/** Queue one frame for transmit by ecx_txbatch_flush(). Caller must hold
+ * tx_mutex.
+ * @param[in] port    = port context struct
+ * @param[in] stack   = stack of socket to use
+ * @param[in] txqueue = frames queued for the socket
+ * @param[in] frame   = frame to transmit, must stay valid until flushed
+ * @param[in] len     = length of frame in bytes
+ * @param[in] idx     = index in tx buffer array
+ * @return length of frame or -1 on failure
+ */
+static int ecx_queuepkt(ecx_portt *port, ec_stackT *stack, ec_txqueuet *txqueue, void *frame, int len,
+   uint8 idx)
+{
+   struct iovec iov;
+
+   iov.iov_base = frame;
+   iov.iov_len = len;
+
+   return ecx_queuepktv(port, stack, txqueue, &iov, 1, idx);
+}
+
+/** Find the open batch of the calling thread. Caller must hold tx_mutex.
+ * @param[in] port        = port context struct
+ * @return batch, NULL if the thread has none open
+ */
+static ec_txbatcht *ecx_txbatch_find(ecx_portt *port)
+{
+   pthread_t self;
+   int i;
+
+   self = pthread_self();
+   for (i = 0; i < EC_TXBATCHES; i++)
+   {
+      if (port->txbatch[i].open && pthread_equal(port->txbatch[i].owner, self))
+      {
+         return &(port->txbatch[i]);
+      }
+   }
+
+   return NULL;
+}
+
+/** Basic setup to connect NIC to socket.
+ * The port may live anywhere, the pointers are set up here and released by
+ * ecx_closenic(). The settings port->maxbuf, port->timestamps and
+ * port->rxfilteroff, and port->redport for the secondary, are read from the
+ * port and must be set or zeroed by the caller first, f.e. with memset() on
+ * a port on the stack.
+ * @param[in] port        = port context struct
+ * @param[in] ifname      = Name of NIC device, f.e. "eth0", optionally prefixed
+ *                          with the transport, f.e. "mmap:eth0"
+ * @param[in] secondary   = if >0 then use secondary stack instead of primary
+ * @return >0 if succeeded
+ */
+int ecx_setupnic(ecx_portt *port, const char *ifname, int secondary)
+{
+   int i;
+   int r, rval, ifindex;
+   struct timeval timeout;
+   struct ifreq ifr;
+   struct sockaddr_ll sll;
+   int *psock;
+   int *ptransport;
+   int *prxfiltermap;
+   int *prxsoftfilter;
+   ec_ringt *pring;
+   ec_xskt *pxsk;
+   ec_uringt *puring;
+   pthread_mutexattr_t mutexattr;
+
+   rval = 0;
+   if (secondary)
+   {
+      /* secondary port struct available? */
+      if (port->redport)
+      {
+         /* when using secondary socket it is automatically a redundant setup */
+         psock = &(port->redport->sockhandle);
+         *psock = -1;
+         ptransport = &(port->redport->transport);
+         prxfiltermap = &(port->redport->rxfiltermap);
+         prxsoftfilter = &(port->redport->rxsoftfilter);
+         pring = &(port->redport->ring);
+         pxsk = &(port->redport->xsk);
+         puring = &(port->redport->uring);
+         port->redstate                   = ECT_RED_DOUBLE;
+         port->redport->stack.sock        = &(port->redport->sockhandle);
+         port->redport->stack.transport   = &(port->redport->transport);
+         port->redport->stack.ring        = &(port->redport->ring);
+         port->redport->stack.xsk         = &(port->redport->xsk);
+         port->redport->stack.uring       = &(port->redport->uring);
+         port->redport->stack.rxsoftfilter = &(port->redport->rxsoftfilter);
+         /* secondary has the same frame indexes as primary */
+         if (!ecx_rxpool_setup(&(port->redport->rxpool), port->maxbuf, &(port->redport->rxbuf),
+                &(port->redport->rxbufstat), &(port->redport->rxsa), &(port->redport->frametime)))
+         {
+            return 0;
+         }
+         port->redport->stack.txbuf       = port->txbuf;
+         port->redport->stack.txbuflength = port->txbuflength;
+         port->redport->stack.tempbuf     = &(port->redport->tempinbuf);
+         port->redport->stack.rxbuf       = port->redport->rxbuf;
+         port->redport->stack.rxbufstat   = port->redport->rxbufstat;
+         port->redport->stack.rxsa        = port->redport->rxsa;
+         port->redport->stack.frametime   = port->redport->frametime;
+         ecx_clear_rxbufstat(port->redport->rxbufstat, port->maxbuf);
+      }
+      else
+      {
+         /* fail */
+         return 0;
+      }
+   }
+   else
+   {
+      if (port->maxbuf <= 0)
+      {
+         port->maxbuf = EC_MAXBUF;
+      }
+      if (port->maxbuf > EC_MAXBUFPOOL)
+      {
+         port->maxbuf = EC_MAXBUFPOOL;
+      }
+      port->rxdrainbuf = NULL;
+      if (!ecx_txpool_setup(port) ||
+          !ecx_rxpool_setup(&(port->rxpool), port->maxbuf, &(port->rxbuf), &(port->rxbufstat),
+             &(port->rxsa), &(port->frametime)))
+      {
+         ecx_txpool_free(port);
+         return 0;
+      }
+      pthread_mutexattr_init(&mutexattr);
+      pthread_mutexattr_setprotocol(&mutexattr  , PTHREAD_PRIO_INHERIT);
+      pthread_mutex_init(&(port->tx_mutex)      , &mutexattr);
+      pthread_mutex_init(&(port->rx_mutex)      , &mutexattr);
+      port->sockhandle        = -1;
+      port->lastidx           = 0;
+      port->redstate          = ECT_RED_NONE;
+      port->stack.sock        = &(port->sockhandle);
+      port->stack.transport   = &(port->transport);
+      port->stack.ring        = &(port->ring);
+      port->stack.xsk         = &(port->xsk);
+      port->stack.uring       = &(port->uring);
+      port->stack.rxsoftfilter = &(port->rxsoftfilter);
+      port->txgather          = FALSE;
+      port->rxscatter         = FALSE;
+      port->txtime            = FALSE;
+      port->launchtime        = 0;
+      port->rxdrain           = FALSE;
+      port->waitmode          = ECT_WAIT_SPIN;
+      port->rxthread          = FALSE;
+      port->stack.txbuf       = port->txbuf;
+      port->stack.txbuflength = port->txbuflength;
+      port->stack.tempbuf     = &(port->tempinbuf);
+      port->stack.rxbuf       = port->rxbuf;
+      port->stack.rxbufstat   = port->rxbufstat;
+      port->stack.rxsa        = port->rxsa;
+      port->stack.frametime   = port->frametime;
+      ecx_clear_rxbufstat(port->rxbufstat, port->maxbuf);
+      memset(&(port->stats), 0, sizeof(port->stats));
+      psock = &(port->sockhandle);
+      ptransport = &(port->transport);
+      prxfiltermap = &(port->rxfiltermap);
+      prxsoftfilter = &(port->rxsoftfilter);
+      pring = &(port->ring);
+      pxsk = &(port->xsk);
+      puring = &(port->uring);
+   }
+   ifname = ecx_parse_ifname(ifname, ptransport);
+   memset(pring, 0, sizeof(*pring));
+   /* we use RAW packet socket, with packet type ETH_P_ECAT */
+   *psock = socket(PF_PACKET, SOCK_RAW, htons(ETH_P_ECAT));
+
+   timeout.tv_sec =  0;
+   timeout.tv_usec = 1;
+   r = setsockopt(*psock, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+   r = setsockopt(*psock, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+   i = 1;
+   r = setsockopt(*psock, SOL_SOCKET, SO_DONTROUTE, &i, sizeof(i));
+   /* connect socket to NIC by name */
+   strcpy(ifr.ifr_name, ifname);
+   r = ioctl(*psock, SIOCGIFINDEX, &ifr);
+   ifindex = ifr.ifr_ifindex;
+   strcpy(ifr.ifr_name, ifname);
+   ifr.ifr_flags = 0;
+   /* reset flags of NIC interface */
+   r = ioctl(*psock, SIOCGIFFLAGS, &ifr);
+   /* set flags of NIC interface, here promiscuous and broadcast */
+   ifr.ifr_flags = ifr.ifr_flags | IFF_PROMISC | IFF_BROADCAST;
+   r = ioctl(*psock, SIOCSIFFLAGS, &ifr);
+   /* bind socket to protocol, in this case RAW EtherCAT */
+   sll.sll_family = AF_PACKET;
+   sll.sll_ifindex = ifindex;
+   sll.sll_protocol = htons(ETH_P_ECAT);
+   r = bind(*psock, (struct sockaddr *)&sll, sizeof(sll));
+   /* let the kernel drop frames that do not return from the slaves */
+   *prxfiltermap = -1;
+   *prxsoftfilter = FALSE;
+   if ((r == 0) && !port->rxfilteroff)
+   {
+      *prxsoftfilter = !ecx_rxfilter_setup(*psock, prxfiltermap);
+   }
+   /* map rx and tx rings, fall back to plain socket if not possible */
+   if ((r == 0) && (*ptransport == ECT_TRANSPORT_MMAP) &&
+       !ecx_ring_setup(*psock, pring, ecx_ringsize(port->maxbuf, EC_RINGFRAMES)))
+   {
+      ecx_ring_close(pring);
+      *ptransport = ECT_TRANSPORT_SOCKET;
+   }
+   /* attach XDP program and AF_XDP socket, fall back to plain socket if not possible */
+   if ((r == 0) && (*ptransport == ECT_TRANSPORT_XDP) &&
+       !ecx_xsk_setup(pxsk, ifindex, ecx_ringsize(port->maxbuf, EC_XSKFRAMES)))
+   {
+      *ptransport = ECT_TRANSPORT_SOCKET;
+   }
+   /* create io_uring with pre-posted receives, fall back to plain socket if not possible */
+   if ((r == 0) && (*ptransport == ECT_TRANSPORT_URING) &&
+       !ecx_uring_setup(puring, *psock, EC_URINGRXFRAMES))
+   {
+      *ptransport = ECT_TRANSPORT_SOCKET;
+   }
+   /* AF_XDP frames bypass the kernel stack and are not timestamped */
+   if ((r == 0) && port->timestamps && (*ptransport != ECT_TRANSPORT_XDP))
+   {
+      ecx_ts_setup(*psock, ifname, *ptransport);
+   }
+   port->rxtssw = 0;
+   port->rxtshw = 0;
+   /* setup ethernet headers in tx buffers so we don't have to repeat it */
+   for (i = 0; i < port->maxbuf; i++)
+   {
+      ec_setupheader(&(port->txbuf[i]));
+      port->rxbufstat[i] = EC_BUF_EMPTY;
+   }
+   ec_setupheader(&(port->txbuf2));
+   if (r == 0) rval = 1;
+
+   return rval;
+}
+
+/** Close sockets used
+ * @param[in] port        = port context struct
+ * @return 0
+ */
+int ecx_closenic(ecx_portt *port)
+{
+   ecx_stoprxthread(port);
+   ecx_ring_close(&(port->ring));
+   if (port->transport == ECT_TRANSPORT_XDP)
+      ecx_xsk_close(&(port->xsk));
+   if (port->transport == ECT_TRANSPORT_URING)
+      ecx_uring_close(&(port->uring));
+   if (port->sockhandle >= 0)
+      close(port->sockhandle);
+   if (port->rxfiltermap >= 0)
+      close(port->rxfiltermap);
+   if (port->redport)
+      ecx_ring_close(&(port->redport->ring));
+   if ((port->redport) && (port->redport->transport == ECT_TRANSPORT_XDP))
+      ecx_xsk_close(&(port->redport->xsk));
+   if ((port->redport) && (port->redport->transport == ECT_TRANSPORT_URING))
+      ecx_uring_close(&(port->redport->uring));
+   if ((port->redport) && (port->redport->sockhandle >= 0))
+      close(port->redport->sockhandle);
+   if ((port->redport) && (port->redport->rxfiltermap >= 0))
+      close(port->redport->rxfiltermap);
+   /* release allocated frame pool */
+   if (port->redport)
+      ecx_rxpool_free(&(port->redport->rxpool), &(port->redport->rxbuf),
+         &(port->redport->rxbufstat), &(port->redport->rxsa), &(port->redport->frametime));
+   ecx_rxpool_free(&(port->rxpool), &(port->rxbuf), &(port->rxbufstat), &(port->rxsa),
+      &(port->frametime));
+   ecx_txpool_free(port);
+   free(port->rxdrainbuf);
+   port->rxdrainbuf = NULL;
+
+   return 0;
+}
+
+/** Fill buffer with ethernet header structure.
+ * Destination MAC is always broadcast.
+ * Ethertype is always ETH_P_ECAT.
+ * @param[out] p = buffer
+ */
+void ec_setupheader(void *p)
+{
+   ec_etherheadert *bp;
+   bp = p;
+   bp->da0 = htons(0xffff);
+   bp->da1 = htons(0xffff);
+   bp->da2 = htons(0xffff);
+   bp->sa0 = htons(priMAC[0]);
+   bp->sa1 = htons(priMAC[1]);
+   bp->sa2 = htons(priMAC[2]);
+   bp->etype = htons(ETH_P_ECAT);
+}
+
+/** Get new frame identifier index and allocate corresponding rx buffer.
+ * Lock free, an index is claimed by a compare and swap of its rx buffer
+ * status from EC_BUF_EMPTY to EC_BUF_ALLOC, so concurrent callers never get
+ * the same index. When no index is found in EC_GETINDEXPASSES passes over
+ * all indexes the pool is exhausted and no index is returned.
+ * @param[in] port        = port context struct
+ * @return new index, EC_NOINDEX if all indexes are in use
+ */
+uint8 ecx_getindex(ecx_portt *port)
+{
+   uint8 idx;
+   int cnt;
+   int expected;
+
+   idx = __atomic_load_n(&(port->lastidx), __ATOMIC_RELAXED) + 1;
+   /* index can't be larger than buffer array */
+   if (idx >= port->maxbuf)
+   {
+      idx = 0;
+   }
+   /* try to claim unused index, an index released behind the scan by another
+    * thread is found in the next pass */
+   for (cnt = 0; cnt < (EC_GETINDEXPASSES * port->maxbuf); cnt++)
+   {
+      expected = EC_BUF_EMPTY;
+      if (__atomic_compare_exchange_n(&(port->rxbufstat[idx]), &expected, EC_BUF_ALLOC,
+             FALSE, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED))
+      {
+         break;
+      }
+      idx++;
+      if (idx >= port->maxbuf)
+      {
+         idx = 0;
+      }
+   }
+   if (cnt == (EC_GETINDEXPASSES * port->maxbuf))
+   {
+      return EC_NOINDEX;
+   }
+   if (port->redstate != ECT_RED_NONE)
+      ecx_storebufstat(&(port->redport->rxbufstat[idx]), EC_BUF_ALLOC);
+   __atomic_store_n(&(port->lastidx), idx, __ATOMIC_RELAXED);
+
+   return idx;
+}
+
+/** Set rx buffer status.
+ * @param[in] port        = port context struct
+ * @param[in] idx      = index in buffer array
+ * @param[in] bufstat  = status to set
+ */
+void ecx_setbufstat(ecx_portt *port, uint8 idx, int bufstat)
+{
+   /* a released buffer no longer receives into the destination of its owner */
+   if ((bufstat == EC_BUF_EMPTY) && port->rxdest[idx].data)
+   {
+      pthread_mutex_lock( &(port->rx_mutex) );
+      port->rxdest[idx].data = NULL;
+      pthread_mutex_unlock( &(port->rx_mutex) );
+   }
+   ecx_storebufstat(&(port->rxbufstat[idx]), bufstat);
+   if (port->redstate != ECT_RED_NONE)
+      ecx_storebufstat(&(port->redport->rxbufstat[idx]), bufstat);
+}
+
+/** Transmit buffer over socket (non blocking).
+ * @param[in] port        = port context struct
+ * @param[in] idx         = index in tx buffer array
+ * @param[in] stacknumber  = 0=Primary 1=Secondary stack
+ * @return socket send result
+ */
+int ecx_outframe(ecx_portt *port, uint8 idx, int stacknumber)
+{
+   int lp, rval;
+   ec_stackT *stack;
+   ec_txbatcht *batch;
+
+   if (!stacknumber)
+   {
+      stack = &(port->stack);
+   }
+   else
+   {
+      stack = &(port->redport->stack);
+   }
+   lp = stack->txbuflength[idx];
+   memset(&stack->frametime[idx], 0, sizeof(ec_frametimet));
+   ecx_storebufstat(&stack->rxbufstat[idx], EC_BUF_TX);
+   pthread_mutex_lock( &(port->tx_mutex) );
+   batch = ecx_txbatch_find(port);
+   if (batch)
+   {
+      rval = ecx_queuepkt(port, stack, stacknumber ? &(batch->redqueue) : &(batch->txqueue),
+         stack->txbuf[idx], lp, idx);
+   }
+   else
+   {
+      rval = ecx_sendpkt(port, stack, stack->txbuf[idx], lp);
+   }
+   pthread_mutex_unlock( &(port->tx_mutex) );
+   if (rval == -1)
+   {
+      ecx_storebufstat(&stack->rxbufstat[idx], EC_BUF_EMPTY);
+   }
+
+   return rval;
+}
+
+/** Transmit buffer over socket (non blocking).
+ * @param[in] port        = port context struct
+ * @param[in] idx = index in tx buffer array
+ * @return socket send result
+ */
+int ecx_outframe_red(ecx_portt *port, uint8 idx)
+{
+   ec_comt *datagramP;
+   ec_etherheadert *ehp;
+   ec_txbatcht *batch;
+   uint8 *dummy;
+   int rval, rval2;
+
+   ehp = (ec_etherheadert *)&(port->txbuf[idx]);
+   /* rewrite MAC source address 1 to primary */
+   ehp->sa1 = htons(priMAC[1]);
+   /* transmit over primary socket*/
+   rval = ecx_outframe(port, idx, 0);
+   if (port->redstate != ECT_RED_NONE)
+   {
+      pthread_mutex_lock( &(port->tx_mutex) );
+      ehp = (ec_etherheadert *)&(port->txbuf2);
+      /* use dummy frame for secondary socket transmit (BRD) */
+      datagramP = (ec_comt*)&(port->txbuf2[ETH_HEADERSIZE]);
+      /* write index to frame */
+      datagramP->index = idx;
+      /* rewrite MAC source address 1 to secondary */
+      ehp->sa1 = htons(secMAC[1]);
+      /* transmit over secondary socket */
+      memset(&(port->redport->frametime[idx]), 0, sizeof(ec_frametimet));
+      ecx_storebufstat(&(port->redport->rxbufstat[idx]), EC_BUF_TX);
+      batch = ecx_txbatch_find(port);
+      if (batch && (port->txbuflength2 <= EC_TXDUMMYSIZE))
+      {
+         if (batch->redqueue.count >= EC_MAXBUF)
+         {
+            ecx_flushpkt(port, &(port->redport->stack), &(batch->redqueue));
+         }
+         /* dummy frame is shared by all indexes, queue a copy */
+         dummy = batch->txdummy[batch->redqueue.count];
+         memcpy(dummy, &(port->txbuf2), port->txbuflength2);
+         rval2 = ecx_queuepkt(port, &(port->redport->stack), &(batch->redqueue), dummy,
+            port->txbuflength2, idx);
+      }
+      else
+      {
+         rval2 = ecx_sendpkt(port, &(port->redport->stack), &(port->txbuf2), port->txbuflength2);
+      }
+      if (rval2 == -1)
+      {
+         ecx_storebufstat(&(port->redport->rxbufstat[idx]), EC_BUF_EMPTY);
+      }
+      pthread_mutex_unlock( &(port->tx_mutex) );
+   }
+
+   return rval;
+}
+
+/** Transmit process data frame with its data taken straight from the
+ * IOmap instead of the tx buffer, which saves copying the data into the tx
+ * buffer. The tx buffer holds the frame set up with ecx_setupdatagram()
+ * without data. The data must stay unchanged until the frame is transmitted,
+ * at the end of a batch if one is open. In redundant mode, with the io_uring
+ * transport or when port->txgather is FALSE the data is copied into the tx
+ * buffer and the frame is transmitted with ecx_outframe_red().
+ * @param[in] port        = port context struct
+ * @param[in] idx         = index in tx buffer array
+ * @param[in] data        = data of datagram
+ * @param[in] offset      = offset of data in tx buffer
+ * @param[in] length      = length of data
+ * @return socket send result
+ */
+int ecx_outframe_gather(ecx_portt *port, uint8 idx, const void *data, int offset, int length)
+{
+   struct iovec iov[EC_TXIOVMAX];
+   ec_etherheadert *ehp;
+   ec_txbatcht *batch;
+   int lp, rval;
+
+   if (!port->txgather || (port->redstate != ECT_RED_NONE) ||
+       (port->transport == ECT_TRANSPORT_URING))
+   {
+      memcpy(&(port->txbuf[idx][offset]), data, length);
+      ecx_statadd(&(port->stats.txcopybytes), length);
+      return ecx_outframe_red(port, idx);
+   }
+   ehp = (ec_etherheadert *)&(port->txbuf[idx]);
+   /* rewrite MAC source address 1 to primary */
+   ehp->sa1 = htons(priMAC[1]);
+   lp = port->txbuflength[idx];
+   iov[0].iov_base = &(port->txbuf[idx]);
+   iov[0].iov_len = offset;
+   iov[1].iov_base = (void *)data;
+   iov[1].iov_len = length;
+   iov[2].iov_base = &(port->txbuf[idx][offset + length]);
+   iov[2].iov_len = lp - offset - length;
+   memset(&(port->frametime[idx]), 0, sizeof(ec_frametimet));
+   ecx_storebufstat(&(port->rxbufstat[idx]), EC_BUF_TX);
+   pthread_mutex_lock( &(port->tx_mutex) );
+   batch = ecx_txbatch_find(port);
+   if (batch)
+   {
+      rval = ecx_queuepktv(port, &(port->stack), &(batch->txqueue), iov, EC_TXIOVMAX, idx);
+   }
+   else
+   {
+      rval = ecx_sendpktv(port, &(port->stack), iov, EC_TXIOVMAX);
+   }
+   pthread_mutex_unlock( &(port->tx_mutex) );
+   if (rval == -1)
+   {
+      ecx_storebufstat(&(port->rxbufstat[idx]), EC_BUF_EMPTY);
+   }
+
+   return rval;
+}
+
+/** Receive the payload of a frame straight into its destination, for
+ * instance the input area of the IOmap, instead of the rx buffer. The rx
+ * buffer then only holds the datagram header and everything after the
+ * payload. Call by the thread that owns the destination, right before it
+ * waits for the frame. The destination is only written while the frame is
+ * not yet received and the buffer is not released with ecx_setbufstat(), so
+ * a frame arriving earlier stays in the rx buffer and one arriving later is
+ * dropped. In redundant mode or when port->rxscatter is FALSE the payload
+ * stays in the rx buffer.
+ * @param[in] port        = port context struct
+ * @param[in] idx         = index in rx buffer array
+ * @param[in] data        = destination of payload
+ * @param[in] offset      = offset of payload in frame including ethernet header
+ * @param[in] length      = length of payload
+ * @return TRUE if the payload will be received into data, FALSE if the
+ * caller has to copy it from the rx buffer
+ */
+int ecx_inframe_scatter(ecx_portt *port, uint8 idx, void *data, int offset, int length)
+{
+   int rval;
+
+   rval = FALSE;
+   if (port->rxscatter && (port->redstate == ECT_RED_NONE) && (idx < port->maxbuf))
+   {
+      /* frames are filed under rx_mutex, by a waiter or the receive thread */
+      pthread_mutex_lock( &(port->rx_mutex) );
+      if (ecx_loadbufstat(&(port->rxbufstat[idx])) == EC_BUF_TX)
+      {
+         port->rxdest[idx].offset = (uint16)offset;
+         port->rxdest[idx].length = (uint16)length;
+         port->rxdest[idx].data = data;
+         rval = TRUE;
+      }
+      pthread_mutex_unlock( &(port->rx_mutex) );
+   }
+   if (!rval)
+   {
+      ecx_statadd(&(port->stats.rxcopybytes), length);
+   }
+
+   return rval;
+}
+
+/** Start collecting frames for a single transmit. The batch belongs to the
+ * calling thread: until it calls ecx_txbatch_flush() the frames it passes to
+ * ecx_outframe(), ecx_outframe_red() and ecx_outframe_gather() are queued,
+ * frames of other threads are transmitted as usual. So groups cycled by
+ * different threads each batch their own frames. When EC_TXBATCHES threads
+ * already have a batch open the frames are transmitted one by one.
+ * @param[in] port        = port context struct
+ */
+void ecx_txbatch_begin(ecx_portt *port)
+{
+   ec_txbatcht *batch;
+   int i;
+
+   pthread_mutex_lock( &(port->tx_mutex) );
+   if (!ecx_txbatch_find(port))
+   {
+      for (i = 0; i < EC_TXBATCHES; i++)
+      {
+         batch = &(port->txbatch[i]);
+         if (!batch->open)
+         {
+            batch->owner = pthread_self();
+            batch->txqueue.count = 0;
+            batch->redqueue.count = 0;
+            batch->open = TRUE;
+            break;
+         }
+      }
+   }
+   pthread_mutex_unlock( &(port->tx_mutex) );
+}
+
+/** Transmit the frames the calling thread collected since
+ * ecx_txbatch_begin(), with one system call per socket, and close its batch.
+ * @param[in] port        = port context struct
+ * @return number of frames transmitted
+ */
+int ecx_txbatch_flush(ecx_portt *port)
+{
+   ec_txbatcht *batch;
+   int rval;
+
+   rval = 0;
+   pthread_mutex_lock( &(port->tx_mutex) );
+   batch = ecx_txbatch_find(port);
+   if (batch)
+   {
+      batch->open = FALSE;
+      rval = ecx_flushpkt(port, &(port->stack), &(batch->txqueue));
+      if (port->redstate != ECT_RED_NONE)
+      {
+         rval += ecx_flushpkt(port, &(port->redport->stack), &(batch->redqueue));
+      }
+   }
+   pthread_mutex_unlock( &(port->tx_mutex) );
+
+   return rval;
+}
+
+/** Select drain mode for receive. In drain mode every call of ecx_inframe()
+ * that has to read the socket takes all pending frames at once and sorts
+ * them into their rx buffers, instead of reading a single frame.
+ * Call after ecx_setupnic(), which selects single frame reads.
+ * @param[in] port        = port context struct
+ * @param[in] enable      = TRUE to drain, FALSE to read one frame per call
+ */
+void ecx_setrxdrain(ecx_portt *port, int enable)
+{
+   pthread_mutex_lock( &(port->rx_mutex) );
+   if (enable)
+   {
+      ecx_rxdrain_alloc(port);
+   }
+   port->rxdrain = enable;
+   pthread_mutex_unlock( &(port->rx_mutex) );
+}
+
+/** Configure the sockets of a port for time triggered transmit (SO_TXTIME).
+ * Frames then leave the qdisc of the NIC at the time set with
+ * ecx_setlaunchtime(), so their transmit jitter is bounded by the qdisc and
+ * not by the wake up latency of the sending thread. Needs an etf or fq qdisc
+ * on the NIC, the clock must match the clock of the qdisc (CLOCK_TAI for
+ * etf, CLOCK_MONOTONIC for fq). Only the plain socket transport supports
+ * launch times.
+ * Call after ecx_setupnic().
+ * @param[in] port        = port context struct
+ * @param[in] clockid     = clock of launch times
+ * @param[in] deadline    = TRUE to send as soon as possible but before the launch time
+ * @return >0 if succeeded
+ */
+int ecx_settxtime(ecx_portt *port, int clockid, int deadline)
+{
+   struct sock_txtime txt;
+
+   port->txtime = FALSE;
+   txt.clockid = clockid;
+   txt.flags = deadline ? SOF_TXTIME_DEADLINE_MODE : 0;
+   if ((port->transport != ECT_TRANSPORT_SOCKET) ||
+       (setsockopt(port->sockhandle, SOL_SOCKET, SO_TXTIME, &txt, sizeof(txt)) < 0))
+   {
+      return 0;
+   }
+   if ((port->redstate != ECT_RED_NONE) &&
+       ((port->redport->transport != ECT_TRANSPORT_SOCKET) ||
+        (setsockopt(port->redport->sockhandle, SOL_SOCKET, SO_TXTIME, &txt, sizeof(txt)) < 0)))
+   {
+      return 0;
+   }
+   port->txclockid = clockid;
+   port->txtime = TRUE;
+
+   return 1;
+}
+
+/** Set launch time of the frames transmitted next, by this and other
+ * threads, until it is set again. Without ecx_settxtime() the launch time is
+ * ignored.
+ * @param[in] port        = port context struct
+ * @param[in] launchtime  = launch time in ns of the clock given to ecx_settxtime(), 0 = immediately
+ */
+void ecx_setlaunchtime(ecx_portt *port, int64 launchtime)
+{
+   pthread_mutex_lock( &(port->tx_mutex) );
+   port->launchtime = launchtime;
+   pthread_mutex_unlock( &(port->tx_mutex) );
+}
+
+/** Current time of the clock of the launch times.
+ * @param[in] port        = port context struct
+ * @return time in ns of the clock given to ecx_settxtime(), 0 without
+ * ecx_settxtime()
+ */
+int64 ecx_txclocktime(ecx_portt *port)
+{
+   struct timespec ts;
+
+   if (!port->txtime || (clock_gettime(port->txclockid, &ts) < 0))
+   {
+      return 0;
+   }
+   return (int64)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+/** Number of frames dropped by the rx filter of a port, summed over
+ * primary and secondary socket. Frames dropped by the eBPF socket filter are
+ * counted by the kernel, without eBPF they are dropped and counted in user
+ * space. AF_XDP sockets are not filtered.
+ * @param[in] port        = port context struct
+ * @return dropped frames, -1 if port->rxfilteroff was set
+ */
+int64 ecx_rxfilterdrops(ecx_portt *port)
+{
+   union bpf_attr attr;
+   uint32 key;
+   uint64 value;
+   int64 rval;
+
+   if (port->rxfilteroff)
+   {
+      return -1;
+   }
+   rval = __atomic_load_n(&(port->stats.rxfilterdrops), __ATOMIC_RELAXED);
+   key = 0;
+   memset(&attr, 0, sizeof(attr));
+   attr.key = (uint64)(uintptr_t)&key;
+   attr.value = (uint64)(uintptr_t)&value;
+   if (port->rxfiltermap >= 0)
+   {
+      attr.map_fd = port->rxfiltermap;
+      if (ecx_bpf(BPF_MAP_LOOKUP_ELEM, &attr) == 0)
+      {
+         rval += value;
+      }
+   }
+   if ((port->redstate != ECT_RED_NONE) && (port->redport->rxfiltermap >= 0))
+   {
+      attr.map_fd = port->redport->rxfiltermap;
+      if (ecx_bpf(BPF_MAP_LOOKUP_ELEM, &attr) == 0)
+      {
+         rval += value;
+      }
+   }
+
+   return rval;
+}
+
+/** Select how ecx_waitinframe() and ecx_srconfirm() wait for a frame. With
+ * ECT_WAIT_POLL the thread sleeps in ppoll() until the socket is readable or
+ * the deadline passes, instead of spinning on the socket. Optionally the
+ * kernel busy polls the NIC for a short window before it puts the thread to
+ * sleep (SO_BUSY_POLL), which trades some CPU time for wake up latency.
+ * Call after ecx_setupnic(), which selects ECT_WAIT_SPIN.
+ * @param[in] port        = port context struct
+ * @param[in] waitmode    = ECT_WAIT_SPIN or ECT_WAIT_POLL
+ * @param[in] busypoll    = busy poll window in us, 0 = off
+ * @return >0 if succeeded, 0 if busy polling could not be set
+ */
+int ecx_setwaitmode(ecx_portt *port, int waitmode, int busypoll)
+{
+   int rval;
+
+   rval = 1;
+   if ((setsockopt(port->sockhandle, SOL_SOCKET, SO_BUSY_POLL, &busypoll, sizeof(busypoll)) < 0) ||
+       ((port->transport == ECT_TRANSPORT_XDP) &&
+        (setsockopt(port->xsk.fd, SOL_SOCKET, SO_BUSY_POLL, &busypoll, sizeof(busypoll)) < 0)))
+   {
+      rval = 0;
+   }
+   if (port->redstate != ECT_RED_NONE)
+   {
+      if ((setsockopt(port->redport->sockhandle, SOL_SOCKET, SO_BUSY_POLL, &busypoll, sizeof(busypoll)) < 0) ||
+          ((port->redport->transport == ECT_TRANSPORT_XDP) &&
+           (setsockopt(port->redport->xsk.fd, SOL_SOCKET, SO_BUSY_POLL, &busypoll, sizeof(busypoll)) < 0)))
+      {
+         rval = 0;
+      }
+   }
+   port->waitmode = waitmode;
+
+   return rval;
+}
+
+/** Non blocking read of socket. Put frame in temporary buffer, or with a
+ * memory mapped ring point to the frame in the rx ring slot. A frame taken
+ * from the ring must be handed back with ecx_releasepkt().
+ * @param[in] port        = port context struct
+ * @param[in] stacknumber = 0=primary 1=secondary stack
+ * @param[out] frame      = received frame
+ * @return >0 if frame is available and read
+ */
+static int ecx_recvpkt(ecx_portt *port, int stacknumber, uint8 **frame)
+{
+   int lp, bytesrx;
+   ec_stackT *stack;
+   ec_ringt *ring;
+   struct tpacket2_hdr *hdr;
+   ec_xskt *xsk;
+   struct xdp_desc *desc;
+   uint32 cons;
+   struct msghdr msg;
+   struct iovec iov;
+   char ctl[EC_TSCTLSIZE];
+
+   if (!stacknumber)
+   {
+      stack = &(port->stack);
+   }
+   else
    {
-      idx = 0;
+      stack = &(port->redport->stack);
    }
-   cnt = 0;
-   /* try to find unused index */
-   while ((port->rxbufstat[idx] != EC_BUF_EMPTY) && (cnt < EC_MAXBUF))
+   if (*stack->transport == ECT_TRANSPORT_MMAP)
    {
-      idx++;
-      cnt++;
-      if (idx >= EC_MAXBUF)
+      ring = stack->ring;
+      hdr = (struct tpacket2_hdr *)(ring->map + ring->rxhead * ring->framesize);
+      bytesrx = 0;
+      if (__atomic_load_n(&hdr->tp_status, __ATOMIC_ACQUIRE) & TP_STATUS_USER)
       {
-         idx = 0;
+         *frame = (uint8 *)hdr + hdr->tp_mac;
+         bytesrx = hdr->tp_snaplen;
+         port->rxtssw = 0;
+         port->rxtshw = 0;
+         if (port->timestamps)
+         {
+            /* the slot holds a hardware timestamp if the NIC provided one */
+            if (hdr->tp_status & TP_STATUS_TS_RAW_HARDWARE)
+               port->rxtshw = (int64)hdr->tp_sec * 1000000000 + hdr->tp_nsec;
+            else
+               port->rxtssw = (int64)hdr->tp_sec * 1000000000 + hdr->tp_nsec;
+         }
       }
    }
-   port->rxbufstat[idx] = EC_BUF_ALLOC;
-   if (port->redstate != ECT_RED_NONE)
-      port->redport->rxbufstat[idx] = EC_BUF_ALLOC;
-   port->lastidx = idx;
-
-   pthread_mutex_unlock( &(port->getindex_mutex) );
-
-   return idx;
-}
+   else if (*stack->transport == ECT_TRANSPORT_XDP)
+   {
+      xsk = stack->xsk;
+      cons = *xsk->rx.consumer;
+      bytesrx = 0;
+      if (cons != __atomic_load_n(xsk->rx.producer, __ATOMIC_ACQUIRE))
+      {
+         desc = (struct xdp_desc *)xsk->rx.ring + (cons & xsk->rx.mask);
+         xsk->rxaddr = desc->addr;
+         *frame = xsk->umem + desc->addr;
+         bytesrx = desc->len;
+         /* AF_XDP has no rx timestamps */
+         port->rxtssw = 0;
+         port->rxtshw = 0;
+      }
+   }
+   else if (*stack->transport == ECT_TRANSPORT_URING)
+   {
+      bytesrx = ecx_uring_recv(port, stack->uring, frame);
+      /* receives of the io_uring carry no rx timestamps */
+      port->rxtssw = 0;
+      port->rxtshw = 0;
+   }
+   else if (port->timestamps)
+   {
+      memset(&msg, 0, sizeof(msg));
+      iov.iov_base = (*stack->tempbuf);
+      iov.iov_len = sizeof(port->tempinbuf);
+      msg.msg_iov = &iov;
+      msg.msg_iovlen = 1;
+      msg.msg_control = ctl;
+      msg.msg_controllen = sizeof(ctl);
+      bytesrx = recvmsg(*stack->sock, &msg,
+         (port->waitmode == ECT_WAIT_POLL) ? MSG_DONTWAIT : 0);
+      *frame = (*stack->tempbuf);
+      ecx_ts_parse(&msg, &(port->rxtssw), &(port->rxtshw));
+      ecx_statadd(&(port->stats.rxcalls), 1);
+   }
+   else
+   {
+      lp = sizeof(port->tempinbuf);
+      bytesrx = recv(*stack->sock, (*stack->tempbuf), lp,
+         (port->waitmode == ECT_WAIT_POLL) ? MSG_DONTWAIT : 0);
+      *frame = (*stack->tempbuf);
+      ecx_statadd(&(port->stats.rxcalls), 1);
+   }
+   port->tempinbufs = bytesrx;
+   if (bytesrx > 0)
+   {
+      ecx_statadd(&(port->stats.rxframes), 1);
+   }
 
-/** Set rx buffer status.
- * @param[in] port        = port context struct
- * @param[in] idx      = index in buffer array
- * @param[in] bufstat  = status to set
- */
-void ecx_setbufstat(ecx_portt *port, uint8 idx, int bufstat)
-{
-   port->rxbufstat[idx] = bufstat;
-   if (port->redstate != ECT_RED_NONE)
-      port->redport->rxbufstat[idx] = bufstat;
+   return (bytesrx > 0);
 }
 
-/** Transmit buffer over socket (non blocking).
+/** Hand rx ring slot of last frame read by ecx_recvpkt() back to the kernel.
  * @param[in] port        = port context struct
- * @param[in] idx         = index in tx buffer array
- * @param[in] stacknumber  = 0=Primary 1=Secondary stack
- * @return socket send result
+ * @param[in] stacknumber = 0=primary 1=secondary stack
  */
-int ecx_outframe(ecx_portt *port, uint8 idx, int stacknumber)
+static void ecx_releasepkt(ecx_portt *port, int stacknumber)
 {
-   int lp, rval;
    ec_stackT *stack;
+   ec_ringt *ring;
+   struct tpacket2_hdr *hdr;
+   ec_xskt *xsk;
+   uint64 *fillp;
+   uint32 prod;
 
    if (!stacknumber)
    {
@@ -280,64 +2371,148 @@ int ecx_outframe(ecx_portt *port, uint8 idx, int stacknumber)
    {
       stack = &(port->redport->stack);
    }
-   lp = (*stack->txbuflength)[idx];
-   (*stack->rxbufstat)[idx] = EC_BUF_TX;
-   rval = send(*stack->sock, (*stack->txbuf)[idx], lp, 0);
-   if (rval == -1)
+   if (*stack->transport == ECT_TRANSPORT_MMAP)
+   {
+      ring = stack->ring;
+      hdr = (struct tpacket2_hdr *)(ring->map + ring->rxhead * ring->framesize);
+      __atomic_store_n(&hdr->tp_status, TP_STATUS_KERNEL, __ATOMIC_RELEASE);
+      ring->rxhead = (ring->rxhead + 1) % ring->framecount;
+   }
+   else if (*stack->transport == ECT_TRANSPORT_XDP)
    {
-      (*stack->rxbufstat)[idx] = EC_BUF_EMPTY;
+      xsk = stack->xsk;
+      /* hand chunk back to the kernel through the fill ring */
+      fillp = xsk->fill.ring;
+      prod = *xsk->fill.producer;
+      fillp[prod & xsk->fill.mask] = xsk->rxaddr & ~((uint64)EC_XSKCHUNKSIZE - 1);
+      __atomic_store_n(xsk->fill.producer, prod + 1, __ATOMIC_RELEASE);
+      __atomic_store_n(xsk->rx.consumer, *xsk->rx.consumer + 1, __ATOMIC_RELEASE);
    }
+   else if (*stack->transport == ECT_TRANSPORT_URING)
+   {
+      /* submitted with the next send or wait */
+      pthread_mutex_lock( &(port->tx_mutex) );
+      ecx_uring_postrecv(stack->uring, stack->uring->rxslot);
+      pthread_mutex_unlock( &(port->tx_mutex) );
+   }
+}
 
-   return rval;
+/** Copy a received frame into the rx buffer of its index, stripping the
+ * ethernet header. A payload destination set by ecx_inframe_scatter() gets
+ * the payload directly.
+ * @param[in] port   = port context struct
+ * @param[in] stack  = stack the frame was received on
+ * @param[in] idx    = index of frame
+ * @param[in] frame  = received frame including ethernet header
+ */
+static void ecx_storeframe(ecx_portt *port, ec_stackT *stack, uint8 idx, const uint8 *frame)
+{
+   ec_rxdestt *dest;
+   uint8 *rxbuf;
+   int lp, lh;
+
+   rxbuf = stack->rxbuf[idx];
+   lp = stack->txbuflength[idx];
+   dest = &(port->rxdest[idx]);
+   if ((stack == &(port->stack)) && dest->data)
+   {
+      lh = dest->offset + dest->length;
+      memcpy(rxbuf, &frame[ETH_HEADERSIZE], dest->offset - ETH_HEADERSIZE);
+      memcpy(dest->data, &frame[dest->offset], dest->length);
+      memcpy(&rxbuf[lh - ETH_HEADERSIZE], &frame[lh], lp - lh);
+   }
+   else
+   {
+      memcpy(rxbuf, &frame[ETH_HEADERSIZE], lp - ETH_HEADERSIZE);
+   }
 }
 
-/** Transmit buffer over socket (non blocking).
- * @param[in] port        = port context struct
- * @param[in] idx = index in tx buffer array
- * @return socket send result
+/** Sort a received frame into the rx buffer of its index. With the receive
+ * thread running, the waiter of the index is woken.
+ * @param[in] port   = port context struct
+ * @param[in] stack  = stack the frame was received on
+ * @param[in] idx    = requested index of frame, -1 if none
+ * @param[in] frame  = received frame including ethernet header
+ * @return Workcounter if frame has the requested index, otherwise EC_OTHERFRAME
  */
-int ecx_outframe_red(ecx_portt *port, uint8 idx)
+static int ecx_sortframe(ecx_portt *port, ec_stackT *stack, int idx, uint8 *frame)
 {
-   ec_comt *datagramP;
+   uint16  l;
+   int     rval;
+   uint8   idxf;
    ec_etherheadert *ehp;
-   int rval;
+   ec_comt *ecp;
+   ec_bufT *rxbuf;
 
-   ehp = (ec_etherheadert *)&(port->txbuf[idx]);
-   /* rewrite MAC source address 1 to primary */
-   ehp->sa1 = htons(priMAC[1]);
-   /* transmit over primary socket*/
-   rval = ecx_outframe(port, idx, 0);
-   if (port->redstate != ECT_RED_NONE)
+   rval = EC_OTHERFRAME;
+   ehp =(ec_etherheadert*)(frame);
+   /* check if it is an EtherCAT frame */
+   if ((ehp->etype == htons(ETH_P_ECAT)) &&
+       (!*stack->rxsoftfilter || ecx_rxsoftfilter(port, frame)))
    {
-      pthread_mutex_lock( &(port->tx_mutex) );
-      ehp = (ec_etherheadert *)&(port->txbuf2);
-      /* use dummy frame for secondary socket transmit (BRD) */
-      datagramP = (ec_comt*)&(port->txbuf2[ETH_HEADERSIZE]);
-      /* write index to frame */
-      datagramP->index = idx;
-      /* rewrite MAC source address 1 to secondary */
-      ehp->sa1 = htons(secMAC[1]);
-      /* transmit over secondary socket */
-      port->redport->rxbufstat[idx] = EC_BUF_TX;
-      if (send(port->redport->sockhandle, &(port->txbuf2), port->txbuflength2 , 0) == -1)
+      ecp =(ec_comt*)(&frame[ETH_HEADERSIZE]);
+      l = etohs(ecp->elength) & 0x0fff;
+      idxf = ecp->index;
+      /* found index equals requested index ? */
+      if (idxf == idx)
       {
-         port->redport->rxbufstat[idx] = EC_BUF_EMPTY;
+         rxbuf = &stack->rxbuf[idx];
+         /* yes, put it in the buffer array (strip ethernet header) */
+         ecx_storeframe(port, stack, idx, frame);
+         /* return WKC */
+         rval = ((*rxbuf)[l] + ((uint16)((*rxbuf)[l + 1]) << 8));
+         /* mark as completed */
+         ecx_storebufstat(&stack->rxbufstat[idx], EC_BUF_COMPLETE);
+         /* store MAC source word 1 for redundant routing info */
+         stack->rxsa[idx] = ntohs(ehp->sa1);
+         stack->frametime[idx].rxsw = port->rxtssw;
+         stack->frametime[idx].rxhw = port->rxtshw;
+      }
+      else
+      {
+         /* check if index exist and someone is waiting for it */
+         if (idxf < port->maxbuf && ecx_loadbufstat(&stack->rxbufstat[idxf]) == EC_BUF_TX)
+         {
+            /* put it in the buffer array (strip ethernet header) */
+            ecx_storeframe(port, stack, idxf, frame);
+            stack->rxsa[idxf] = ntohs(ehp->sa1);
+            stack->frametime[idxf].rxsw = port->rxtssw;
+            stack->frametime[idxf].rxhw = port->rxtshw;
+            /* mark as received */
+            ecx_storebufstat(&stack->rxbufstat[idxf], EC_BUF_RCVD);
+            if (port->rxthread)
+            {
+               syscall(SYS_futex, &stack->rxbufstat[idxf], FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0);
+            }
+         }
+         else
+         {
+            /* strange things happened */
+         }
       }
-      pthread_mutex_unlock( &(port->tx_mutex) );
    }
 
    return rval;
 }
 
-/** Non blocking read of socket. Put frame in temporary buffer.
+/** Read all pending frames of a socket and sort them into their rx buffers.
+ * A plain socket is drained with one recvmmsg(), or frame by frame when its
+ * drain buffers could not be allocated, packet rings and AF_XDP are drained
+ * slot by slot without system calls. Caller must hold rx_mutex.
  * @param[in] port        = port context struct
+ * @param[in] idx         = requested index of frame, -1 if none
  * @param[in] stacknumber = 0=primary 1=secondary stack
- * @return >0 if frame is available and read
+ * @return Workcounter if a frame is found with requested index, otherwise
+ * EC_NOFRAME or EC_OTHERFRAME.
  */
-static int ecx_recvpkt(ecx_portt *port, int stacknumber)
+static int ecx_drainframes(ecx_portt *port, int idx, int stacknumber)
 {
-   int lp, bytesrx;
+   struct mmsghdr msg[EC_MAXBUF];
+   struct iovec iov[EC_MAXBUF];
+   char ctl[EC_MAXBUF][EC_TSCTLSIZE];
    ec_stackT *stack;
+   uint8 *frame;
+   int i, n, r, rval;
 
    if (!stacknumber)
    {
@@ -347,11 +2522,55 @@ static int ecx_recvpkt(ecx_portt *port, int stacknumber)
    {
       stack = &(port->redport->stack);
    }
-   lp = sizeof(port->tempinbuf);
-   bytesrx = recv(*stack->sock, (*stack->tempbuf), lp, 0);
-   port->tempinbufs = bytesrx;
+   rval = EC_NOFRAME;
+   /* without drain buffers a plain socket is read frame by frame */
+   if ((*stack->transport == ECT_TRANSPORT_SOCKET) && port->rxdrainbuf)
+   {
+      memset(msg, 0, sizeof(msg));
+      for (i = 0; i < EC_MAXBUF; i++)
+      {
+         iov[i].iov_base = &(port->rxdrainbuf[i]);
+         iov[i].iov_len = sizeof(ec_bufT);
+         msg[i].msg_hdr.msg_iov = &iov[i];
+         msg[i].msg_hdr.msg_iovlen = 1;
+         if (port->timestamps)
+         {
+            msg[i].msg_hdr.msg_control = ctl[i];
+            msg[i].msg_hdr.msg_controllen = sizeof(ctl[i]);
+         }
+      }
+      /* wait like recv() for the first frame, then take what is pending */
+      n = recvmmsg(*stack->sock, msg, EC_MAXBUF,
+         (port->waitmode == ECT_WAIT_POLL) ? MSG_DONTWAIT : MSG_WAITFORONE, NULL);
+      ecx_statadd(&(port->stats.rxcalls), 1);
+      for (i = 0; i < n; i++)
+      {
+         ecx_statadd(&(port->stats.rxframes), 1);
+         if (port->timestamps)
+         {
+            ecx_ts_parse(&msg[i].msg_hdr, &(port->rxtssw), &(port->rxtshw));
+         }
+         r = ecx_sortframe(port, stack, idx, port->rxdrainbuf[i]);
+         if ((r > EC_NOFRAME) || (rval == EC_NOFRAME))
+         {
+            rval = r;
+         }
+      }
+   }
+   else
+   {
+      for (i = 0; (i < EC_MAXBUF) && ecx_recvpkt(port, stacknumber, &frame); i++)
+      {
+         r = ecx_sortframe(port, stack, idx, frame);
+         ecx_releasepkt(port, stacknumber);
+         if ((r > EC_NOFRAME) || (rval == EC_NOFRAME))
+         {
+            rval = r;
+         }
+      }
+   }
 
-   return (bytesrx > 0);
+   return rval;
 }
 
 /** Non blocking receive frame function. Uses RX buffer and index to combine
@@ -374,11 +2593,9 @@ int ecx_inframe(ecx_portt *port, uint8 idx, int stacknumber)
 {
    uint16  l;
    int     rval;
-   uint8   idxf;
-   ec_etherheadert *ehp;
-   ec_comt *ecp;
    ec_stackT *stack;
    ec_bufT *rxbuf;
+   uint8 *frame;
 
    if (!stacknumber)
    {
@@ -389,60 +2606,30 @@ int ecx_inframe(ecx_portt *port, uint8 idx, int stacknumber)
       stack = &(port->redport->stack);
    }
    rval = EC_NOFRAME;
-   rxbuf = &(*stack->rxbuf)[idx];
+   rxbuf = &stack->rxbuf[idx];
    /* check if requested index is already in buffer ? */
-   if ((idx < EC_MAXBUF) && ((*stack->rxbufstat)[idx] == EC_BUF_RCVD))
+   if ((idx < port->maxbuf) && (ecx_loadbufstat(&stack->rxbufstat[idx]) == EC_BUF_RCVD))
    {
       l = (*rxbuf)[0] + ((uint16)((*rxbuf)[1] & 0x0f) << 8);
       /* return WKC */
       rval = ((*rxbuf)[l] + ((uint16)(*rxbuf)[l + 1] << 8));
       /* mark as completed */
-      (*stack->rxbufstat)[idx] = EC_BUF_COMPLETE;
+      ecx_storebufstat(&stack->rxbufstat[idx], EC_BUF_COMPLETE);
    }
-   else
+   /* with the receive thread running, frames are sorted by that thread */
+   else if (!port->rxthread)
    {
       pthread_mutex_lock(&(port->rx_mutex));
+      ecx_ts_readtx(port, stack);
+      if (port->rxdrain)
+      {
+         rval = ecx_drainframes(port, idx, stacknumber);
+      }
       /* non blocking call to retrieve frame from socket */
-      if (ecx_recvpkt(port, stacknumber))
+      else if (ecx_recvpkt(port, stacknumber, &frame))
       {
-         rval = EC_OTHERFRAME;
-         ehp =(ec_etherheadert*)(stack->tempbuf);
-         /* check if it is an EtherCAT frame */
-         if (ehp->etype == htons(ETH_P_ECAT))
-         {
-            ecp =(ec_comt*)(&(*stack->tempbuf)[ETH_HEADERSIZE]);
-            l = etohs(ecp->elength) & 0x0fff;
-            idxf = ecp->index;
-            /* found index equals requested index ? */
-            if (idxf == idx)
-            {
-               /* yes, put it in the buffer array (strip ethernet header) */
-               memcpy(rxbuf, &(*stack->tempbuf)[ETH_HEADERSIZE], (*stack->txbuflength)[idx] - ETH_HEADERSIZE);
-               /* return WKC */
-               rval = ((*rxbuf)[l] + ((uint16)((*rxbuf)[l + 1]) << 8));
-               /* mark as completed */
-               (*stack->rxbufstat)[idx] = EC_BUF_COMPLETE;
-               /* store MAC source word 1 for redundant routing info */
-               (*stack->rxsa)[idx] = ntohs(ehp->sa1);
-            }
-            else
-            {
-               /* check if index exist and someone is waiting for it */
-               if (idxf < EC_MAXBUF && (*stack->rxbufstat)[idxf] == EC_BUF_TX)
-               {
-                  rxbuf = &(*stack->rxbuf)[idxf];
-                  /* put it in the buffer array (strip ethernet header) */
-                  memcpy(rxbuf, &(*stack->tempbuf)[ETH_HEADERSIZE], (*stack->txbuflength)[idxf] - ETH_HEADERSIZE);
-                  /* mark as received */
-                  (*stack->rxbufstat)[idxf] = EC_BUF_RCVD;
-                  (*stack->rxsa)[idxf] = ntohs(ehp->sa1);
-               }
-               else
-               {
-                  /* strange things happened */
-               }
-            }
-         }
+         rval = ecx_sortframe(port, stack, idx, frame);
+         ecx_releasepkt(port, stacknumber);
       }
       pthread_mutex_unlock( &(port->rx_mutex) );
 
@@ -452,6 +2639,268 @@ int ecx_inframe(ecx_portt *port, uint8 idx, int stacknumber)
    return rval;
 }
 
+/** File descriptor that becomes readable when a frame arrives on a stack.
+ * @param[in] stack  = stack of socket
+ * @return file descriptor
+ */
+static int ecx_pollfd(ec_stackT *stack)
+{
+   if (*stack->transport == ECT_TRANSPORT_XDP)
+   {
+      return stack->xsk->fd;
+   }
+   if (*stack->transport == ECT_TRANSPORT_URING)
+   {
+      return stack->uring->fd;
+   }
+   return *stack->sock;
+}
+
+/** File descriptor that becomes readable when a frame for the primary socket
+ * of a port can be read, the io_uring with ECT_TRANSPORT_URING. Lets an
+ * application wait for frames and its own file descriptors in one poll().
+ * @param[in] port        = port context struct
+ * @return file descriptor
+ */
+int ecx_getpollfd(ecx_portt *port)
+{
+   return ecx_pollfd(&(port->stack));
+}
+
+/** Time left until a timer expires.
+ * @param[in] timer      = absolute timeout time
+ * @return time left in ns, <= 0 if expired
+ */
+static int64 ecx_timeleft(osal_timert *timer)
+{
+   struct timespec now;
+
+   /* osal timers run on CLOCK_MONOTONIC */
+   clock_gettime(CLOCK_MONOTONIC, &now);
+   return ((int64)timer->stop_time.sec - now.tv_sec) * 1000000000 +
+          ((int64)timer->stop_time.usec * 1000 - now.tv_nsec);
+}
+
+/** Sleep until a frame can be read on the primary and/or secondary socket or
+ * the timer expires, but at most EC_WAITSLICE us.
+ * @param[in] port       = port context struct
+ * @param[in] primary    = TRUE to wait on primary socket
+ * @param[in] secondary  = TRUE to wait on secondary socket
+ * @param[in] timer      = absolute timeout time
+ */
+static void ecx_waitpkt(ecx_portt *port, int primary, int secondary, osal_timert *timer)
+{
+   struct pollfd pfd[2];
+   struct timespec ts;
+   int64 remain;
+   int n;
+
+   n = 0;
+   if (primary)
+   {
+      pfd[n].fd = ecx_pollfd(&(port->stack));
+      pfd[n++].events = POLLIN;
+   }
+   if (secondary)
+   {
+      pfd[n].fd = ecx_pollfd(&(port->redport->stack));
+      pfd[n++].events = POLLIN;
+   }
+   remain = ecx_timeleft(timer);
+   if ((n == 0) || (remain <= 0))
+   {
+      return;
+   }
+   if (remain > (int64)EC_WAITSLICE * 1000)
+   {
+      remain = (int64)EC_WAITSLICE * 1000;
+   }
+   /* a single io_uring reaps its completions while waiting */
+   if ((n == 1) && primary && (port->transport == ECT_TRANSPORT_URING))
+   {
+      ecx_uring_enter(&(port->uring), 1, remain);
+   }
+   else
+   {
+      ts.tv_sec = 0;
+      ts.tv_nsec = remain;
+      ppoll(pfd, n, &ts, NULL);
+   }
+   ecx_statadd(&(port->stats.rxwaits), 1);
+}
+
+/** Sleep until the receive thread has filed the frame of an index or the
+ * timer expires.
+ * @param[in] port        = port context struct
+ * @param[in] idx         = requested index of frame
+ * @param[in] stacknumber = 0=primary 1=secondary stack
+ * @param[in] timer       = absolute timeout time
+ * @return FALSE if no frame can arrive for the index, because it was not
+ * transmitted or is released, TRUE otherwise
+ */
+static int ecx_waitslot(ecx_portt *port, uint8 idx, int stacknumber, osal_timert *timer)
+{
+   ec_stackT *stack;
+   struct timespec ts;
+   int64 remain;
+   int bufstat;
+
+   if (!stacknumber)
+   {
+      stack = &(port->stack);
+   }
+   else
+   {
+      stack = &(port->redport->stack);
+   }
+   /* a failed send sets the slot back to empty, the futex would not sleep */
+   bufstat = ecx_loadbufstat(&stack->rxbufstat[idx]);
+   if ((bufstat != EC_BUF_TX) && (bufstat != EC_BUF_RCVD))
+   {
+      return FALSE;
+   }
+   remain = ecx_timeleft(timer);
+   if (remain <= 0)
+   {
+      return TRUE;
+   }
+   ts.tv_sec = remain / 1000000000;
+   ts.tv_nsec = remain % 1000000000;
+   /* returns at once if the frame was filed in the meantime */
+   syscall(SYS_futex, &stack->rxbufstat[idx], FUTEX_WAIT_PRIVATE, EC_BUF_TX, &ts, NULL, 0);
+   ecx_statadd(&(port->stats.rxwaits), 1);
+
+   return TRUE;
+}
+
+/** Receive thread, owns the sockets of the port and files every frame into
+ * the rx buffer of its index.
+ * @param[in] arg         = port context struct
+ * @return NULL
+ */
+static void *ecx_rxthread(void *arg)
+{
+   ecx_portt *port;
+   struct pollfd pfd[2];
+   int n;
+
+   port = arg;
+   while (!__atomic_load_n(&(port->rxstop), __ATOMIC_ACQUIRE))
+   {
+      pfd[0].fd = ecx_pollfd(&(port->stack));
+      pfd[0].events = POLLIN;
+      n = 1;
+      if (port->redstate != ECT_RED_NONE)
+      {
+         pfd[1].fd = ecx_pollfd(&(port->redport->stack));
+         pfd[1].events = POLLIN;
+         n = 2;
+      }
+      /* wake up now and then to see if the thread is stopped */
+      if (poll(pfd, n, EC_RXTHREADPOLL) > 0)
+      {
+         /* the error queue is also read by ecx_frametime() */
+         pthread_mutex_lock(&(port->rx_mutex));
+         /* tx timestamps are signalled as error on the socket */
+         if (pfd[0].revents & POLLERR)
+            ecx_ts_readtx(port, &(port->stack));
+         if ((n > 1) && (pfd[1].revents & POLLERR))
+            ecx_ts_readtx(port, &(port->redport->stack));
+         if (pfd[0].revents & POLLIN)
+            ecx_drainframes(port, -1, 0);
+         if ((n > 1) && (pfd[1].revents & POLLIN))
+            ecx_drainframes(port, -1, 1);
+         pthread_mutex_unlock(&(port->rx_mutex));
+      }
+   }
+
+   return NULL;
+}
+
+/** Wire times of the last frame transmitted and received with an index.
+ * Requires port->timestamps set TRUE before ecx_setupnic(). The roundtrip
+ * is taken from the hardware timestamps when the NIC provides both, else from
+ * the software timestamps of the kernel. The indexes used for the process
+ * data frames of the last cycle are in the idxstack of their group. Not
+ * available on the AF_XDP transport.
+ * @param[in] port        = port context struct
+ * @param[in] idx         = index of frame
+ * @param[out] frametime  = timestamps of frame on primary socket, NULL if not needed
+ * @return roundtrip time in ns, -1 if not available
+ */
+int64 ecx_frametime(ecx_portt *port, uint8 idx, ec_frametimet *frametime)
+{
+   ec_frametimet *ft;
+   int64 rval;
+
+   if (idx >= port->maxbuf)
+   {
+      return -1;
+   }
+   /* pick up tx timestamps that arrived after the frame was received */
+   pthread_mutex_lock(&(port->rx_mutex));
+   ecx_ts_readtx(port, &(port->stack));
+   pthread_mutex_unlock(&(port->rx_mutex));
+   ft = &(port->stack.frametime[idx]);
+   if (frametime)
+   {
+      *frametime = *ft;
+   }
+   rval = -1;
+   if (ft->txhw && ft->rxhw)
+   {
+      rval = ft->rxhw - ft->txhw;
+   }
+   else if (ft->txsw && ft->rxsw)
+   {
+      rval = ft->rxsw - ft->txsw;
+   }
+
+   return rval;
+}
+
+/** Start receive thread of a port. The thread takes over reading of the
+ * sockets, ecx_waitinframe() and ecx_srconfirm() then sleep on the rx buffer
+ * status of their index until the thread wakes them. The thread runs with
+ * real time priority when the process is allowed to.
+ * Call after ecx_setupnic().
+ * @param[in] port        = port context struct
+ * @return >0 if succeeded
+ */
+int ecx_startrxthread(ecx_portt *port)
+{
+   if (port->rxthread)
+   {
+      return 1;
+   }
+   port->rxstop = FALSE;
+   ecx_rxdrain_alloc(port);
+   /* set before the thread runs, so no waiter reads the sockets next to it */
+   port->rxthread = TRUE;
+   if (!osal_thread_create_rt(&(port->rxthreadid), EC_RXTHREADSTACK, &ecx_rxthread, port))
+   {
+      port->rxthread = FALSE;
+      return 0;
+   }
+
+   return 1;
+}
+
+/** Stop receive thread of a port, frames are read by the waiting threads
+ * again.
+ * @param[in] port        = port context struct
+ */
+void ecx_stoprxthread(ecx_portt *port)
+{
+   if (!port->rxthread)
+   {
+      return;
+   }
+   __atomic_store_n(&(port->rxstop), TRUE, __ATOMIC_RELEASE);
+   pthread_join(port->rxthreadid, NULL);
+   port->rxthread = FALSE;
+}
+
 /** Blocking redundant receive frame function. If redundant mode is not active then
  * it skips the secondary stack and redundancy functions. In redundant mode it waits
  * for both (primary and secondary) frames to come in. The result goes in an decision
@@ -486,6 +2935,21 @@ static int ecx_waitinframe_red(ecx_portt *port, uint8 idx, osal_timert *timer)
          if (wkc2 <= EC_NOFRAME)
             wkc2 = ecx_inframe(port, idx, 1);
       }
+      /* sleep until the receive thread has the missing frame, stop
+       * waiting for a frame that was never transmitted */
+      if (port->rxthread && (wkc <= EC_NOFRAME))
+      {
+         if (!ecx_waitslot(port, idx, 0, timer))
+            break;
+      }
+      else if (port->rxthread && (wkc2 <= EC_NOFRAME))
+      {
+         if (!ecx_waitslot(port, idx, 1, timer))
+            break;
+      }
+      /* sleep until a missing frame can be read */
+      else if ((port->waitmode == ECT_WAIT_POLL) && ((wkc <= EC_NOFRAME) || (wkc2 <= EC_NOFRAME)))
+         ecx_waitpkt(port, (wkc <= EC_NOFRAME), (wkc2 <= EC_NOFRAME), timer);
    /* wait for both frames to arrive or timeout */
    } while (((wkc <= EC_NOFRAME) || (wkc2 <= EC_NOFRAME)) && !osal_timer_is_expired(timer));
    /* only do redundant functions when in redundant mode */
@@ -558,6 +3022,21 @@ int ecx_waitinframe(ecx_portt *port, uint8 idx, int timeout)
    return wkc;
 }
 
+/** Blocking receive frame function with a timer started by the caller, so
+ * several frames can share one deadline. Calls ec_waitinframe_red().
+ * A plain socket in ECT_WAIT_SPIN mode can block up to a scheduler tick in
+ * recv(), select ECT_WAIT_POLL to keep close to the deadline.
+ * @param[in] port        = port context struct
+ * @param[in] idx         = requested index of frame
+ * @param[in] timer       = absolute timeout time
+ * @return Workcounter if a frame is found with corresponding index, otherwise
+ * EC_NOFRAME.
+ */
+int ecx_waitinframe_timer(ecx_portt *port, uint8 idx, osal_timert *timer)
+{
+   return ecx_waitinframe_red(port, idx, timer);
+}
+
 /** Blocking send and receive frame function. Used for non processdata frames.
  * A datagram is build into a frame and transmitted via this function. It waits
  * for an answer and returns the workcounter. The function retries if time is
@@ -17,24 +17,302 @@ extern "C"
 #endif
 
 #include <pthread.h>
+#include <stddef.h>
+#include <sys/uio.h>
+
+/** min. number of UMEM chunks an AF_XDP socket uses for rx, and again for tx,
+ * raised to the frame pool size of the port */
+#define EC_XSKFRAMES      32
+/** max length of a redundancy dummy frame that can be queued for a batched
+ * transmit, longer dummy frames are transmitted immediately */
+#define EC_TXDUMMYSIZE    64
+/** longest single sleep in us of ECT_WAIT_POLL, bounds the delay when another
+ * thread has already put the awaited frame in its rx buffer */
+#define EC_WAITSLICE      100
+/** poll timeout in ms of the receive thread, bounds the time to stop it */
+#define EC_RXTHREADPOLL   10
+/** max. number of parts a frame is gathered from at transmit, see
+ * ecx_outframe_gather() */
+#define EC_TXIOVMAX       3
+/** number of frame buffers receives are pre-posted into with the io_uring
+ * transport. Every posted receive is woken by each frame, frames beyond it
+ * wait in the socket until a buffer is posted again. */
+#define EC_URINGRXFRAMES  16
+/** number of threads that can collect frames for a batched transmit at the
+ * same time, see ecx_txbatch_begin() */
+#define EC_TXBATCHES      4
+/** stack size of the receive thread */
+#define EC_RXTHREADSTACK  (64 * 1024)
+/** passes over all frame indexes ecx_getindex() makes for a free index
+ * before it takes a busy one, indexes released during a pass by other
+ * threads can be behind the scan */
+#define EC_GETINDEXPASSES 4
+
+/** How a port waits for a frame in ecx_waitinframe() and ecx_srconfirm(),
+ * selected with ecx_setwaitmode() */
+enum
+{
+   /** read the socket in a loop until the frame arrives or the timer expires */
+   ECT_WAIT_SPIN,
+   /** sleep in ppoll() until the socket is readable or the timer expires */
+   ECT_WAIT_POLL
+};
+
+/** Transport used for a NIC socket. Selected per socket with a prefix on the
+ * interface name given to ecx_setupnic(), f.e. "mmap:eth0", "xdp:eth0" or
+ * "uring:eth0". */
+enum
+{
+   /** AF_PACKET socket, one send() or recv() system call per frame */
+   ECT_TRANSPORT_SOCKET,
+   /** AF_PACKET socket with memory mapped rx and tx rings (PACKET_MMAP) */
+   ECT_TRANSPORT_MMAP,
+   /** AF_XDP socket fed by an XDP program that redirects EtherCAT frames */
+   ECT_TRANSPORT_XDP,
+   /** AF_PACKET socket driven by an io_uring with pre-posted receives */
+   ECT_TRANSPORT_URING
+};
+
+/** memory mapped rx and tx ring of a PACKET_MMAP socket */
+typedef struct
+{
+   /** mapped area, rx ring followed by tx ring */
+   uint8       *map;
+   /** length of mapped area in bytes */
+   size_t      maplen;
+   /** size of one frame slot in bytes */
+   uint32      framesize;
+   /** number of frame slots in each ring */
+   uint32      framecount;
+   /** next rx slot to inspect */
+   uint32      rxhead;
+   /** next tx slot to fill */
+   uint32      txhead;
+} ec_ringt;
+
+/** one of the four rings shared with the kernel by an AF_XDP socket */
+typedef struct
+{
+   /** producer index */
+   uint32      *producer;
+   /** consumer index */
+   uint32      *consumer;
+   /** ring entries */
+   void        *ring;
+   /** number of entries minus one */
+   uint32      mask;
+   /** mapped area */
+   void        *map;
+   /** length of mapped area in bytes */
+   size_t      maplen;
+} ec_xskringt;
+
+/** AF_XDP socket with its UMEM and XDP program */
+typedef struct
+{
+   /** AF_XDP socket */
+   int         fd;
+   /** XSKMAP the XDP program redirects to */
+   int         mapfd;
+   /** XDP program */
+   int         progfd;
+   /** link attaching the XDP program to the NIC */
+   int         linkfd;
+   /** UMEM holding rx fill chunks followed by tx chunks */
+   uint8       *umem;
+   /** length of UMEM in bytes */
+   size_t      umemlen;
+   /** rx ring */
+   ec_xskringt rx;
+   /** tx ring */
+   ec_xskringt tx;
+   /** UMEM fill ring */
+   ec_xskringt fill;
+   /** UMEM completion ring */
+   ec_xskringt comp;
+   /** number of entries of each ring, UMEM holds twice as many chunks */
+   uint32      nframes;
+   /** free tx chunk addresses, nframes entries */
+   uint64      *txfree;
+   /** number of free tx chunks */
+   int         ntxfree;
+   /** UMEM address of frame last read from rx ring */
+   uint64      rxaddr;
+} ec_xskt;
+
+/** io_uring of a socket, with the receive buffers posted to it */
+typedef struct
+{
+   /** io_uring */
+   int         fd;
+   /** socket the requests are issued on */
+   int         sock;
+   /** mapped submission queue ring */
+   uint8       *sqmap;
+   /** length of mapped submission queue ring in bytes */
+   size_t      sqmaplen;
+   /** mapped completion queue ring, equals sqmap when mapped in one */
+   uint8       *cqmap;
+   /** length of mapped completion queue ring in bytes */
+   size_t      cqmaplen;
+   /** submission queue entries */
+   void        *sqes;
+   /** length of mapped submission queue entries in bytes */
+   size_t      sqeslen;
+   /** submission queue head, tail and index array */
+   uint32      *sqhead;
+   uint32      *sqtail;
+   uint32      *sqarray;
+   /** number of submission queue entries minus one */
+   uint32      sqmask;
+   /** completion queue head and tail */
+   uint32      *cqhead;
+   uint32      *cqtail;
+   /** completion queue entries */
+   void        *cqes;
+   /** number of completion queue entries minus one */
+   uint32      cqmask;
+   /** flags of send requests */
+   uint8       txflags;
+   /** receive buffers, each one has a receive posted while free */
+   ec_bufT     *rxslots;
+   /** number of receive buffers */
+   uint32      nrx;
+   /** receive buffer of frame last read */
+   uint32      rxslot;
+} ec_uringt;
+
+/** frame and system call counters of a port */
+typedef struct
+{
+   /** frames transmitted */
+   uint64      txframes;
+   /** frames received */
+   uint64      rxframes;
+   /** system calls issued for transmit */
+   uint64      txcalls;
+   /** system calls issued for receive, including polls that found nothing */
+   uint64      rxcalls;
+   /** sleeps in ppoll() with ECT_WAIT_POLL */
+   uint64      rxwaits;
+   /** frames dropped by the rx filter in user space, see ecx_rxfilterdrops() */
+   uint64      rxfilterdrops;
+   /** process data bytes copied into tx buffers by ecx_outframe_gather() */
+   uint64      txcopybytes;
+   /** process data bytes left in rx buffers by ecx_inframe_scatter(), the
+    * caller copies them out */
+   uint64      rxcopybytes;
+   /** batched transmits flushed, frames per flush is txflushframes / txflushes */
+   uint64      txflushes;
+   /** frames transmitted by batched flushes */
+   uint64      txflushframes;
+} ec_nicstatt;
+
+/** frames queued on a socket between ecx_txbatch_begin() and ecx_txbatch_flush() */
+typedef struct
+{
+   /** number of queued frames */
+   int         count;
+   /** frame data, only used with ECT_TRANSPORT_SOCKET */
+   struct iovec iov[EC_MAXBUF][EC_TXIOVMAX];
+   /** number of parts of frame data */
+   int         iovcnt[EC_MAXBUF];
+   /** buffer index of queued frames */
+   uint8       idx[EC_MAXBUF];
+} ec_txqueuet;
+
+/** frames one thread collects between ecx_txbatch_begin() and
+ * ecx_txbatch_flush(), used under tx_mutex */
+typedef struct
+{
+   /** TRUE while the batch is open */
+   int         open;
+   /** thread that opened the batch */
+   pthread_t   owner;
+   /** frames queued on the primary socket */
+   ec_txqueuet txqueue;
+   /** frames queued on the secondary socket */
+   ec_txqueuet redqueue;
+   /** copies of the redundancy dummy frame, per entry of redqueue */
+   uint8       txdummy[EC_MAXBUF][EC_TXDUMMYSIZE];
+} ec_txbatcht;
+
+/** wire times of a frame in ns, 0 if not available. Software timestamps are
+ * CLOCK_REALTIME, hardware timestamps are in the clock of the NIC. */
+typedef struct
+{
+   /** software tx timestamp */
+   int64       txsw;
+   /** hardware tx timestamp */
+   int64       txhw;
+   /** software rx timestamp */
+   int64       rxsw;
+   /** hardware rx timestamp */
+   int64       rxhw;
+} ec_frametimet;
+
+/** destination of the payload of a received frame, see ecx_inframe_scatter() */
+typedef struct
+{
+   /** destination, NULL to keep the payload in the rx buffer */
+   uint8       *data;
+   /** offset of payload in frame including ethernet header */
+   uint16      offset;
+   /** length of payload */
+   uint16      length;
+} ec_rxdestt;
+
+/** built in rx buffers of a socket, used for pools of up to EC_MAXBUF frames */
+typedef struct
+{
+   /** rx buffers */
+   ec_bufT     rxbuf[EC_MAXBUF];
+   /** rx buffer status */
+   int         rxbufstat[EC_MAXBUF];
+   /** rx MAC source address */
+   int         rxsa[EC_MAXBUF];
+   /** wire times */
+   ec_frametimet frametime[EC_MAXBUF];
+} ec_rxpoolt;
+
+/** built in tx buffers of a port, used for pools of up to EC_MAXBUF frames */
+typedef struct
+{
+   /** transmit buffers */
+   ec_bufT     txbuf[EC_MAXBUF];
+   /** transmit buffer lengths */
+   int         txbuflength[EC_MAXBUF];
+} ec_txpoolt;
 
 /** pointer structure to Tx and Rx stacks */
 typedef struct
 {
    /** socket connection used */
    int         *sock;
+   /** transport used on socket */
+   int         *transport;
+   /** packet rings, only used with ECT_TRANSPORT_MMAP */
+   ec_ringt    *ring;
+   /** AF_XDP socket, only used with ECT_TRANSPORT_XDP */
+   ec_xskt     *xsk;
+   /** io_uring, only used with ECT_TRANSPORT_URING */
+   ec_uringt   *uring;
+   /** frames not returning from the slaves are dropped in user space */
+   int         *rxsoftfilter;
    /** tx buffer */
-   ec_bufT     (*txbuf)[EC_MAXBUF];
+   ec_bufT     *txbuf;
    /** tx buffer lengths */
-   int         (*txbuflength)[EC_MAXBUF];
+   int         *txbuflength;
    /** temporary receive buffer */
    ec_bufT     *tempbuf;
    /** rx buffers */
-   ec_bufT     (*rxbuf)[EC_MAXBUF];
+   ec_bufT     *rxbuf;
    /** rx buffer status fields */
-   int         (*rxbufstat)[EC_MAXBUF];
+   int         *rxbufstat;
    /** received MAC source address (middle word) */
-   int         (*rxsa)[EC_MAXBUF];
+   int         *rxsa;
+   /** wire times of frames */
+   ec_frametimet *frametime;
 } ec_stackT;
 
 /** pointer structure to buffers for redundant port */
@@ -42,12 +320,28 @@ typedef struct
 {
    ec_stackT   stack;
    int         sockhandle;
-   /** rx buffers */
-   ec_bufT rxbuf[EC_MAXBUF];
+   /** transport used on socket */
+   int         transport;
+   /** packet rings of socket */
+   ec_ringt    ring;
+   /** AF_XDP socket */
+   ec_xskt     xsk;
+   /** io_uring of socket */
+   ec_uringt   uring;
+   /** drop counter map of rx socket filter, -1 if none */
+   int         rxfiltermap;
+   /** TRUE if the rx filter runs in user space, see ecx_rxfilterdrops() */
+   int         rxsoftfilter;
+   /** rx buffers, one per frame index of the primary port */
+   ec_bufT *rxbuf;
    /** rx buffer status */
-   int rxbufstat[EC_MAXBUF];
+   int *rxbufstat;
    /** rx MAC source address */
-   int rxsa[EC_MAXBUF];
+   int *rxsa;
+   /** wire times of frames */
+   ec_frametimet *frametime;
+   /** built in rx buffers */
+   ec_rxpoolt rxpool;
    /** temporary rx buffer */
    ec_bufT tempinbuf;
 } ecx_redportt;
@@ -57,20 +351,43 @@ typedef struct
 {
    ec_stackT   stack;
    int         sockhandle;
-   /** rx buffers */
-   ec_bufT rxbuf[EC_MAXBUF];
+   /** transport used on socket */
+   int         transport;
+   /** packet rings of socket */
+   ec_ringt    ring;
+   /** AF_XDP socket */
+   ec_xskt     xsk;
+   /** io_uring of socket */
+   ec_uringt   uring;
+   /** drop counter map of rx socket filter, -1 if none */
+   int         rxfiltermap;
+   /** TRUE if the rx filter runs in user space, see ecx_rxfilterdrops() */
+   int         rxsoftfilter;
+   /** number of frame buffers and thereby frame indexes. Set before
+    * ecx_setupnic(), 0 selects EC_MAXBUF. Up to EC_MAXBUF the built in
+    * buffers are used, larger pools up to EC_MAXBUFPOOL are allocated.
+    * Read by ecx_setupnic(), so it must not be left uninitialised. */
+   int maxbuf;
+   /** rx buffers, maxbuf entries */
+   ec_bufT *rxbuf;
    /** rx buffer status */
-   int rxbufstat[EC_MAXBUF];
+   int *rxbufstat;
    /** rx MAC source address */
-   int rxsa[EC_MAXBUF];
+   int *rxsa;
+   /** wire times of frames, see ecx_frametime() */
+   ec_frametimet *frametime;
+   /** built in rx buffers */
+   ec_rxpoolt rxpool;
    /** temporary rx buffer */
    ec_bufT tempinbuf;
    /** temporary rx buffer status */
    int tempinbufs;
-   /** transmit buffers */
-   ec_bufT txbuf[EC_MAXBUF];
+   /** transmit buffers, maxbuf entries */
+   ec_bufT *txbuf;
    /** transmit buffer lengths */
-   int txbuflength[EC_MAXBUF];
+   int *txbuflength;
+   /** built in tx buffers */
+   ec_txpoolt txpool;
    /** temporary tx buffer */
    ec_bufT txbuf2;
    /** temporary tx buffer length */
@@ -81,7 +398,48 @@ typedef struct
    int redstate;
    /** pointer to redundancy port and buffers */
    ecx_redportt *redport;
-   pthread_mutex_t getindex_mutex;
+   /** frame and system call counters */
+   ec_nicstatt stats;
+   /** EC_TXBATCHES batched transmits of different threads, allocated by
+    * ecx_setupnic(), see ecx_txbatch_begin() */
+   ec_txbatcht *txbatch;
+   /** ECT_WAIT_SPIN or ECT_WAIT_POLL, see ecx_setwaitmode() */
+   int waitmode;
+   /** drain all pending frames on receive, see ecx_setrxdrain() */
+   int rxdrain;
+   /** EC_MAXBUF receive buffers for drain mode, allocated when drain mode or
+    * the receive thread is started. Used under rx_mutex. */
+   ec_bufT *rxdrainbuf;
+   /** TRUE to transmit process data straight from the IOmap, set FALSE by
+    * ecx_setupnic(), see ecx_outframe_gather() */
+   int txgather;
+   /** TRUE to receive process data straight into the IOmap, set FALSE by
+    * ecx_setupnic(), see ecx_inframe_scatter() */
+   int rxscatter;
+   /** payload destinations of the primary rx buffers, maxbuf entries */
+   ec_rxdestt *rxdest;
+   /** SO_TXTIME is enabled on the sockets, see ecx_settxtime() */
+   int txtime;
+   /** clock of the launch times, see ecx_settxtime() */
+   int txclockid;
+   /** launch time of transmitted frames, see ecx_setlaunchtime() */
+   int64 launchtime;
+   /** set TRUE before ecx_setupnic() to timestamp frames with SO_TIMESTAMPING,
+    * FALSE otherwise, it is read by ecx_setupnic() */
+   int timestamps;
+   /** set TRUE before ecx_setupnic() to receive all EtherCAT frames, without
+    * the rx filter that drops frames not returning from the slaves, FALSE
+    * otherwise, it is read by ecx_setupnic() */
+   int rxfilteroff;
+   /** software and hardware rx timestamp of the frame being sorted */
+   int64 rxtssw;
+   int64 rxtshw;
+   /** receive thread is running, see ecx_startrxthread() */
+   int rxthread;
+   /** request to stop the receive thread */
+   int rxstop;
+   /** receive thread */
+   pthread_t rxthreadid;
    pthread_mutex_t tx_mutex;
    pthread_mutex_t rx_mutex;
 } ecx_portt;
@@ -110,7 +468,22 @@ void ecx_setbufstat(ecx_portt *port, uint8 idx, int bufstat);
 uint8 ecx_getindex(ecx_portt *port);
 int ecx_outframe(ecx_portt *port, uint8 idx, int sock);
 int ecx_outframe_red(ecx_portt *port, uint8 idx);
+int ecx_outframe_gather(ecx_portt *port, uint8 idx, const void *data, int offset, int length);
+int ecx_inframe_scatter(ecx_portt *port, uint8 idx, void *data, int offset, int length);
+void ecx_txbatch_begin(ecx_portt *port);
+int ecx_txbatch_flush(ecx_portt *port);
+void ecx_setrxdrain(ecx_portt *port, int enable);
+int ecx_settxtime(ecx_portt *port, int clockid, int deadline);
+int64 ecx_rxfilterdrops(ecx_portt *port);
+int ecx_getpollfd(ecx_portt *port);
+void ecx_setlaunchtime(ecx_portt *port, int64 launchtime);
+int64 ecx_txclocktime(ecx_portt *port);
+int ecx_setwaitmode(ecx_portt *port, int waitmode, int busypoll);
+int64 ecx_frametime(ecx_portt *port, uint8 idx, ec_frametimet *frametime);
+int ecx_startrxthread(ecx_portt *port);
+void ecx_stoprxthread(ecx_portt *port);
 int ecx_waitinframe(ecx_portt *port, uint8 idx, int timeout);
+int ecx_waitinframe_timer(ecx_portt *port, uint8 idx, osal_timert *timer);
 int ecx_srconfirm(ecx_portt *port, uint8 idx,int timeout);
 
 #ifdef __cplusplus
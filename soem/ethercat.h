@@ -22,5 +22,7 @@
 #include "ethercateoe.h"
 #include "ethercatconfig.h"
 #include "ethercatprint.h"
+#include "ethercatbitio.h"
+#include "ethercatpdo.h"
 
 #endif /* _EC_ETHERCAT_H */
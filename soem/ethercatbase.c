@@ -26,11 +26,11 @@
  * @param[out] datagramdata   = data part of datagram
  * @param[in]  com            = command
  * @param[in]  length         = length of databuffer
- * @param[in]  data           = databuffer to be copied into datagram
+ * @param[in]  data           = databuffer to be copied into datagram, NULL to leave data part as is
  */
 static void ecx_writedatagramdata(void *datagramdata, ec_cmdtype com, uint16 length, const void * data)
 {
-   if (length > 0)
+   if ((length > 0) && data)
    {
       switch (com)
       {
@@ -62,7 +62,8 @@ static void ecx_writedatagramdata(void *datagramdata, ec_cmdtype com, uint16 len
  * @param[in]  ADP         = Address Position
  * @param[in]  ADO         = Address Offset
  * @param[in]  length      = length of datagram excluding EtherCAT header
- * @param[in]  data        = databuffer to be copied in datagram
+ * @param[in]  data        = databuffer to be copied in datagram, NULL to leave
+ *                           the data part for ecx_outframe_gather()
  * @return always 0
  */
 int ecx_setupdatagram(ecx_portt *port, void *frame, uint8 com, uint8 idx, uint16 ADP, uint16 ADO, uint16 length, void *data)
@@ -108,6 +109,7 @@ uint16 ecx_adddatagram(ecx_portt *port, void *frame, uint8 com, uint8 idx, boole
    ec_comt *datagramP;
    uint8 *frameP;
    uint16 prevlength;
+   uint16 last, next;
 
    frameP = frame;
    /* copy previous frame size */
@@ -115,6 +117,15 @@ uint16 ecx_adddatagram(ecx_portt *port, void *frame, uint8 com, uint8 idx, boole
    datagramP = (ec_comt*)&frameP[ETH_HEADERSIZE];
    /* add new datagram to ethernet frame size */
    datagramP->elength = htoes( etohs(datagramP->elength) + EC_HEADERSIZE + length );
+   /* find previous subframe, the frame can hold more than two */
+   last = ETH_HEADERSIZE;
+   next = last + EC_HEADERSIZE + (etohs(datagramP->dlength) & 0x07ff);
+   while (next < prevlength - EC_ELENGTHSIZE)
+   {
+      last = next;
+      datagramP = (ec_comt*)&frameP[last];
+      next = last + EC_HEADERSIZE + (etohs(datagramP->dlength) & 0x07ff);
+   }
    /* add "datagram follows" flag to previous subframe dlength */
    datagramP->dlength = htoes( etohs(datagramP->dlength) | EC_DATAGRAMFOLLOWS );
    /* set new EtherCAT header position */
@@ -189,6 +200,10 @@ int ecx_BRD(ecx_portt *port, uint16 ADP, uint16 ADO, uint16 length, void *data,
 
    /* get fresh index */
    idx = ecx_getindex(port);
+   if (idx == EC_NOINDEX)
+   {
+      return EC_NOFRAME;
+   }
    /* setup datagram */
    ecx_setupdatagram(port, &(port->txbuf[idx]), EC_CMD_BRD, idx, ADP, ADO, length, data);
    /* send data and wait for answer */
@@ -220,6 +235,10 @@ int ecx_APRD(ecx_portt *port, uint16 ADP, uint16 ADO, uint16 length, void *data,
    uint8 idx;
 
    idx = ecx_getindex(port);
+   if (idx == EC_NOINDEX)
+   {
+      return EC_NOFRAME;
+   }
    ecx_setupdatagram(port, &(port->txbuf[idx]), EC_CMD_APRD, idx, ADP, ADO, length, data);
    wkc = ecx_srconfirm(port, idx, timeout);
    if (wkc > 0)
@@ -248,6 +267,10 @@ int ecx_ARMW(ecx_portt *port, uint16 ADP, uint16 ADO, uint16 length, void *data,
    uint8 idx;
 
    idx = ecx_getindex(port);
+   if (idx == EC_NOINDEX)
+   {
+      return EC_NOFRAME;
+   }
    ecx_setupdatagram(port, &(port->txbuf[idx]), EC_CMD_ARMW, idx, ADP, ADO, length, data);
    wkc = ecx_srconfirm(port, idx, timeout);
    if (wkc > 0)
@@ -276,6 +299,10 @@ int ecx_FRMW(ecx_portt *port, uint16 ADP, uint16 ADO, uint16 length, void *data,
    uint8 idx;
 
    idx = ecx_getindex(port);
+   if (idx == EC_NOINDEX)
+   {
+      return EC_NOFRAME;
+   }
    ecx_setupdatagram(port, &(port->txbuf[idx]), EC_CMD_FRMW, idx, ADP, ADO, length, data);
    wkc = ecx_srconfirm(port, idx, timeout);
    if (wkc > 0)
@@ -321,6 +348,10 @@ int ecx_FPRD(ecx_portt *port, uint16 ADP, uint16 ADO, uint16 length, void *data,
    uint8 idx;
 
    idx = ecx_getindex(port);
+   if (idx == EC_NOINDEX)
+   {
+      return EC_NOFRAME;
+   }
    ecx_setupdatagram(port, &(port->txbuf[idx]), EC_CMD_FPRD, idx, ADP, ADO, length, data);
    wkc = ecx_srconfirm(port, idx, timeout);
    if (wkc > 0)
@@ -365,6 +396,10 @@ int ecx_APWR(ecx_portt *port, uint16 ADP, uint16 ADO, uint16 length, void *data,
    int wkc;
 
    idx = ecx_getindex(port);
+   if (idx == EC_NOINDEX)
+   {
+      return EC_NOFRAME;
+   }
    ecx_setupdatagram(port, &(port->txbuf[idx]), EC_CMD_APWR, idx, ADP, ADO, length, data);
    wkc = ecx_srconfirm(port, idx, timeout);
    ecx_setbufstat(port, idx, EC_BUF_EMPTY);
@@ -402,6 +437,10 @@ int ecx_FPWR(ecx_portt *port, uint16 ADP, uint16 ADO, uint16 length, void *data,
    uint8 idx;
 
    idx = ecx_getindex(port);
+   if (idx == EC_NOINDEX)
+   {
+      return EC_NOFRAME;
+   }
    ecx_setupdatagram(port, &(port->txbuf[idx]), EC_CMD_FPWR, idx, ADP, ADO, length, data);
    wkc = ecx_srconfirm(port, idx, timeout);
    ecx_setbufstat(port, idx, EC_BUF_EMPTY);
@@ -438,6 +477,10 @@ int ecx_LRW(ecx_portt *port, uint32 LogAdr, uint16 length, void *data, int timeo
    int wkc;
 
    idx = ecx_getindex(port);
+   if (idx == EC_NOINDEX)
+   {
+      return EC_NOFRAME;
+   }
    ecx_setupdatagram(port, &(port->txbuf[idx]), EC_CMD_LRW, idx, LO_WORD(LogAdr), HI_WORD(LogAdr), length, data);
    wkc = ecx_srconfirm(port, idx, timeout);
    if ((wkc > 0) && (port->rxbuf[idx][EC_CMDOFFSET] == EC_CMD_LRW))
@@ -464,6 +507,10 @@ int ecx_LRD(ecx_portt *port, uint32 LogAdr, uint16 length, void *data, int timeo
    int wkc;
 
    idx = ecx_getindex(port);
+   if (idx == EC_NOINDEX)
+   {
+      return EC_NOFRAME;
+   }
    ecx_setupdatagram(port, &(port->txbuf[idx]), EC_CMD_LRD, idx, LO_WORD(LogAdr), HI_WORD(LogAdr), length, data);
    wkc = ecx_srconfirm(port, idx, timeout);
    if ((wkc > 0) && (port->rxbuf[idx][EC_CMDOFFSET]==EC_CMD_LRD))
@@ -490,6 +537,10 @@ int ecx_LWR(ecx_portt *port, uint32 LogAdr, uint16 length, void *data, int timeo
    int wkc;
 
    idx = ecx_getindex(port);
+   if (idx == EC_NOINDEX)
+   {
+      return EC_NOFRAME;
+   }
    ecx_setupdatagram(port, &(port->txbuf[idx]), EC_CMD_LWR, idx, LO_WORD(LogAdr), HI_WORD(LogAdr), length, data);
    wkc = ecx_srconfirm(port, idx, timeout);
    ecx_setbufstat(port, idx, EC_BUF_EMPTY);
@@ -517,6 +568,10 @@ int ecx_LRWDC(ecx_portt *port, uint32 LogAdr, uint16 length, void *data, uint16
    uint64 DCtE;
 
    idx = ecx_getindex(port);
+   if (idx == EC_NOINDEX)
+   {
+      return EC_NOFRAME;
+   }
    /* LRW in first datagram */
    ecx_setupdatagram(port, &(port->txbuf[idx]), EC_CMD_LRW, idx, LO_WORD(LogAdr), HI_WORD(LogAdr), length, data);
    /* FPRMW in second datagram */
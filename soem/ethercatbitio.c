@@ -0,0 +1,297 @@
+/*
+ * Licensed under the GNU General Public License version 2 with exceptions. See
+ * LICENSE file in the project root for full license information
+ */
+
+/** \file
+ * \brief
+ * Bit IO functions.
+ *
+ * Digital IO slaves with less than 8 bits share IOmap bytes, with wider ones
+ * every channel is still a single bit. These functions copy all channels of
+ * a group between the IOmap and a dense array with one byte per channel in
+ * one pass, so the application does not have to unpack them bit by bit.
+ * Consecutive bits of neighbouring slaves are handled as one run, whole
+ * bytes of a run are expanded or packed 8 or 16 bits at a time.
+ */
+#include <string.h>
+#include "oshw.h"
+#include "osal.h"
+#include "ethercattype.h"
+#include "ethercatbase.h"
+#include "ethercatmain.h"
+#include "ethercatbitio.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#include <emmintrin.h>
+#define EC_BITIO_SSE2
+#endif
+
+/** byte k of a 64 bit word set to bit k of a byte */
+#define EC_BITIO_SPREAD    0x0101010101010101ULL
+#define EC_BITIO_BITMASK   0x8040201008040201ULL
+#define EC_BITIO_LOW7      0x7f7f7f7f7f7f7f7fULL
+#define EC_BITIO_GATHER    0x0102040810204080ULL
+
+/** Expand the bits of a byte to 8 bytes of 0 or 1.
+ * @param[in]  b              = byte
+ * @return bytes, byte k in the bits 8k..8k+7
+ */
+static uint64 ec_expandbyte(uint8 b)
+{
+   uint64 x;
+
+   x = ((uint64)b * EC_BITIO_SPREAD) & EC_BITIO_BITMASK;
+   /* non zero bytes to 1 */
+   return ((x + EC_BITIO_LOW7) >> 7) & EC_BITIO_SPREAD;
+}
+
+/** Pack 8 bytes to the bits of a byte, non zero is a set bit.
+ * @param[in]  x              = bytes, byte k in the bits 8k..8k+7
+ * @return byte
+ */
+static uint8 ec_packbyte(uint64 x)
+{
+   /* non zero bytes to 1 */
+   x = ((((x & EC_BITIO_LOW7) + EC_BITIO_LOW7) | x) >> 7) & EC_BITIO_SPREAD;
+   return (uint8)((x * EC_BITIO_GATHER) >> 56);
+}
+
+/** Copy a run of bits from the IOmap to channels.
+ * @param[in]  src            = IOmap byte of first bit
+ * @param[in]  bit            = first bit in src
+ * @param[in]  n              = number of bits
+ * @param[out] dst            = channels
+ */
+static void ec_gatherrun(const uint8 *src, uint8 bit, uint32 n, uint8 *dst)
+{
+   uint64 x;
+
+   /* leading bits up to a byte boundary */
+   while (n && bit)
+   {
+      *dst++ = (*src >> bit) & 0x01;
+      n--;
+      if (++bit == 8)
+      {
+         bit = 0;
+         src++;
+      }
+   }
+#ifdef EC_BITIO_SSE2
+   {
+      const __m128i mask = _mm_set_epi8(-128, 64, 32, 16, 8, 4, 2, 1, -128, 64, 32, 16, 8, 4, 2, 1);
+      const __m128i one = _mm_set1_epi8(1);
+      __m128i v;
+
+      while (n >= 16)
+      {
+         /* first byte in the low, second in the high half */
+         v = _mm_unpacklo_epi64(_mm_set1_epi8((char)src[0]), _mm_set1_epi8((char)src[1]));
+         v = _mm_cmpeq_epi8(_mm_and_si128(v, mask), mask);
+         _mm_storeu_si128((__m128i *)dst, _mm_and_si128(v, one));
+         src += 2;
+         dst += 16;
+         n -= 16;
+      }
+   }
+#endif
+   while (n >= 8)
+   {
+      x = htoell(ec_expandbyte(*src++));
+      memcpy(dst, &x, sizeof(x));
+      dst += 8;
+      n -= 8;
+   }
+   /* trailing bits */
+   while (n)
+   {
+      *dst++ = (*src >> bit++) & 0x01;
+      n--;
+   }
+}
+
+/** Copy a run of channels to bits in the IOmap, other bits are kept.
+ * @param[in]  src            = channels
+ * @param[out] dst            = IOmap byte of first bit
+ * @param[in]  bit            = first bit in dst
+ * @param[in]  n              = number of bits
+ */
+static void ec_scatterrun(const uint8 *src, uint8 *dst, uint8 bit, uint32 n)
+{
+   uint64 x;
+
+   /* leading bits up to a byte boundary */
+   while (n && bit)
+   {
+      if (*src++)
+      {
+         *dst |= (uint8)(1 << bit);
+      }
+      else
+      {
+         *dst &= (uint8)~(1 << bit);
+      }
+      n--;
+      if (++bit == 8)
+      {
+         bit = 0;
+         dst++;
+      }
+   }
+#ifdef EC_BITIO_SSE2
+   {
+      const __m128i zero = _mm_setzero_si128();
+      int m;
+
+      while (n >= 16)
+      {
+         m = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)src), zero)) ^ 0xffff;
+         dst[0] = (uint8)m;
+         dst[1] = (uint8)(m >> 8);
+         src += 16;
+         dst += 2;
+         n -= 16;
+      }
+   }
+#endif
+   while (n >= 8)
+   {
+      memcpy(&x, src, sizeof(x));
+      *dst++ = ec_packbyte(etohll(x));
+      src += 8;
+      n -= 8;
+   }
+   /* trailing bits */
+   while (n)
+   {
+      if (*src++)
+      {
+         *dst |= (uint8)(1 << bit);
+      }
+      else
+      {
+         *dst &= (uint8)~(1 << bit);
+      }
+      bit++;
+      n--;
+   }
+}
+
+/** Build the channel mapping of the bit IO of a group. Slaves with 1 up to
+ * maxbits output or input bits contribute their bits as channels, in slave
+ * order. Rebuild it after the IOmap is configured again. With maxbits above 7
+ * the slaves of 8 bits and more are included. They start on a byte and break
+ * the run of the slave before them, so every such slave costs a run and the
+ * leading and trailing bits of its neighbours are copied one at a time.
+ * @param[in]  context        = context struct
+ * @param[in]  group          = group number, 0 for all groups
+ * @param[in]  outputs        = TRUE for the outputs, FALSE for the inputs
+ * @param[in]  maxbits        = max. bits of a slave, 7 for the bit packed slaves only
+ * @param[in,out] map         = mapping, run and maxruns set by the caller
+ * @param[out] firstchannel   = first channel of each slave, indexed by slave
+ *                              number, NULL if not needed
+ * @return number of channels, -1 if the run array is too small.
+ */
+int ecx_bitmap_init(ecx_contextt *context, uint8 group, boolean outputs, uint16 maxbits, ec_bitmapt *map,
+   uint32 *firstchannel)
+{
+   ec_slavet *sl;
+   ec_bitrunt *run;
+   uint32 bitoffset;
+   uint16 bits;
+   int slave;
+
+   map->base = outputs ? context->grouplist[group].outputs : context->grouplist[group].inputs;
+   map->nruns = 0;
+   map->nchannels = 0;
+   for (slave = 1; slave <= *(context->slavecount); slave++)
+   {
+      sl = &(context->slavelist[slave]);
+      bits = outputs ? sl->Obits : sl->Ibits;
+      if ((!group || (group == sl->group)) && bits && (bits <= maxbits))
+      {
+         if (outputs)
+         {
+            bitoffset = (uint32)((sl->outputs - map->base) * 8 + sl->Ostartbit);
+         }
+         else
+         {
+            bitoffset = (uint32)((sl->inputs - map->base) * 8 + sl->Istartbit);
+         }
+         if (firstchannel)
+         {
+            firstchannel[slave] = map->nchannels;
+         }
+         /* bits following the previous slave extend its run */
+         if (map->nruns &&
+             ((map->run[map->nruns - 1].bitoffset + map->run[map->nruns - 1].nbits) == bitoffset))
+         {
+            map->run[map->nruns - 1].nbits += bits;
+         }
+         else
+         {
+            if (map->nruns >= map->maxruns)
+            {
+               return -1;
+            }
+            run = &(map->run[map->nruns++]);
+            run->bitoffset = bitoffset;
+            run->nbits = bits;
+         }
+         map->nchannels += bits;
+      }
+   }
+   return (int)map->nchannels;
+}
+
+/** Copy all channels of a mapping from the IOmap to a dense array.
+ * @param[in]  map            = mapping made by ecx_bitmap_init()
+ * @param[out] channels       = one byte per channel, 0 or 1, map->nchannels long
+ */
+void ec_bitgather(const ec_bitmapt *map, uint8 *channels)
+{
+   const ec_bitrunt *run;
+   int i;
+
+   for (i = 0; i < map->nruns; i++)
+   {
+      run = &(map->run[i]);
+      ec_gatherrun(map->base + (run->bitoffset >> 3), (uint8)(run->bitoffset & 0x07), run->nbits, channels);
+      channels += run->nbits;
+   }
+}
+
+/** Copy all channels of a mapping from a dense array to the IOmap. Bits of
+ * the IOmap outside the mapping are kept.
+ * @param[in]  map            = mapping made by ecx_bitmap_init()
+ * @param[in]  channels       = one byte per channel, non zero is on, map->nchannels long
+ */
+void ec_bitscatter(const ec_bitmapt *map, const uint8 *channels)
+{
+   const ec_bitrunt *run;
+   int i;
+
+   for (i = 0; i < map->nruns; i++)
+   {
+      run = &(map->run[i]);
+      ec_scatterrun(channels, map->base + (run->bitoffset >> 3), (uint8)(run->bitoffset & 0x07), run->nbits);
+      channels += run->nbits;
+   }
+}
+
+#ifdef EC_VER1
+/** Build the channel mapping of the bit IO of a group.
+ * @param[in]  group          = group number, 0 for all groups
+ * @param[in]  outputs        = TRUE for the outputs, FALSE for the inputs
+ * @param[in]  maxbits        = max. bits of a slave, 7 for the bit packed slaves only
+ * @param[in,out] map         = mapping, run and maxruns set by the caller
+ * @param[out] firstchannel   = first channel of each slave, NULL if not needed
+ * @return number of channels, -1 if the run array is too small.
+ * @see ecx_bitmap_init
+ */
+int ec_bitmap_init(uint8 group, boolean outputs, uint16 maxbits, ec_bitmapt *map, uint32 *firstchannel)
+{
+   return ecx_bitmap_init(&ecx_context, group, outputs, maxbits, map, firstchannel);
+}
+#endif
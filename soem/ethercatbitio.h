@@ -0,0 +1,57 @@
+/*
+ * Licensed under the GNU General Public License version 2 with exceptions. See
+ * LICENSE file in the project root for full license information
+ */
+
+/** \file
+ * \brief
+ * Headerfile for ethercatbitio.c
+ */
+
+#ifndef _EC_ECATBITIO_H
+#define _EC_ECATBITIO_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/** run of consecutive bits in the IOmap, of one or more slaves */
+typedef struct ec_bitrun
+{
+   /** offset of the first bit from the base of the map */
+   uint32           bitoffset;
+   /** number of bits */
+   uint32           nbits;
+} ec_bitrunt;
+
+/** Mapping of the bit IO of a group to a dense array with one byte per
+ * bit, the channels. Built once after the IOmap is configured. */
+typedef struct ec_bitmap
+{
+   /** IOmap position the runs are relative to */
+   uint8            *base;
+   /** runs in channel order, array provided by the caller */
+   ec_bitrunt       *run;
+   /** size of the run array */
+   int              maxruns;
+   /** runs in use */
+   int              nruns;
+   /** number of channels, the size of the dense array */
+   uint32           nchannels;
+} ec_bitmapt;
+
+#ifdef EC_VER1
+int ec_bitmap_init(uint8 group, boolean outputs, uint16 maxbits, ec_bitmapt *map, uint32 *firstchannel);
+#endif
+
+int ecx_bitmap_init(ecx_contextt *context, uint8 group, boolean outputs, uint16 maxbits, ec_bitmapt *map,
+   uint32 *firstchannel);
+void ec_bitgather(const ec_bitmapt *map, uint8 *channels);
+void ec_bitscatter(const ec_bitmapt *map, const uint8 *channels);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _EC_ECATBITIO_H */
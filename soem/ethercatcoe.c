@@ -18,6 +18,7 @@
 #include "ethercatbase.h"
 #include "ethercatmain.h"
 #include "ethercatcoe.h"
+#include "ethercatpdo.h"
 
 /** SDO structure, not to be confused with EcSDOserviceT */
 PACKED_BEGIN
@@ -710,6 +711,8 @@ uint32 ecx_readPDOassign(ecx_contextt *context, uint16 Slave, uint16 PDOassign)
                /* read SDO that is mapped in PDO */
                wkc = ecx_SDOread(context, Slave, idx, (uint8)subidxloop, FALSE, &rdl, &rdat2, EC_TIMEOUTRXM);
                rdat2 = etohl(rdat2);
+               ecx_addPDOentry(context, Slave, idx, (uint8)(PDOassign - ECT_SDO_PDOASSIGN),
+                  context->slavelist[Slave].SMtype[PDOassign - ECT_SDO_PDOASSIGN] == 3, (uint32)rdat2);
                /* extract bitlength of SDO */
                if (LO_BYTE(rdat2) < 0xff)
                {
@@ -771,6 +774,9 @@ uint32 ecx_readPDOassignCA(ecx_contextt *context, uint16 Slave, int Thread_n,
             for (subidxloop = 1; subidxloop <= subidx; subidxloop++)
             {
                bsize += LO_BYTE(etohl(context->PDOdesc[Thread_n].PDO[subidxloop -1]));
+               ecx_addPDOentry(context, Slave, idx, (uint8)(PDOassign - ECT_SDO_PDOASSIGN),
+                  context->slavelist[Slave].SMtype[PDOassign - ECT_SDO_PDOASSIGN] == 3,
+                  etohl(context->PDOdesc[Thread_n].PDO[subidxloop -1]));
             }
          }
       }
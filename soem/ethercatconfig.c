@@ -21,6 +21,7 @@
 #include "ethercatcoe.h"
 #include "ethercatsoe.h"
 #include "ethercatconfig.h"
+#include "ethercatpdo.h"
 
 
 typedef struct
@@ -75,6 +76,11 @@ typedef const struct
 #define EC_DEFAULTMBXSM1  0x00010022
 /** standard SM0 flags configuration for digital output slaves */
 #define EC_DEFAULTDOSM0   0x00010044
+/** slaves of a group laid out by the planner: all of them, all but the input
+ * only slaves, the input only slaves */
+#define EC_PLAN_ALL          0
+#define EC_PLAN_NOINPUTONLY  1
+#define EC_PLAN_INPUTONLY    2
 
 #ifdef EC_VER1
 /** Find slave in standard configuration list ec_configlist[]
@@ -106,7 +112,14 @@ void ecx_init_context(ecx_contextt *context)
    *(context->slavecount) = 0;
    /* clean ec_slave array */
    memset(context->slavelist, 0x00, sizeof(ec_slavet) * context->maxslave);
+   ecx_free_groups(context);
    memset(context->grouplist, 0x00, sizeof(ec_groupt) * context->maxgroup);
+   if (context->slavecyclic)
+   {
+      memset(context->slavecyclic, 0x00, sizeof(ec_slavecyclict) * context->maxslave);
+   }
+   context->nPDOentry = 0;
+   context->PDOentryslave = 0;
    /* clear slave eeprom cache, does not actually read any eeprom */
    ecx_siigetbyte(context, 0, EC_MAXEEPBUF);
    for(lp = 0; lp < context->maxgroup; lp++)
@@ -133,6 +146,11 @@ int ecx_detect_slaves(ecx_contextt *context)
    wkc = ecx_BRD(context->port, 0x0000, ECT_REG_TYPE, sizeof(w), &w, EC_TIMEOUTSAFE);  /* detect number of slaves */
    if (wkc > 0)
    {
+      /* grow the slavelist of a context made by ecx_create_context */
+      if ((wkc >= context->maxslave) && context->ownslavelist)
+      {
+         ecx_resize_slavelist(context, wkc + 1);
+      }
       /* this is strictly "less than" since the master is "slave 0" */
       if (wkc < context->maxslave)
       {
@@ -600,6 +618,7 @@ int ecx_config_init(ecx_contextt *context, uint8 usetable)
                EC_TIMEOUTRET3); /* set preop status */
          }
       }
+      ecx_update_slavecyclic(context);
    }
    return wkc;
 }
@@ -631,6 +650,7 @@ static int ecx_lookup_mapping(ecx_contextt *context, uint16 slave, uint32 *Osize
          *Isize = context->slavelist[i].Ibits;
          context->slavelist[slave].Obits = (uint16)*Osize;
          context->slavelist[slave].Ibits = (uint16)*Isize;
+         ecx_copyPDOentries(context, slave, (uint16)i);
          EC_PRINT("Copy mapping slave %d from %d.\n", slave, i);
          return 1;
       }
@@ -667,14 +687,17 @@ static int ecx_map_coe_soe(ecx_contextt *context, uint16 slave, int thread_n)
          rval = 0;
          if (context->slavelist[slave].CoEdetails & ECT_COEDET_SDOCA) /* has Complete Access */
          {
+            ecx_beginPDOentries(context, slave);
             /* read PDO mapping via CoE and use Complete Access */
             rval = ecx_readPDOmapCA(context, slave, thread_n, &Osize, &Isize);
          }
          if (!rval) /* CA not available or not succeeded */
          {
+            ecx_beginPDOentries(context, slave);
             /* read PDO mapping via CoE */
             rval = ecx_readPDOmap(context, slave, &Osize, &Isize);
          }
+         ecx_beginPDOentries(context, 0);
          EC_PRINT("  CoE Osize:%u Isize:%u\n", Osize, Isize);
       }
       if ((!Isize && !Osize) && (context->slavelist[slave].mbx_proto & ECT_MBXPROT_SOE)) /* has SoE */
@@ -708,6 +731,7 @@ static int ecx_map_sii(ecx_contextt *context, uint16 slave)
    if (!Isize && !Osize) /* find PDO mapping by SII */
    {
       memset(&eepPDO, 0, sizeof(eepPDO));
+      ecx_beginPDOentries(context, slave);
       Isize = ecx_siiPDO(context, slave, &eepPDO, 0);
       EC_PRINT("  SII Isize:%u\n", Isize);
       for( nSM=0 ; nSM < EC_MAXSM ; nSM++ )
@@ -730,6 +754,7 @@ static int ecx_map_sii(ecx_contextt *context, uint16 slave)
             EC_PRINT("    SM%d length %d\n", nSM, eepPDO.SMbitsize[nSM]);
          }
       }
+      ecx_beginPDOentries(context, 0);
    }
    context->slavelist[slave].Obits = (uint16)Osize;
    context->slavelist[slave].Ibits = (uint16)Isize;
@@ -845,32 +870,45 @@ static void ecx_config_find_mappings(ecx_contextt *context, uint8 group)
 {
    int thrn, thrc;
    uint16 slave;
+#if EC_MAX_MAPT > 1
+   boolean threaded;
+#endif
 
    for (thrn = 0; thrn < EC_MAX_MAPT; thrn++)
    {
       ecx_mapt[thrn].running = 0;
    }
+#if EC_MAX_MAPT > 1
+   /* the threads record PDO entries apart, merged here when they are done */
+   threaded = ecx_startPDOthreads(context, EC_MAX_MAPT);
+#endif
    /* find CoE and SoE mapping of slaves in multiple threads */
    for (slave = 1; slave <= *(context->slavecount); slave++)
    {
       if (!group || (group == context->slavelist[slave].group))
       {
 #if EC_MAX_MAPT > 1
+         if (threaded)
+         {
             /* multi-threaded version */
             while ((thrn = ecx_find_mapt()) < 0)
             {
                osal_usleep(1000);
             }
+            ecx_mergePDOentries(context, thrn, slave);
             ecx_mapt[thrn].context = context;
             ecx_mapt[thrn].slave = slave;
             ecx_mapt[thrn].thread_n = thrn;
             ecx_mapt[thrn].running = 1;
             osal_thread_create(&(ecx_threadh[thrn]), 128000,
                &ecx_mapper_thread, &(ecx_mapt[thrn]));
-#else
+         }
+         else
+#endif
+         {
             /* serialised version */
             ecx_map_coe_soe(context, slave, 0);
-#endif
+         }
       }
    }
    /* wait for all threads to finish */
@@ -882,6 +920,9 @@ static void ecx_config_find_mappings(ecx_contextt *context, uint8 group)
          osal_usleep(1000);
       }
    } while (thrc);
+#if EC_MAX_MAPT > 1
+   ecx_finishPDOthreads(context, EC_MAX_MAPT);
+#endif
    /* find SII mapping of slave and program SM */
    for (slave = 1; slave <= *(context->slavecount); slave++)
    {
@@ -1175,6 +1216,420 @@ static void ecx_config_create_output_mappings(ecx_contextt *context, void *pIOma
       context->grouplist[group].outputsWKC++;
 }
 
+/** Add the process data of one slave to the segment layout of a group.
+ * Segments are cut at slave boundaries and filled as far as a frame allows,
+ * which gives the fewest frames for the slave order. One frame of a cycle
+ * carries the FRMW with the DC time, so room for it is kept only in segment
+ * DCsegment, see ecx_config_layout_dc(). When that is segment 0 room is also
+ * kept in the inputs of segment Isegment that lead the LRD frames when LRW is
+ * blocked.
+ * @param[in,out] grp         = group being mapped
+ * @param[in,out] currentsegment = segment being filled
+ * @param[in,out] segmentsize = size of segment being filled
+ * @param[in]  diff           = size of the process data of the slave
+ * @param[in]  inputs         = TRUE if the data is in the input area of the IOmap
+ */
+static void ecx_config_add_segment(ec_groupt *grp, uint16 *currentsegment,
+   uint32 *segmentsize, uint32 diff, boolean inputs)
+{
+   uint32 limit = EC_MAXLRWDATA;
+
+   if (*currentsegment == grp->DCsegment)
+   {
+      limit -= EC_FIRSTDCDATAGRAM;
+   }
+   else if (inputs && (grp->DCsegment == 0) && (*currentsegment == grp->Isegment) &&
+            (grp->Ioffset < EC_FIRSTDCDATAGRAM))
+   {
+      limit -= EC_FIRSTDCDATAGRAM - grp->Ioffset;
+   }
+   if ((*segmentsize + diff) > limit)
+   {
+      grp->IOsegment[*currentsegment] = *segmentsize;
+      if (*currentsegment < (grp->maxsegments - 1))
+      {
+         (*currentsegment)++;
+         *segmentsize = diff;
+      }
+   }
+   else
+   {
+      *segmentsize += diff;
+   }
+}
+
+/** Allocate the segment table of a group, sized by context->maxsegments.
+ *
+ * @param[in]  context        = context struct
+ * @param[in]  group          = group number
+ * @return 1 if the table is available, 0 if out of memory
+ */
+static int ecx_config_alloc_segments(ecx_contextt *context, uint8 group)
+{
+   ec_groupt *grp = &(context->grouplist[group]);
+   int wanted = (context->maxsegments > 0) ? context->maxsegments : EC_MAXIOSEGMENTS;
+
+   if (wanted > 0xffff)
+   {
+      wanted = 0xffff;
+   }
+   if ((grp->IOsegment == NULL) || (grp->maxsegments != wanted))
+   {
+      if (grp->IOsegment)
+      {
+         osal_free(grp->IOsegment);
+      }
+      grp->IOsegment = (uint32 *)osal_malloc(wanted * sizeof(uint32));
+      if (grp->IOsegment == NULL)
+      {
+         grp->maxsegments = 0;
+         return 0;
+      }
+      grp->maxsegments = (uint16)wanted;
+      context->groupalloc = TRUE;
+   }
+   return 1;
+}
+
+/** Count the frames of a process data cycle of a mapped group, as
+ * transmitted by ecx_send_processdata_group().
+ *
+ * @param[in]  grp            = mapped group
+ * @param[in]  overlap        = TRUE for the overlapping IOmap
+ * @param[out] bytes          = process data bytes of the cycle, NULL if not needed
+ * @return number of frames
+ */
+static uint16 ecx_config_count_frames(const ec_groupt *grp, boolean overlap, uint32 *bytes)
+{
+   int32 length;
+   uint32 sublength;
+   uint32 total = 0;
+   uint16 currentsegment;
+   uint16 frames = 0;
+
+   if (grp->blockLRW)
+   {
+      /* a LRD per input segment and a LWR per output segment */
+      if (grp->Ibytes)
+      {
+         currentsegment = grp->Isegment;
+         length = grp->Ibytes;
+         do
+         {
+            sublength = grp->IOsegment[currentsegment];
+            if (currentsegment++ == grp->Isegment)
+            {
+               sublength -= grp->Ioffset;
+            }
+            total += sublength;
+            length -= sublength;
+            frames++;
+         } while ((length > 0) && (currentsegment < grp->nsegments));
+      }
+      if (grp->Obytes)
+      {
+         currentsegment = 0;
+         length = grp->Obytes;
+         do
+         {
+            sublength = grp->IOsegment[currentsegment++];
+            if ((int32)sublength > length)
+            {
+               sublength = length;
+            }
+            total += sublength;
+            length -= sublength;
+            frames++;
+         } while ((length > 0) && (currentsegment < grp->nsegments));
+      }
+   }
+   else if (grp->Obytes || grp->Ibytes)
+   {
+      /* a LRW per segment */
+      if (overlap)
+      {
+         length = (grp->Obytes > grp->Ibytes) ? grp->Obytes : grp->Ibytes;
+      }
+      else
+      {
+         length = grp->Obytes + grp->Ibytes;
+      }
+      currentsegment = 0;
+      do
+      {
+         sublength = grp->IOsegment[currentsegment++];
+         total += sublength;
+         length -= sublength;
+         frames++;
+      } while ((length > 0) && (currentsegment < grp->nsegments));
+   }
+   if (bytes)
+   {
+      *bytes = total;
+   }
+
+   return frames;
+}
+
+/** Advance the logical address over the process data of one slave, as the
+ * FMMU mapping does: bit oriented slaves are packed, byte oriented slaves
+ * start on a byte boundary.
+ *
+ * @param[in,out] LogAddr = logical address
+ * @param[in,out] BitPos  = bit in the byte at the logical address
+ * @param[in]  bits       = process data bits of the slave
+ * @param[in]  bytes      = process data bytes of the slave, 0 if bit oriented
+ */
+static void ecx_config_plan_slave(uint32 *LogAddr, uint8 *BitPos, uint32 bits, uint32 bytes)
+{
+   if (!bytes)
+   {
+      *BitPos += (uint8)(bits - 1);
+      if (*BitPos > 7)
+      {
+         *LogAddr += 1;
+         *BitPos -= 8;
+      }
+      *BitPos += 1;
+      if (*BitPos > 7)
+      {
+         *LogAddr += 1;
+         *BitPos -= 8;
+      }
+   }
+   else
+   {
+      if (*BitPos)
+      {
+         *LogAddr += 1;
+         *BitPos = 0;
+      }
+      *LogAddr += bytes;
+   }
+}
+
+/** Check if a slave is part of the layout being planned.
+ *
+ * @param[in]  sl         = slave
+ * @param[in]  group      = group planned, 0 = all groups
+ * @param[in]  part       = EC_PLAN_ALL, EC_PLAN_NOINPUTONLY or EC_PLAN_INPUTONLY
+ * @return TRUE if the slave is laid out
+ */
+static boolean ecx_config_plan_member(const ec_slavet *sl, uint8 group, int part)
+{
+   boolean inputonly = (sl->Ibits && !sl->Obits);
+
+   if (group && (group != sl->group))
+   {
+      return FALSE;
+   }
+   if (part == EC_PLAN_NOINPUTONLY)
+   {
+      return !inputonly;
+   }
+   if (part == EC_PLAN_INPUTONLY)
+   {
+      return inputonly;
+   }
+   return TRUE;
+}
+
+/** Lay out the IO segments of a group as the mapping functions would with the
+ * current Obits, Obytes, Ibits and Ibytes of the slaves, without mapping it.
+ * The layout is stored in grp, whose IOsegment table and DCsegment are set by
+ * the caller. Slaves and grouplist are left untouched.
+ *
+ * @param[in]  context    = context struct
+ * @param[in]  group      = group to lay out, 0 = all groups
+ * @param[in,out] grp     = resulting layout
+ * @param[in]  overlap    = TRUE for the overlapping IOmap
+ * @param[in]  forceByteAlignment = TRUE to byte align every slave, sequential IOmap only
+ * @param[in]  part       = slaves laid out, EC_PLAN_ALL, EC_PLAN_NOINPUTONLY or EC_PLAN_INPUTONLY
+ * @param[out] bytes      = process data bytes of a cycle
+ * @return frames per process data cycle
+ */
+static uint16 ecx_config_layout(ecx_contextt *context, uint8 group, ec_groupt *grp,
+   boolean overlap, boolean forceByteAlignment, int part, uint32 *bytes)
+{
+   ec_slavet *sl;
+   uint16 slave;
+   uint8 BitPos = 0;
+   uint32 LogAddr = 0;
+   uint32 oLogAddr = 0;
+   uint32 siLogAddr, soLogAddr;
+   uint16 currentsegment = 0;
+   uint32 segmentsize = 0;
+
+   grp->Obytes = 0;
+   grp->Ibytes = 0;
+   grp->Isegment = 0;
+   grp->Ioffset = 0;
+   grp->blockLRW = 0;
+   grp->hasdc = FALSE;
+   if (overlap)
+   {
+      for (slave = 1; slave <= *(context->slavecount); slave++)
+      {
+         sl = &(context->slavelist[slave]);
+         siLogAddr = soLogAddr = LogAddr;
+         if (ecx_config_plan_member(sl, group, part))
+         {
+            if (sl->Obits)
+            {
+               ecx_config_plan_slave(&soLogAddr, &BitPos, sl->Obits, sl->Obytes);
+               if (BitPos)
+               {
+                  soLogAddr++;
+                  BitPos = 0;
+               }
+            }
+            if (sl->Ibits)
+            {
+               ecx_config_plan_slave(&siLogAddr, &BitPos, sl->Ibits, sl->Ibytes);
+               if (BitPos)
+               {
+                  siLogAddr++;
+                  BitPos = 0;
+               }
+            }
+            oLogAddr = (siLogAddr > soLogAddr) ? siLogAddr : soLogAddr;
+            ecx_config_add_segment(grp, &currentsegment, &segmentsize, oLogAddr - LogAddr, FALSE);
+            LogAddr = oLogAddr;
+            grp->blockLRW += sl->blockLRW ? 1 : 0;
+            grp->hasdc |= sl->hasdc;
+            grp->Obytes = soLogAddr;
+            grp->Ibytes = siLogAddr;
+         }
+      }
+   }
+   else
+   {
+      for (slave = 1; slave <= *(context->slavecount); slave++)
+      {
+         sl = &(context->slavelist[slave]);
+         if (ecx_config_plan_member(sl, group, part) && sl->Obits)
+         {
+            ecx_config_plan_slave(&LogAddr, &BitPos, sl->Obits, sl->Obytes);
+            if (forceByteAlignment && BitPos)
+            {
+               LogAddr++;
+               BitPos = 0;
+            }
+            ecx_config_add_segment(grp, &currentsegment, &segmentsize, LogAddr - oLogAddr, FALSE);
+            oLogAddr = LogAddr;
+         }
+      }
+      if (BitPos)
+      {
+         LogAddr++;
+         oLogAddr = LogAddr;
+         BitPos = 0;
+         ecx_config_add_segment(grp, &currentsegment, &segmentsize, 1, FALSE);
+      }
+      grp->Obytes = LogAddr;
+      grp->Isegment = currentsegment;
+      grp->Ioffset = (uint16)segmentsize;
+      for (slave = 1; slave <= *(context->slavecount); slave++)
+      {
+         sl = &(context->slavelist[slave]);
+         if (ecx_config_plan_member(sl, group, part))
+         {
+            if (sl->Ibits)
+            {
+               ecx_config_plan_slave(&LogAddr, &BitPos, sl->Ibits, sl->Ibytes);
+               if (forceByteAlignment && BitPos)
+               {
+                  LogAddr++;
+                  BitPos = 0;
+               }
+               ecx_config_add_segment(grp, &currentsegment, &segmentsize, LogAddr - oLogAddr, TRUE);
+               oLogAddr = LogAddr;
+            }
+            grp->blockLRW += sl->blockLRW ? 1 : 0;
+            grp->hasdc |= sl->hasdc;
+         }
+      }
+      if (BitPos)
+      {
+         LogAddr++;
+         ecx_config_add_segment(grp, &currentsegment, &segmentsize, 1, TRUE);
+      }
+      grp->Ibytes = LogAddr - grp->Obytes;
+   }
+   grp->IOsegment[currentsegment] = segmentsize;
+   grp->nsegments = currentsegment + 1;
+   grp->nframes = ecx_config_count_frames(grp, overlap, bytes);
+
+   return grp->nframes;
+}
+
+/** Lay out the IO segments of a group and place the FRMW of the DC time.
+ * The segments are first filled without room for the FRMW. If one of the
+ * LRW frames has room to spare the FRMW rides in the first of them and the
+ * layout stands, as keeping room in that segment changes no cut. Otherwise,
+ * and always when LRW is blocked, room is kept in the frame leading the cycle
+ * at the cost of the layout filled with it. Groups without DC slaves keep no
+ * room at all.
+ *
+ * @param[in]  context    = context struct
+ * @param[in]  group      = group to lay out, 0 = all groups
+ * @param[in,out] grp     = resulting layout, with the IOsegment table set by the caller
+ * @param[in]  overlap    = TRUE for the overlapping IOmap
+ * @param[in]  forceByteAlignment = TRUE to byte align every slave, sequential IOmap only
+ * @param[in]  part       = slaves laid out, EC_PLAN_ALL, EC_PLAN_NOINPUTONLY or EC_PLAN_INPUTONLY
+ * @param[out] bytes      = process data bytes of a cycle
+ * @return frames per process data cycle
+ */
+static uint16 ecx_config_layout_dc(ecx_contextt *context, uint8 group, ec_groupt *grp,
+   boolean overlap, boolean forceByteAlignment, int part, uint32 *bytes)
+{
+   uint16 segment;
+
+   grp->DCsegment = EC_NODCSEGMENT;
+   ecx_config_layout(context, group, grp, overlap, forceByteAlignment, part, bytes);
+   if (grp->hasdc)
+   {
+      if (!grp->blockLRW)
+      {
+         for (segment = 0; segment < grp->nframes; segment++)
+         {
+            if ((grp->IOsegment[segment] + EC_FIRSTDCDATAGRAM) <= EC_MAXLRWDATA)
+            {
+               grp->DCsegment = segment;
+               return grp->nframes;
+            }
+         }
+      }
+      grp->DCsegment = 0;
+      ecx_config_layout(context, group, grp, overlap, forceByteAlignment, part, bytes);
+   }
+
+   return grp->nframes;
+}
+
+/** Place the FRMW of the DC time of a group before it is mapped, see
+ * ecx_config_layout_dc(). The segment table of the group is used as scratch.
+ *
+ * @param[in]  context    = context struct
+ * @param[in]  group      = group to map, 0 = all groups
+ * @param[in]  overlap    = TRUE for the overlapping IOmap
+ * @param[in]  forceByteAlignment = TRUE to byte align every slave, sequential IOmap only
+ * @return segment to keep room for the FRMW in, EC_NODCSEGMENT if none
+ */
+static uint16 ecx_config_place_dc(ecx_contextt *context, uint8 group, boolean overlap,
+   boolean forceByteAlignment)
+{
+   ec_groupt grp;
+   uint32 bytes;
+
+   memset(&grp, 0x00, sizeof(grp));
+   grp.IOsegment = context->grouplist[group].IOsegment;
+   grp.maxsegments = context->grouplist[group].maxsegments;
+   ecx_config_layout_dc(context, group, &grp, overlap, forceByteAlignment, EC_PLAN_ALL, &bytes);
+
+   return grp.DCsegment;
+}
+
 static int ecx_main_config_map_group(ecx_contextt *context, void *pIOmap, uint8 group, boolean forceByteAlignment)
 {
    uint16 slave, configadr;
@@ -1185,18 +1640,31 @@ static int ecx_main_config_map_group(ecx_contextt *context, void *pIOmap, uint8
    uint16 currentsegment = 0;
    uint32 segmentsize = 0;
 
-   if ((*(context->slavecount) > 0) && (group < context->maxgroup))
+   if ((*(context->slavecount) > 0) && (group < context->maxgroup) &&
+       ecx_config_alloc_segments(context, group))
    {
       EC_PRINT("ec_config_map_group IOmap:%p group:%d\n", pIOmap, group);
       LogAddr = context->grouplist[group].logstartaddr;
       oLogAddr = LogAddr;
       BitPos = 0;
       context->grouplist[group].nsegments = 0;
+      context->grouplist[group].nframes = 0;
       context->grouplist[group].outputsWKC = 0;
       context->grouplist[group].inputsWKC = 0;
+      /* precompiled frames no longer match the mapping */
+      context->grouplist[group].ntemplates = 0;
+      /* drop pipelined cycles of the old mapping */
+      context->grouplist[group].pipecount = 0;
+      context->grouplist[group].idxstack.inputsonly = FALSE;
+      /* datagrams riding along are registered after mapping */
+      context->grouplist[group].ncyclic = 0;
+      context->grouplist[group].cyclecount = 0;
+      context->grouplist[group].overlapmap = FALSE;
 
       /* Find mappings and program syncmanagers */
       ecx_config_find_mappings(context, group);
+      /* keep room for the FRMW of the DC time where a frame has it to spare */
+      context->grouplist[group].DCsegment = ecx_config_place_dc(context, group, FALSE, forceByteAlignment);
 
       /* do output mapping of slave and program FMMUs */
       for (slave = 1; slave <= *(context->slavecount); slave++)
@@ -1222,19 +1690,7 @@ static int ecx_main_config_map_group(ecx_contextt *context, void *pIOmap, uint8
 
                diff = LogAddr - oLogAddr;
                oLogAddr = LogAddr;
-               if ((segmentsize + diff) > (EC_MAXLRWDATA - EC_FIRSTDCDATAGRAM))
-               {
-                  context->grouplist[group].IOsegment[currentsegment] = segmentsize;
-                  if (currentsegment < (EC_MAXIOSEGMENTS - 1))
-                  {
-                     currentsegment++;
-                     segmentsize = diff;
-                  }
-               }
-               else
-               {
-                  segmentsize += diff;
-               }
+               ecx_config_add_segment(&(context->grouplist[group]), &currentsegment, &segmentsize, diff, FALSE);
             }
          }
       }
@@ -1243,19 +1699,7 @@ static int ecx_main_config_map_group(ecx_contextt *context, void *pIOmap, uint8
          LogAddr++;
          oLogAddr = LogAddr;
          BitPos = 0;
-         if ((segmentsize + 1) > (EC_MAXLRWDATA - EC_FIRSTDCDATAGRAM))
-         {
-            context->grouplist[group].IOsegment[currentsegment] = segmentsize;
-            if (currentsegment < (EC_MAXIOSEGMENTS - 1))
-            {
-               currentsegment++;
-               segmentsize = 1;
-            }
-         }
-         else
-         {
-            segmentsize += 1;
-         }
+         ecx_config_add_segment(&(context->grouplist[group]), &currentsegment, &segmentsize, 1, FALSE);
       }
       context->grouplist[group].outputs = pIOmap;
       context->grouplist[group].Obytes = LogAddr - context->grouplist[group].logstartaddr;
@@ -1293,19 +1737,7 @@ static int ecx_main_config_map_group(ecx_contextt *context, void *pIOmap, uint8
 
                diff = LogAddr - oLogAddr;
                oLogAddr = LogAddr;
-               if ((segmentsize + diff) > (EC_MAXLRWDATA - EC_FIRSTDCDATAGRAM))
-               {
-                  context->grouplist[group].IOsegment[currentsegment] = segmentsize;
-                  if (currentsegment < (EC_MAXIOSEGMENTS - 1))
-                  {
-                     currentsegment++;
-                     segmentsize = diff;
-                  }
-               }
-               else
-               {
-                  segmentsize += diff;
-               }
+               ecx_config_add_segment(&(context->grouplist[group]), &currentsegment, &segmentsize, diff, TRUE);
             }
 
             ecx_eeprom2pdi(context, slave); /* set Eeprom control to PDI */
@@ -1331,19 +1763,7 @@ static int ecx_main_config_map_group(ecx_contextt *context, void *pIOmap, uint8
          LogAddr++;
          oLogAddr = LogAddr;
          BitPos = 0;
-         if ((segmentsize + 1) > (EC_MAXLRWDATA - EC_FIRSTDCDATAGRAM))
-         {
-            context->grouplist[group].IOsegment[currentsegment] = segmentsize;
-            if (currentsegment < (EC_MAXIOSEGMENTS - 1))
-            {
-               currentsegment++;
-               segmentsize = 1;
-            }
-         }
-         else
-         {
-            segmentsize += 1;
-         }
+         ecx_config_add_segment(&(context->grouplist[group]), &currentsegment, &segmentsize, 1, TRUE);
       }
       context->grouplist[group].IOsegment[currentsegment] = segmentsize;
       context->grouplist[group].nsegments = currentsegment + 1;
@@ -1351,6 +1771,7 @@ static int ecx_main_config_map_group(ecx_contextt *context, void *pIOmap, uint8
       context->grouplist[group].Ibytes = LogAddr - 
          context->grouplist[group].logstartaddr - 
          context->grouplist[group].Obytes;
+      context->grouplist[group].nframes = ecx_config_count_frames(&(context->grouplist[group]), FALSE, NULL);
       if (!group)
       {
          context->slavelist[0].inputs = (uint8 *)(pIOmap) + context->slavelist[0].Obytes;
@@ -1359,7 +1780,15 @@ static int ecx_main_config_map_group(ecx_contextt *context, void *pIOmap, uint8
             context->slavelist[0].Obytes; /* store input bytes in master record */
       }
 
-      EC_PRINT("IOmapSize %d\n", LogAddr - context->grouplist[group].logstartaddr);
+      EC_PRINT("IOmapSize %d IOsegments %d frames %d\n", LogAddr - context->grouplist[group].logstartaddr,
+         context->grouplist[group].nsegments, context->grouplist[group].nframes);
+      ecx_update_slavecyclic(context);
+      ecx_locatePDOentries(context, group);
+      /* the cyclic functions allocate nothing */
+      if (!ecx_alloc_group(context, group))
+      {
+         return 0;
+      }
 
       return (LogAddr - context->grouplist[group].logstartaddr);
    }
@@ -1415,7 +1844,8 @@ int ecx_config_overlap_map_group(ecx_contextt *context, void *pIOmap, uint8 grou
    uint16 currentsegment = 0;
    uint32 segmentsize = 0;
 
-   if ((*(context->slavecount) > 0) && (group < context->maxgroup))
+   if ((*(context->slavecount) > 0) && (group < context->maxgroup) &&
+       ecx_config_alloc_segments(context, group))
    {
       EC_PRINT("ec_config_map_group IOmap:%p group:%d\n", pIOmap, group);
       mLogAddr = context->grouplist[group].logstartaddr;
@@ -1423,11 +1853,23 @@ int ecx_config_overlap_map_group(ecx_contextt *context, void *pIOmap, uint8 grou
       soLogAddr = mLogAddr;
       BitPos = 0;
       context->grouplist[group].nsegments = 0;
+      context->grouplist[group].nframes = 0;
       context->grouplist[group].outputsWKC = 0;
       context->grouplist[group].inputsWKC = 0;
+      /* precompiled frames no longer match the mapping */
+      context->grouplist[group].ntemplates = 0;
+      /* drop pipelined cycles of the old mapping */
+      context->grouplist[group].pipecount = 0;
+      context->grouplist[group].idxstack.inputsonly = FALSE;
+      /* datagrams riding along are registered after mapping */
+      context->grouplist[group].ncyclic = 0;
+      context->grouplist[group].cyclecount = 0;
+      context->grouplist[group].overlapmap = TRUE;
 
       /* Find mappings and program syncmanagers */
       ecx_config_find_mappings(context, group);
+      /* keep room for the FRMW of the DC time where a frame has it to spare */
+      context->grouplist[group].DCsegment = ecx_config_place_dc(context, group, TRUE, FALSE);
       
       /* do IO mapping of slave and program FMMUs */
       for (slave = 1; slave <= *(context->slavecount); slave++)
@@ -1466,19 +1908,7 @@ int ecx_config_overlap_map_group(ecx_contextt *context, void *pIOmap, uint8 grou
             diff = tempLogAddr - mLogAddr;
             mLogAddr = tempLogAddr;
 
-            if ((segmentsize + diff) > (EC_MAXLRWDATA - EC_FIRSTDCDATAGRAM))
-            {
-               context->grouplist[group].IOsegment[currentsegment] = segmentsize;
-               if (currentsegment < (EC_MAXIOSEGMENTS - 1))
-               {
-                  currentsegment++;
-                  segmentsize = diff;
-               }
-            }
-            else
-            {
-               segmentsize += diff;
-            }
+            ecx_config_add_segment(&(context->grouplist[group]), &currentsegment, &segmentsize, diff, FALSE);
 
             ecx_eeprom2pdi(context, slave); /* set Eeprom control to PDI */
             /* User may override automatic state change */
@@ -1509,6 +1939,7 @@ int ecx_config_overlap_map_group(ecx_contextt *context, void *pIOmap, uint8 grou
       context->grouplist[group].Ibytes = siLogAddr - context->grouplist[group].logstartaddr;
       context->grouplist[group].outputs = pIOmap;
       context->grouplist[group].inputs = (uint8 *)pIOmap + context->grouplist[group].Obytes;
+      context->grouplist[group].nframes = ecx_config_count_frames(&(context->grouplist[group]), TRUE, NULL);
 
       /* Move calculated inputs with OBytes offset*/
       for (slave = 1; slave <= *(context->slavecount); slave++)
@@ -1531,7 +1962,15 @@ int ecx_config_overlap_map_group(ecx_contextt *context, void *pIOmap, uint8 grou
          context->slavelist[0].Ibytes = siLogAddr - context->grouplist[group].logstartaddr;
       }
 
-      EC_PRINT("IOmapSize %d\n", context->grouplist[group].Obytes + context->grouplist[group].Ibytes);
+      EC_PRINT("IOmapSize %d IOsegments %d frames %d\n", context->grouplist[group].Obytes + context->grouplist[group].Ibytes,
+         context->grouplist[group].nsegments, context->grouplist[group].nframes);
+      ecx_update_slavecyclic(context);
+      ecx_locatePDOentries(context, group);
+      /* the cyclic functions allocate nothing */
+      if (!ecx_alloc_group(context, group))
+      {
+         return 0;
+      }
 
       return (context->grouplist[group].Obytes + context->grouplist[group].Ibytes);
    }
@@ -1539,6 +1978,192 @@ int ecx_config_overlap_map_group(ecx_contextt *context, void *pIOmap, uint8 grou
    return 0;
 }
 
+/** Lay out one part of a group for the options of a plan and score it.
+ *
+ * @param[in]  context    = context struct
+ * @param[in]  group      = group to plan, 0 = all groups
+ * @param[in,out] grp     = scratch layout with the IOsegment table set by the caller
+ * @param[in]  part       = slaves laid out, EC_PLAN_ALL, EC_PLAN_NOINPUTONLY or EC_PLAN_INPUTONLY
+ * @param[in]  plan       = options of the plan
+ * @param[out] wirebytes  = bytes per cycle on the wire
+ * @return frames per process data cycle
+ */
+static uint16 ecx_config_plan_part(ecx_contextt *context, uint8 group, ec_groupt *grp,
+   int part, const ec_groupplant *plan, uint32 *wirebytes)
+{
+   uint32 bytes = 0;
+
+   ecx_config_layout_dc(context, group, grp, plan->overlap, plan->aligned, part, &bytes);
+   *wirebytes = 0;
+   if (grp->nframes)
+   {
+      *wirebytes = bytes + grp->nframes * (ETH_HEADERSIZE + EC_HEADERSIZE + EC_WKCSIZE);
+      if (grp->DCsegment != EC_NODCSEGMENT)
+      {
+         *wirebytes += EC_FIRSTDCDATAGRAM;
+      }
+   }
+
+   return grp->nframes;
+}
+
+/** Plan the process data layout of a group without mapping it. The slaves of
+ * the group are laid out with their current Obits, Obytes, Ibits and Ibytes,
+ * known after a mapping or set by the caller, for every mapping option: the
+ * sequential, the byte aligned and the overlapping IOmap, each with and
+ * without the input only slaves split off into a group of their own. The
+ * FRMW of the DC time is placed in the first frame with room to spare, as
+ * the mapping functions do. The layout with the fewest frames per cycle
+ * wins, then the one with the fewest bytes on the wire. A split off input
+ * group is cycled every inputcycle'th cycle, so its frames and bytes count
+ * for 1/inputcycle. Slaves and group are left untouched, map the plan with
+ * ecx_config_map_plan().
+ *
+ * @param[in]  context    = context struct
+ * @param[in]  group      = group to plan, 0 = all groups
+ * @param[in]  inputcycle = cycles per cycle of a split off input group,
+ *                          0 to keep the input only slaves in the group
+ * @param[out] plan       = best layout
+ * @return frames of a cycle that transmits the group and its input group,
+ * 0 if the group has no process data
+ */
+int ecx_config_plan_group(ecx_contextt *context, uint8 group, uint16 inputcycle,
+   ec_groupplant *plan)
+{
+   ec_groupt grp;
+   ec_groupplant cand;
+   uint32 weight = inputcycle ? inputcycle : 1;
+   uint32 cost, wire, bestcost = 0, bestwire = 0;
+   uint32 wirebytes;
+   int split, layout;
+   int wanted = (context->maxsegments > 0) ? context->maxsegments : EC_MAXIOSEGMENTS;
+
+   memset(plan, 0x00, sizeof(ec_groupplant));
+   if (group >= context->maxgroup)
+   {
+      return 0;
+   }
+   memset(&grp, 0x00, sizeof(grp));
+   grp.maxsegments = (uint16)((wanted > 0xffff) ? 0xffff : wanted);
+   grp.IOsegment = (uint32 *)osal_malloc(grp.maxsegments * sizeof(uint32));
+   if (grp.IOsegment == NULL)
+   {
+      return 0;
+   }
+   /* group 0 holds every slave, there is no group to split off to */
+   for (split = 0; split < ((inputcycle && group) ? 2 : 1); split++)
+   {
+      /* sequential, byte aligned and overlapping IOmap */
+      for (layout = 0; layout < 3; layout++)
+      {
+         memset(&cand, 0x00, sizeof(cand));
+         cand.aligned = (layout == 1);
+         cand.overlap = (layout == 2);
+         cand.splitinputs = (split != 0);
+         ecx_config_plan_part(context, group, &grp, split ? EC_PLAN_NOINPUTONLY : EC_PLAN_ALL,
+            &cand, &wirebytes);
+         cand.nsegments = grp.nsegments;
+         cand.nframes = grp.nframes;
+         cand.Obytes = grp.Obytes;
+         cand.Ibytes = grp.Ibytes;
+         cand.DCsegment = grp.DCsegment;
+         cand.wirebytes = wirebytes;
+         if (split)
+         {
+            ecx_config_plan_part(context, group, &grp, EC_PLAN_INPUTONLY, &cand, &wirebytes);
+            cand.inputnsegments = grp.nsegments;
+            cand.inputnframes = grp.nframes;
+            cand.inputIbytes = grp.Ibytes;
+            cand.inputDCsegment = grp.DCsegment;
+            cand.inputwirebytes = wirebytes;
+            /* nothing to split off, or nothing left */
+            if (!cand.nframes || !cand.inputnframes)
+            {
+               continue;
+            }
+         }
+         if (!cand.nframes)
+         {
+            break;
+         }
+         cost = cand.nframes * weight + cand.inputnframes;
+         wire = cand.wirebytes * weight + cand.inputwirebytes;
+         if (!plan->nframes || (cost < bestcost) || ((cost == bestcost) && (wire < bestwire)))
+         {
+            *plan = cand;
+            bestcost = cost;
+            bestwire = wire;
+         }
+      }
+   }
+   osal_free(grp.IOsegment);
+
+   return plan->nframes + plan->inputnframes;
+}
+
+/** Map a group with the mapping function chosen by a plan.
+ *
+ * @param[in]  context    = context struct
+ * @param[out] pIOmap     = pointer to IOmap
+ * @param[in]  group      = group to map
+ * @param[in]  plan       = layout from ecx_config_plan_group()
+ * @return IOmap size
+ */
+static int ecx_config_map_planned(ecx_contextt *context, void *pIOmap, uint8 group,
+   const ec_groupplant *plan)
+{
+   if (plan->overlap)
+   {
+      return ecx_config_overlap_map_group(context, pIOmap, group);
+   }
+   return ecx_main_config_map_group(context, pIOmap, group, plan->aligned);
+}
+
+/** Map a group as planned by ecx_config_plan_group(). If the plan splits off
+ * the input only slaves they are moved to inputgroup first, which is mapped
+ * behind the group in the same IOmap and at the logical addresses following
+ * it. Transmit inputgroup every inputcycle'th cycle the plan was made for.
+ *
+ * @param[in]  context    = context struct
+ * @param[out] pIOmap     = pointer to IOmap
+ * @param[in]  group      = group to map
+ * @param[in]  inputgroup = group for the input only slaves, only used if the plan splits them off
+ * @param[in]  plan       = layout from ecx_config_plan_group()
+ * @return IOmap size of both groups, 0 on error
+ */
+int ecx_config_map_plan(ecx_contextt *context, void *pIOmap, uint8 group, uint8 inputgroup,
+   const ec_groupplant *plan)
+{
+   ec_slavet *sl;
+   uint16 slave;
+   int size, isize;
+
+   if (plan->splitinputs)
+   {
+      if (!group || !inputgroup || (inputgroup == group) || (inputgroup >= context->maxgroup))
+      {
+         return 0;
+      }
+      for (slave = 1; slave <= *(context->slavecount); slave++)
+      {
+         sl = &(context->slavelist[slave]);
+         if ((sl->group == group) && sl->Ibits && !sl->Obits)
+         {
+            sl->group = inputgroup;
+         }
+      }
+   }
+   size = ecx_config_map_planned(context, pIOmap, group, plan);
+   if (size && plan->splitinputs)
+   {
+      context->grouplist[inputgroup].logstartaddr = context->grouplist[group].logstartaddr + size;
+      isize = ecx_config_map_planned(context, (uint8 *)pIOmap + size, inputgroup, plan);
+      size = isize ? (size + isize) : 0;
+   }
+
+   return size;
+}
+
 
 /** Recover slave.
  *
@@ -1598,6 +2223,7 @@ int ecx_recover_slave(ecx_contextt *context, uint16 slave, int timeout)
          ecx_FPWRw(context->port, EC_TEMPNODE, ECT_REG_STADR, htoes(0) , timeout);
          context->slavelist[slave].configadr = configadr;
       }
+      ecx_update_slavecyclic_slave(context, slave);
    }
 
    return rval;
@@ -1658,6 +2284,8 @@ int ecx_reconfig_slave(ecx_contextt *context, uint16 slave, int timeout)
          }
       }
    }
+   /* SM and FMMU are programmed again, keep the cyclic copy in step */
+   ecx_update_slavecyclic_slave(context, slave);
 
    return state;
 }
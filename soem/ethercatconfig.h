@@ -19,6 +19,39 @@ extern "C"
 #define EC_NODEOFFSET      0x1000
 #define EC_TEMPNODE        0xffff
 
+/** Layout of the process data of a group, see ecx_config_plan_group() */
+typedef struct ec_groupplan
+{
+   /** TRUE to map with ecx_config_overlap_map_group() */
+   boolean          overlap;
+   /** TRUE to map with ecx_config_map_group_aligned() */
+   boolean          aligned;
+   /** TRUE if the input only slaves are split off into a group of their own */
+   boolean          splitinputs;
+   /** number of IO segments */
+   uint16           nsegments;
+   /** frames per process data cycle */
+   uint16           nframes;
+   /** segment whose frame carries the FRMW of the DC time, EC_NODCSEGMENT if none */
+   uint16           DCsegment;
+   /** output bytes of the IOmap */
+   uint32           Obytes;
+   /** input bytes of the IOmap */
+   uint32           Ibytes;
+   /** bytes per cycle on the wire, Ethernet and EtherCAT headers included */
+   uint32           wirebytes;
+   /** number of IO segments of the input only group, 0 if not split off */
+   uint16           inputnsegments;
+   /** frames per cycle of the input only group */
+   uint16           inputnframes;
+   /** segment of the input only group carrying the FRMW, EC_NODCSEGMENT if none */
+   uint16           inputDCsegment;
+   /** input bytes of the input only group */
+   uint32           inputIbytes;
+   /** bytes per cycle of the input only group on the wire */
+   uint32           inputwirebytes;
+} ec_groupplant;
+
 #ifdef EC_VER1
 int ec_config_init(uint8 usetable);
 int ec_config_map(void *pIOmap);
@@ -37,6 +70,10 @@ int ecx_config_init(ecx_contextt *context, uint8 usetable);
 int ecx_config_map_group(ecx_contextt *context, void *pIOmap, uint8 group);
 int ecx_config_overlap_map_group(ecx_contextt *context, void *pIOmap, uint8 group);
 int ecx_config_map_group_aligned(ecx_contextt *context, void *pIOmap, uint8 group);
+int ecx_config_plan_group(ecx_contextt *context, uint8 group, uint16 inputcycle,
+   ec_groupplant *plan);
+int ecx_config_map_plan(ecx_contextt *context, void *pIOmap, uint8 group, uint8 inputgroup,
+   const ec_groupplant *plan);
 int ecx_recover_slave(ecx_contextt *context, uint16 slave, int timeout);
 int ecx_reconfig_slave(ecx_contextt *context, uint16 slave, int timeout);
 
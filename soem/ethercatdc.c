@@ -265,6 +265,8 @@ boolean ecx_configdc(ecx_contextt *context)
 
    context->slavelist[0].hasdc = FALSE;
    context->grouplist[0].hasdc = FALSE;
+   /* the DC clocks are set again, track their offset anew */
+   context->DCtxoffset = 0;
    ht = 0;
 
    ecx_BWR(context->port, 0, ECT_REG_DCTIME0, sizeof(ht), &ht, EC_TIMEOUTRET);  /* latch DCrecvTimeA of all slaves */
@@ -430,6 +432,43 @@ boolean ecx_configdc(ecx_contextt *context)
    return context->slavelist[0].hasdc;
 }
 
+/** Launch time of a frame at a fixed offset from the next SYNC0 event. The
+ * DC time is taken from the clock of the launch times, given to
+ * ecx_settxtime(), and the offset between both clocks tracked while the DC
+ * time is received with the processdata, so drift of the reference clock and
+ * time passed since the last cycle are accounted for.
+ * @param[in]  context        = context struct
+ * @param[in]  CyclTime       = Cycltime SYNC0 in ns, as given to ecx_dcsync0()
+ * @param[in]  CyclShift      = CyclShift in ns, as given to ecx_dcsync0()
+ * @param[in]  offset         = offset in ns from the SYNC0 event to the launch
+ * @return launch time in ns of the launch time clock, 0 (send immediately) if
+ * CyclTime is 0, ecx_settxtime() is not called or no DC time received yet
+ */
+int64 ecx_dclaunchtime(ecx_contextt *context, uint32 CyclTime, int32 CyclShift, int32 offset)
+{
+   int64 now, dcnow, t;
+
+   if (!CyclTime || !context->DCtxoffset)
+   {
+      return 0;
+   }
+   now = ecx_txclocktime(context->port);
+   if (!now)
+   {
+      return 0;
+   }
+   dcnow = now - context->DCtxoffset;
+   /* SYNC0 events are at multiples of the cycle time plus the shift */
+   t = dcnow - CyclShift;
+   t = ((t / CyclTime) + 1) * CyclTime + CyclShift + offset;
+   /* a negative offset can put the launch before now */
+   while (t <= dcnow)
+   {
+      t += CyclTime;
+   }
+   return t + context->DCtxoffset;
+}
+
 #ifdef EC_VER1
 void ec_dcsync0(uint16 slave, boolean act, uint32 CyclTime, int32 CyclShift)
 {
@@ -445,4 +484,9 @@ boolean ec_configdc(void)
 {
    return ecx_configdc(&ecx_context);
 }
+
+int64 ec_dclaunchtime(uint32 CyclTime, int32 CyclShift, int32 offset)
+{
+   return ecx_dclaunchtime(&ecx_context, CyclTime, CyclShift, offset);
+}
 #endif
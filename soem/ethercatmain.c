@@ -65,6 +65,8 @@ PACKED_END
  *  in by the configuration function ec_config().
  */
 ec_slavet               ec_slave[EC_MAXSLAVE];
+/** Cyclic part of the slave data, same numbering as ec_slave. */
+ec_slavecyclict         ec_slavecyclic[EC_MAXSLAVE];
 /** number of slaves found on the network */
 int                     ec_slavecount;
 /** slave group structure */
@@ -120,6 +122,17 @@ ecx_contextt  ecx_context = {
     NULL,               // .EOEhook()
     0,                  // .manualstatechange
     NULL,               // .userdata
+    FALSE,              // .ownslavelist
+    &ec_slavecyclic[0], // .slavecyclic
+    NULL,               // .PDOentry
+    0,                  // .maxPDOentry
+    0,                  // .nPDOentry
+    0,                  // .PDOentryslave
+    NULL,               // .PDOrecord
+    NULL,               // .PDOthread
+    0,                  // .maxsegments
+    FALSE,              // .groupalloc
+    0,                  // .DCtxoffset
 };
 #endif
 
@@ -320,8 +333,181 @@ int ecx_init_redundant(ecx_contextt *context, ecx_redportt *redport, const char
 void ecx_close(ecx_contextt *context)
 {
    ecx_closenic(context->port);
+   ecx_free_groups(context);
 };
 
+/** Tables of a context made by ecx_create_context(), allocated in one block
+ * followed by the grouplist. */
+typedef struct
+{
+   ecx_contextt   context;
+   ecx_portt      port;
+   int            slavecount;
+   boolean        ecaterror;
+   int64          DCtime;
+   uint8          esibuf[EC_MAXEEPBUF];
+   uint32         esimap[EC_MAXEEPBITMAP];
+   ec_eringt      elist;
+   ec_SMcommtypet SMcommtype[EC_MAX_MAPT];
+   ec_PDOassignt  PDOassign[EC_MAX_MAPT];
+   ec_PDOdesct    PDOdesc[EC_MAX_MAPT];
+   ec_eepromSMt   eepSM;
+   ec_eepromFMMUt eepFMMU;
+} ec_contextblockt;
+
+/** Create a context with its slave and group tables sized at runtime, as
+ * alternative to the static tables of EC_MAXSLAVE slaves and EC_MAXGROUP
+ * groups. The slavelist is owned by the context and grows to the number of
+ * slaves found by ecx_config_init(), give maxslave 0 to size it from the
+ * network only. Initialise the port with ecx_init() as usual.
+ * @param[in]  size           = sizes of the tables
+ * @return context, NULL if out of memory.
+ */
+ecx_contextt *ecx_create_context(const ec_contextsizet *size)
+{
+   ec_contextblockt *block;
+   ecx_contextt *context;
+   int maxslave, maxgroup;
+
+   maxslave = (size->maxslave > 0) ? size->maxslave : 1;
+   maxgroup = (size->maxgroup > 0) ? size->maxgroup : 1;
+   block = (ec_contextblockt *)osal_malloc(sizeof(ec_contextblockt) + maxgroup * sizeof(ec_groupt));
+   if (block == NULL)
+   {
+      return NULL;
+   }
+   memset(block, 0x00, sizeof(ec_contextblockt) + maxgroup * sizeof(ec_groupt));
+   context = &(block->context);
+   context->ownslavelist = TRUE;
+   if (!ecx_resize_slavelist(context, maxslave))
+   {
+      osal_free(block);
+      return NULL;
+   }
+   context->port = &(block->port);
+   context->slavecount = &(block->slavecount);
+   context->grouplist = (ec_groupt *)(block + 1);
+   context->maxgroup = maxgroup;
+   context->maxsegments = size->maxsegments;
+   context->esibuf = block->esibuf;
+   context->esimap = block->esimap;
+   context->elist = &(block->elist);
+   context->ecaterror = &(block->ecaterror);
+   context->DCtime = &(block->DCtime);
+   context->SMcommtype = block->SMcommtype;
+   context->PDOassign = block->PDOassign;
+   context->PDOdesc = block->PDOdesc;
+   context->eepSM = &(block->eepSM);
+   context->eepFMMU = &(block->eepFMMU);
+   return context;
+}
+
+/** Replace the slavelist of a context made by ecx_create_context() by an
+ * empty one of another size, together with its cyclic part. Do this before
+ * configuration, ecx_config_init() does it when it finds more slaves.
+ * @param[in]  context        = context struct
+ * @param[in]  maxslave       = slavelist entries including the master record
+ * @return >0 if OK, 0 if out of memory or the slavelist is not owned by the context.
+ */
+int ecx_resize_slavelist(ecx_contextt *context, int maxslave)
+{
+   ec_slavet *slavelist;
+   size_t size;
+
+   if (!context->ownslavelist)
+   {
+      return 0;
+   }
+   /* the cyclic part follows the slavelist in the same block */
+   size = maxslave * (sizeof(ec_slavet) + sizeof(ec_slavecyclict));
+   slavelist = (ec_slavet *)osal_malloc(size);
+   if (slavelist == NULL)
+   {
+      return 0;
+   }
+   memset(slavelist, 0x00, size);
+   osal_free(context->slavelist);
+   context->slavelist = slavelist;
+   context->slavecyclic = (ec_slavecyclict *)(slavelist + maxslave);
+   context->maxslave = maxslave;
+   return 1;
+}
+
+/** Copy the cyclic part of one slave out of the slavelist. Called by
+ * ecx_recover_slave() and ecx_reconfig_slave().
+ * @param[in]  context        = context struct
+ * @param[in]  slave          = slave number
+ */
+void ecx_update_slavecyclic_slave(ecx_contextt *context, uint16 slave)
+{
+   ec_slavecyclict *sc;
+   ec_slavet *sl;
+
+   if ((context->slavecyclic == NULL) || (slave >= context->maxslave))
+   {
+      return;
+   }
+   sl = &(context->slavelist[slave]);
+   sc = &(context->slavecyclic[slave]);
+   sc->outputs = sl->outputs;
+   sc->inputs = sl->inputs;
+   sc->Obytes = sl->Obytes;
+   sc->Ibytes = sl->Ibytes;
+   sc->Obits = sl->Obits;
+   sc->Ibits = sl->Ibits;
+   sc->state = sl->state;
+   sc->ALstatuscode = sl->ALstatuscode;
+   sc->configadr = sl->configadr;
+   sc->Ostartbit = sl->Ostartbit;
+   sc->Istartbit = sl->Istartbit;
+   sc->group = sl->group;
+}
+
+/** Copy the cyclic part of all slaves out of the slavelist. Called by the
+ * configuration and mapping functions, call it again after changing the
+ * IO pointers or the group of slaves by hand.
+ * @param[in]  context        = context struct
+ */
+void ecx_update_slavecyclic(ecx_contextt *context)
+{
+   int slave;
+
+   if (context->slavecyclic == NULL)
+   {
+      return;
+   }
+   for (slave = 0; (slave <= *(context->slavecount)) && (slave < context->maxslave); slave++)
+   {
+      ecx_update_slavecyclic_slave(context, (uint16)slave);
+   }
+}
+
+/** Copy the state of one slave to the cyclic part of the slavelist.
+ * @param[in]  context        = context struct
+ * @param[in]  slave          = slave number
+ */
+static void ecx_update_slavestate(ecx_contextt *context, uint16 slave)
+{
+   if (context->slavecyclic && (slave < context->maxslave))
+   {
+      context->slavecyclic[slave].state = context->slavelist[slave].state;
+      context->slavecyclic[slave].ALstatuscode = context->slavelist[slave].ALstatuscode;
+   }
+}
+
+/** Free a context made by ecx_create_context(). Close it first.
+ * @param[in]  context        = context struct
+ */
+void ecx_destroy_context(ecx_contextt *context)
+{
+   if (context)
+   {
+      ecx_free_groups(context);
+      osal_free(context->slavelist);
+      osal_free(context);
+   }
+}
+
 /** Read one byte from slave EEPROM via cache.
  *  If the cache location is empty then a read request is made to the slave.
  *  Depending on the slave capabilities the request is 4 or 8 bytes.
@@ -613,6 +799,8 @@ uint16 ecx_siiSMnext(ecx_contextt *context, uint16 slave, ec_eepromSMt* SM, uint
 uint32 ecx_siiPDO(ecx_contextt *context, uint16 slave, ec_eepromPDOt* PDO, uint8 t)
 {
    uint16 a , w, c, e, er, Size;
+   uint8 bitlen;
+   uint32 mapping;
    uint8 eectl = context->slavelist[slave].eep_pdi;
 
    Size = 0;
@@ -648,8 +836,19 @@ uint32 ecx_siiPDO(ecx_contextt *context, uint16 slave, ec_eepromPDOt* PDO, uint8
             for (er = 1; er <= e; er++)
             {
                c += 4;
+               /* index and subindex only when the PDO entries are recorded */
+               mapping = 0;
+               if (context->PDOentry && (context->PDOentryslave == slave))
+               {
+                  mapping = ((uint32)ecx_siigetbyte(context, slave, a) << 16) +
+                            ((uint32)ecx_siigetbyte(context, slave, a + 1) << 24) +
+                            ((uint32)ecx_siigetbyte(context, slave, a + 2) << 8);
+               }
                a += 5;
-               PDO->BitSize[PDO->nPDO] += ecx_siigetbyte(context, slave, a++);
+               bitlen = ecx_siigetbyte(context, slave, a++);
+               PDO->BitSize[PDO->nPDO] += bitlen;
+               ecx_addPDOentry(context, slave, PDO->Index[PDO->nPDO], (uint8)PDO->SyncM[PDO->nPDO], t == 1,
+                  mapping + bitlen);
                a += 2;
             }
             PDO->SMbitsize[ PDO->SyncM[PDO->nPDO] ] += PDO->BitSize[PDO->nPDO];
@@ -689,6 +888,10 @@ int ecx_FPRD_multi(ecx_contextt *context, int n, uint16 *configlst, ec_alstatust
 
    port = context->port;
    idx = ecx_getindex(port);
+   if (idx == EC_NOINDEX)
+   {
+      return EC_NOFRAME;
+   }
    slcnt = 0;
    ecx_setupdatagram(port, &(port->txbuf[idx]), EC_CMD_FPRD, idx,
       *(configlst + slcnt), ECT_REG_ALSTAT, sizeof(ec_alstatust), slstatlst + slcnt);
@@ -819,6 +1022,10 @@ int ecx_readstate(ecx_contextt *context)
       } while (lslave < *(context->slavecount));
       context->slavelist[0].state = lowest;
    }
+   for (slave = 0; slave <= *(context->slavecount); slave++)
+   {
+      ecx_update_slavestate(context, slave);
+   }
   
    return lowest;
 }
@@ -900,6 +1107,7 @@ uint16 ecx_statecheck(ecx_contextt *context, uint16 slave, uint16 reqstate, int
    }
    while ((state != reqstate) && (osal_timer_is_expired(&timer) == FALSE));
    context->slavelist[slave].state = rval;
+   ecx_update_slavestate(context, slave);
 
    return state;
 }
@@ -1643,35 +1851,40 @@ uint32 ecx_readeeprom2(ecx_contextt *context, uint16 slave, int timeout)
 }
 
 /** Push index of segmented LRD/LWR/LRW combination.
- * @param[in]  context        = context struct
+ * @param[in] idxstack    = stack of the cycle.
  * @param[in] idx         = Used datagram index.
- * @param[in] data        = Pointer to process data segment.
+ * @param[in] group       = Group of the datagram.
+ * @param[in] offset      = Offset of the datagram in the frame, 0 if it is the first.
+ * @param[in] data        = Pointer to process data segment, NULL if received in place.
  * @param[in] length      = Length of data segment in bytes.
  * @param[in] DCO         = Offset position of DC frame.
  */
-static void ecx_pushindex(ecx_contextt *context, uint8 idx, void *data, uint16 length, uint16 DCO)
+static void ecx_pushindex(ec_idxstackT *idxstack, uint8 idx, uint8 group, uint16 offset,
+   void *data, uint16 length, uint16 DCO)
 {
-   if(context->idxstack->pushed < EC_MAXBUF)
+   if(idxstack->pushed < idxstack->size)
    {
-      context->idxstack->idx[context->idxstack->pushed] = idx;
-      context->idxstack->data[context->idxstack->pushed] = data;
-      context->idxstack->length[context->idxstack->pushed] = length;
-      context->idxstack->dcoffset[context->idxstack->pushed] = DCO;
-      context->idxstack->pushed++;
+      idxstack->idx[idxstack->pushed] = idx;
+      idxstack->group[idxstack->pushed] = group;
+      idxstack->offset[idxstack->pushed] = offset;
+      idxstack->data[idxstack->pushed] = data;
+      idxstack->length[idxstack->pushed] = length;
+      idxstack->dcoffset[idxstack->pushed] = DCO;
+      idxstack->pushed++;
    }
 }
 
 /** Pull index of segmented LRD/LWR/LRW combination.
- * @param[in]  context        = context struct
+ * @param[in] idxstack    = stack of the cycle.
  * @return Stack location, -1 if stack is empty.
  */
-static int ecx_pullindex(ecx_contextt *context)
+static int ecx_pullindex(ec_idxstackT *idxstack)
 {
    int rval = -1;
-   if(context->idxstack->pulled < context->idxstack->pushed)
+   if(idxstack->pulled < idxstack->pushed)
    {
-      rval = context->idxstack->pulled;
-      context->idxstack->pulled++;
+      rval = idxstack->pulled;
+      idxstack->pulled++;
    }
 
    return rval;
@@ -1680,13 +1893,529 @@ static int ecx_pullindex(ecx_contextt *context)
 /** 
  * Clear the idx stack.
  * 
- * @param context           = context struct
+ * @param idxstack          = stack of the cycle
+ */
+static void ecx_clearindex(ec_idxstackT *idxstack)  {
+
+   idxstack->pushed = 0;
+   idxstack->pulled = 0;
+
+}
+
+/** Make room on a stack for a number of entries, the pushed entries are
+ * kept. The entries are allocated in one block by ecx_alloc_group(),
+ * released by ecx_free_groups().
+ * @param[in]  context        = context struct
+ * @param[in]  idxstack       = stack of the cycle
+ * @param[in]  size           = number of entries needed
+ * @return >0 if there is room
+ */
+static int ecx_reserveindex(ecx_contextt *context, ec_idxstackT *idxstack, int size)
+{
+   uint8 *block;
+   void **data;
+   uint16 *length, *dcoffset, *offset;
+   uint8 *idx, *group;
+
+   if (size <= idxstack->size)
+   {
+      return 1;
+   }
+   if (size > 0xffff)
+   {
+      return 0;
+   }
+   block = (uint8 *)osal_malloc(size * (sizeof(void *) + 3 * sizeof(uint16) + 2 * sizeof(uint8)));
+   if (block == NULL)
+   {
+      return 0;
+   }
+   data = (void **)block;
+   length = (uint16 *)(data + size);
+   dcoffset = length + size;
+   offset = dcoffset + size;
+   idx = (uint8 *)(offset + size);
+   group = idx + size;
+   if (idxstack->pushed)
+   {
+      memcpy(data, idxstack->data, idxstack->pushed * sizeof(void *));
+      memcpy(length, idxstack->length, idxstack->pushed * sizeof(uint16));
+      memcpy(dcoffset, idxstack->dcoffset, idxstack->pushed * sizeof(uint16));
+      memcpy(offset, idxstack->offset, idxstack->pushed * sizeof(uint16));
+      memcpy(idx, idxstack->idx, idxstack->pushed);
+      memcpy(group, idxstack->group, idxstack->pushed);
+   }
+   /* the data pointers lead the block */
+   osal_free(idxstack->data);
+   idxstack->data = data;
+   idxstack->length = length;
+   idxstack->dcoffset = dcoffset;
+   idxstack->offset = offset;
+   idxstack->idx = idx;
+   idxstack->group = group;
+   idxstack->size = (uint16)size;
+   context->groupalloc = TRUE;
+
+   return 1;
+}
+
+/** Release the stack entries of ecx_reserveindex().
+ * @param[in]  idxstack       = stack of the cycle
+ */
+static void ecx_freeindex(ec_idxstackT *idxstack)
+{
+   osal_free(idxstack->data);
+   idxstack->data = NULL;
+   idxstack->length = NULL;
+   idxstack->dcoffset = NULL;
+   idxstack->offset = NULL;
+   idxstack->idx = NULL;
+   idxstack->group = NULL;
+   idxstack->size = 0;
+   ecx_clearindex(idxstack);
+}
+
+/** Release the memory the groups of a context allocated when mapped: the IO
+ * segment lists, the precompiled frames, the index stacks, the pipelines and
+ * the datagrams riding along. Called by ecx_close() and ecx_config_init(),
+ * the groups have to be mapped again afterwards.
+ * @param[in]  context        = context struct
+ */
+void ecx_free_groups(ecx_contextt *context)
+{
+   ec_groupt *grp;
+   int group, i;
+
+   /* grouplists that never allocated may hold anything */
+   if (!context->groupalloc)
+   {
+      return;
+   }
+   for (group = 0; group < context->maxgroup; group++)
+   {
+      grp = &(context->grouplist[group]);
+      osal_free(grp->IOsegment);
+      grp->IOsegment = NULL;
+      grp->maxsegments = 0;
+      grp->nsegments = 0;
+      osal_free(grp->templates);
+      grp->templates = NULL;
+      grp->maxtemplates = 0;
+      grp->ntemplates = 0;
+      ecx_freeindex(&(grp->idxstack));
+      if (grp->pipeline)
+      {
+         for (i = 0; i < EC_MAXPIPELINE; i++)
+         {
+            ecx_freeindex(&(grp->pipeline[i]));
+         }
+         osal_free(grp->pipeline);
+         grp->pipeline = NULL;
+      }
+      grp->pipecount = 0;
+      osal_free(grp->cyclic);
+      grp->cyclic = NULL;
+      grp->ncyclic = 0;
+   }
+   context->groupalloc = FALSE;
+}
+
+/** Allocate the tables the cyclic functions of a group work in, so they
+ * need no memory of their own: room for the precompiled frames, the index
+ * stack, the pipeline and the datagrams riding along. Called by the mapping
+ * functions once the IO segments are known. The index stack of every mapped
+ * group is sized for the frames of all mapped groups, so any of them can
+ * lead a list of ecx_send_processdata_packed().
+ * @param[in]  context        = context struct
+ * @param[in]  group          = group number
+ * @return >0 if succeeded, 0 if out of memory
+ */
+int ecx_alloc_group(ecx_contextt *context, uint8 group)
+{
+   ec_groupt *grp;
+   int g, i, size, total;
+
+   grp = &(context->grouplist[group]);
+   /* a LRD and a LWR per segment if LRW is blocked */
+   size = 2 * grp->nsegments;
+   if (size > grp->maxtemplates)
+   {
+      osal_free(grp->templates);
+      grp->maxtemplates = 0;
+      grp->templates = (ec_frametemplatet *)osal_malloc(size * sizeof(ec_frametemplatet));
+      if (grp->templates == NULL)
+      {
+         return 0;
+      }
+      grp->maxtemplates = (uint16)size;
+      context->groupalloc = TRUE;
+   }
+   if (grp->pipeline == NULL)
+   {
+      grp->pipeline = (ec_idxstackT *)osal_malloc(EC_MAXPIPELINE * sizeof(ec_idxstackT));
+      if (grp->pipeline == NULL)
+      {
+         return 0;
+      }
+      memset(grp->pipeline, 0x00, EC_MAXPIPELINE * sizeof(ec_idxstackT));
+      grp->pipehead = 0;
+      context->groupalloc = TRUE;
+   }
+   for (i = 0; i < EC_MAXPIPELINE; i++)
+   {
+      if (!ecx_reserveindex(context, &(grp->pipeline[i]), size))
+      {
+         return 0;
+      }
+   }
+   if (grp->cyclic == NULL)
+   {
+      grp->cyclic = (ec_cyclicdatagramt *)osal_malloc(EC_MAXCYCLIC * sizeof(ec_cyclicdatagramt));
+      if (grp->cyclic == NULL)
+      {
+         return 0;
+      }
+      context->groupalloc = TRUE;
+   }
+   total = 0;
+   for (g = 0; g < context->maxgroup; g++)
+   {
+      total += 2 * context->grouplist[g].nsegments;
+   }
+   for (g = 0; g < context->maxgroup; g++)
+   {
+      if (context->grouplist[g].nsegments &&
+          !ecx_reserveindex(context, &(context->grouplist[g].idxstack), total))
+      {
+         return 0;
+      }
+   }
+
+   return 1;
+}
+
+/** Mark the datagrams riding along that are due in this cycle. A datagram
+ * stays due until it is appended to a frame, so one that did not fit in an
+ * earlier cycle is not skipped.
+ * @param[in]  context        = context struct
+ * @param[in]  group          = group number
+ * @param[in]  enable         = FALSE if no datagrams ride along in this cycle
+ */
+static void ecx_startcyclic(ecx_contextt *context, uint8 group, boolean enable)
+{
+   ec_groupt *grp;
+   ec_cyclicdatagramt *dg;
+   int i;
+
+   grp = &(context->grouplist[group]);
+   for (i = 0; i < grp->ncyclic; i++)
+   {
+      dg = &(grp->cyclic[i]);
+      if (enable && ((grp->cyclecount % dg->interval) == 0))
+      {
+         dg->due = TRUE;
+      }
+      dg->pending = FALSE;
+   }
+   if (enable)
+   {
+      grp->cyclecount++;
+   }
+}
+
+/** Append the due datagrams riding along to a process data frame, as far
+ * as they fit. Datagrams that do not fit in any frame of the cycle wait for
+ * the next one.
+ * @param[in]  context        = context struct
+ * @param[in]  group          = group number
+ * @param[in]  idxstack       = stack of the cycle
+ * @param[in]  idx            = index of frame
+ */
+static void ecx_addcyclic(ecx_contextt *context, uint8 group, ec_idxstackT *idxstack, uint8 idx)
+{
+   ec_groupt *grp;
+   ec_cyclicdatagramt *dg;
+   int i;
+
+   /* pipelined cycles carry no datagrams along */
+   if (idxstack->inputsonly)
+   {
+      return;
+   }
+   grp = &(context->grouplist[group]);
+   for (i = 0; i < grp->ncyclic; i++)
+   {
+      dg = &(grp->cyclic[i]);
+      if (dg->due && !dg->pending &&
+          ((context->port->txbuflength[idx] + EC_HEADERSIZE - EC_ELENGTHSIZE + dg->length + EC_WKCSIZE) <=
+           (int)(ETH_HEADERSIZE + EC_HEADERSIZE + EC_MAXLRWDATA + EC_WKCSIZE)))
+      {
+         dg->dataoffset = ecx_adddatagram(context->port, &(context->port->txbuf[idx]), dg->command, idx, FALSE,
+                                          dg->ADP, dg->ADO, dg->length, dg->data);
+         dg->idx = idx;
+         dg->pending = TRUE;
+         dg->due = FALSE;
+      }
+   }
+}
+
+/** Take the results of the datagrams riding along in a received frame.
+ * @param[in]  context        = context struct
+ * @param[in]  group          = group number
+ * @param[in]  idx            = index of frame
+ */
+static void ecx_cyclicresult(ecx_contextt *context, uint8 group, uint8 idx)
+{
+   ec_groupt *grp;
+   ec_cyclicdatagramt *dg;
+   uint8 *rxbuf;
+   uint16 le_wkc;
+   int i;
+
+   grp = &(context->grouplist[group]);
+   rxbuf = context->port->rxbuf[idx];
+   for (i = 0; i < grp->ncyclic; i++)
+   {
+      dg = &(grp->cyclic[i]);
+      if (dg->pending && (dg->idx == idx))
+      {
+         memcpy(dg->data, &rxbuf[dg->dataoffset], dg->length);
+         memcpy(&le_wkc, &rxbuf[dg->dataoffset + dg->length], EC_WKCSIZE);
+         dg->wkc = etohs(le_wkc);
+         dg->results++;
+         dg->pending = FALSE;
+         if (dg->update)
+         {
+            dg->update(context, dg);
+         }
+      }
+   }
+}
+
+/** Add precompiled frame of one IO segment to a group.
+ * @param[in]  context        = context struct
+ * @param[in]  group          = group number
+ * @param[in]  com            = command, LRD, LWR or LRW
+ * @param[in]  LogAdr         = logical address of segment
+ * @param[in]  length         = length of segment
+ * @param[in]  txdata         = data transmitted, NULL to clear data part
+ * @param[in]  rxdata         = destination of returning data
+ * @param[in]  dc             = TRUE to add the FRMW datagram with the DC time
+ */
+static void ecx_addtemplate(ecx_contextt *context, uint8 group, uint8 com, uint32 LogAdr,
+   uint16 length, uint8 *txdata, uint8 *rxdata, boolean dc)
+{
+   ec_groupt *grp;
+   ec_frametemplatet *tp;
+   ec_comt *datagramP;
+   uint16 elength;
+
+   grp = &(context->grouplist[group]);
+   if (grp->ntemplates >= grp->maxtemplates)
+   {
+      return;
+   }
+   tp = &(grp->templates[grp->ntemplates++]);
+   memset(tp, 0, sizeof(*tp));
+   elength = EC_ECATTYPE + EC_HEADERSIZE + length;
+   if (dc)
+   {
+      elength += EC_HEADERSIZE + sizeof(int64);
+   }
+   datagramP = (ec_comt *)tp->header;
+   datagramP->elength = htoes(elength);
+   datagramP->command = com;
+   datagramP->ADP = htoes(LO_WORD(LogAdr));
+   datagramP->ADO = htoes(HI_WORD(LogAdr));
+   datagramP->dlength = htoes(length | (dc ? EC_DATAGRAMFOLLOWS : 0));
+   /* WKC is already zero */
+   tp->trailerlength = EC_WKCSIZE;
+   if (dc)
+   {
+      /* FPRMW in second datagram, the header has no length of its own */
+      datagramP = (ec_comt *)&(tp->trailer[EC_WKCSIZE - EC_ELENGTHSIZE]);
+      datagramP->command = EC_CMD_FRMW;
+      datagramP->ADP = htoes(context->slavelist[grp->DCnext].configadr);
+      datagramP->ADO = htoes(ECT_REG_DCSYSTIME);
+      datagramP->dlength = htoes(sizeof(int64));
+      datagramP->elength = 0;
+      tp->trailerlength = EC_FRAMETRAILER;
+      tp->DCO = EC_HEADERSIZE + length + EC_WKCSIZE + EC_HEADERSIZE - EC_ELENGTHSIZE;
+   }
+   tp->length = length;
+   tp->txdata = txdata;
+   tp->rxdata = rxdata;
+}
+
+/** Precompile the process data frames of a group, so the cycle only sets
+ * the index of each frame and transmits the outputs. The frames are built
+ * like ecx_send_processdata_group() or ecx_send_overlap_processdata_group()
+ * would, which use them from then on. Compile again after the group
+ * mapping or DC configuration changed, mapping a group drops its frames.
+ * @param[in]  context        = context struct
+ * @param[in]  group          = group number
+ * @param[in]  overlap        = TRUE to compile for the overlapping IOmap
+ * @return number of frames per cycle, 0 if the group is not mapped
  */
-static void ecx_clearindex(ecx_contextt *context)  {
+int ecx_compile_group(ecx_contextt *context, uint8 group, boolean overlap)
+{
+   ec_groupt *grp;
+   uint32 LogAdr;
+   int length;
+   uint16 sublength;
+   uint16 currentsegment;
+   uint16 dcsegment;
+   uint32 iomapinputoffset;
+   uint8 *data;
+   boolean first;
+   int size;
+
+   grp = &(context->grouplist[group]);
+   grp->ntemplates = 0;
+   grp->templateoverlap = overlap;
+   /* a LRD and a LWR per segment if LRW is blocked, room is made by the mapping */
+   size = grp->blockLRW ? 2 * grp->nsegments : grp->nsegments;
+   if (size > grp->maxtemplates)
+   {
+      return 0;
+   }
+   first = grp->hasdc;
+   LogAdr = grp->logstartaddr;
+   currentsegment = 0;
+   if (grp->blockLRW)
+   {
+      if (grp->Ibytes)
+      {
+         currentsegment = grp->Isegment;
+         data = grp->inputs;
+         length = grp->Ibytes;
+         LogAdr += grp->Obytes;
+         do
+         {
+            if (currentsegment == grp->Isegment)
+            {
+               sublength = (uint16)(grp->IOsegment[currentsegment++] - grp->Ioffset);
+            }
+            else
+            {
+               sublength = (uint16)grp->IOsegment[currentsegment++];
+            }
+            ecx_addtemplate(context, group, EC_CMD_LRD, LogAdr, sublength, NULL, data, first);
+            first = FALSE;
+            length -= sublength;
+            LogAdr += sublength;
+            data += sublength;
+         } while (length && (currentsegment < grp->nsegments));
+      }
+      if (grp->Obytes)
+      {
+         data = grp->outputs;
+         length = grp->Obytes;
+         LogAdr = grp->logstartaddr;
+         currentsegment = 0;
+         do
+         {
+            sublength = (uint16)grp->IOsegment[currentsegment++];
+            if ((length - sublength) < 0)
+            {
+               sublength = (uint16)length;
+            }
+            ecx_addtemplate(context, group, EC_CMD_LWR, LogAdr, sublength, data, data, first);
+            first = FALSE;
+            length -= sublength;
+            LogAdr += sublength;
+            data += sublength;
+         } while (length && (currentsegment < grp->nsegments));
+      }
+   }
+   else
+   {
+      if (overlap)
+      {
+         length = (grp->Obytes > grp->Ibytes) ? grp->Obytes : grp->Ibytes;
+         iomapinputoffset = grp->Obytes;
+      }
+      else
+      {
+         length = grp->Obytes + grp->Ibytes;
+         iomapinputoffset = 0;
+      }
+      if (grp->Obytes)
+      {
+         data = grp->outputs;
+      }
+      else
+      {
+         data = grp->inputs;
+         iomapinputoffset = 0;
+      }
+      /* the FRMW rides in the frame of the segment the mapping kept room in */
+      dcsegment = (grp->DCsegment < grp->nsegments) ? grp->DCsegment : 0;
+      while (length && (currentsegment < grp->nsegments))
+      {
+         sublength = (uint16)grp->IOsegment[currentsegment++];
+         ecx_addtemplate(context, group, EC_CMD_LRW, LogAdr, sublength, data, data + iomapinputoffset,
+            first && ((currentsegment - 1) == dcsegment));
+         length -= sublength;
+         LogAdr += sublength;
+         data += sublength;
+      }
+   }
 
-   context->idxstack->pushed = 0;
-   context->idxstack->pulled = 0;
+   return grp->ntemplates;
+}
+
+/** Transmit the precompiled process data frames of a group.
+ * @param[in]  context        = context struct
+ * @param[in]  group          = group number
+ * @param[in]  idxstack       = stack of the cycle
+ */
+static void ecx_send_templates(ecx_contextt *context, uint8 group, ec_idxstackT *idxstack)
+{
+   ec_groupt *grp;
+   ec_frametemplatet *tp;
+   ec_comt *datagramP;
+   uint8 *frameP;
+   uint8 idx;
+   int i;
 
+   grp = &(context->grouplist[group]);
+   for (i = 0; i < grp->ntemplates; i++)
+   {
+      tp = &(grp->templates[i]);
+      /* get new index, the frames left out are missing in the receive */
+      idx = ecx_getindex(context->port);
+      if (idx == EC_NOINDEX)
+      {
+         break;
+      }
+      frameP = context->port->txbuf[idx];
+      memcpy(&frameP[ETH_HEADERSIZE], tp->header, EC_HEADERSIZE);
+      datagramP = (ec_comt *)&frameP[ETH_HEADERSIZE];
+      datagramP->index = idx;
+      memcpy(&frameP[ETH_HEADERSIZE + EC_HEADERSIZE + tp->length], tp->trailer, tp->trailerlength);
+      if (tp->DCO)
+      {
+         datagramP = (ec_comt *)&frameP[ETH_HEADERSIZE + EC_HEADERSIZE + tp->length + EC_WKCSIZE - EC_ELENGTHSIZE];
+         datagramP->index = idx;
+         memcpy(&frameP[ETH_HEADERSIZE + tp->DCO], context->DCtime, sizeof(int64));
+      }
+      context->port->txbuflength[idx] = ETH_HEADERSIZE + EC_HEADERSIZE + tp->length + tp->trailerlength;
+      /* add datagrams riding along that fit */
+      ecx_addcyclic(context, group, idxstack, idx);
+      /* send frame */
+      if (tp->txdata)
+      {
+         ecx_outframe_gather(context->port, idx, tp->txdata, ETH_HEADERSIZE + EC_HEADERSIZE, tp->length);
+      }
+      else
+      {
+         memset(&frameP[ETH_HEADERSIZE + EC_HEADERSIZE], 0, tp->length);
+         ecx_outframe_red(context->port, idx);
+      }
+      /* push index and data pointer on stack */
+      ecx_pushindex(idxstack, idx, group, 0, tp->rxdata, tp->length, tp->DCO);
+   }
 }
 
 /** Transmit processdata to slaves.
@@ -1702,7 +2431,8 @@ static void ecx_clearindex(ecx_contextt *context)  {
  * @param[in]  use_overlap_io = flag if overlapped iomap is used
  * @return >0 if processdata is transmitted.
  */
-static int ecx_main_send_processdata(ecx_contextt *context, uint8 group, boolean use_overlap_io)
+static int ecx_main_send_processdata(ecx_contextt *context, uint8 group, boolean use_overlap_io,
+   ec_idxstackT *idxstack)
 {
    uint32 LogAdr;
    uint16 w1, w2;
@@ -1713,6 +2443,7 @@ static int ecx_main_send_processdata(ecx_contextt *context, uint8 group, boolean
    uint8* data;
    boolean first=FALSE;
    uint16 currentsegment = 0;
+   uint16 dcsegment;
    uint32 iomapinputoffset;
    uint16 DCO;
 
@@ -1740,10 +2471,24 @@ static int ecx_main_send_processdata(ecx_contextt *context, uint8 group, boolean
    LogAdr = context->grouplist[group].logstartaddr;
    if(length)
    {
-
+      /* a LRD and a LWR per segment if LRW is blocked, room is made by the mapping */
+      if ((idxstack->pushed + 2 * context->grouplist[group].nsegments) > idxstack->size)
+      {
+         return 0;
+      }
       wkc = 1;
+      /* pipelined cycles carry no datagrams along */
+      ecx_startcyclic(context, group, !idxstack->inputsonly);
+      /* collect all segment frames and transmit them at once */
+      ecx_txbatch_begin(context->port);
+      /* frames precompiled by ecx_compile_group() ? */
+      if(context->grouplist[group].ntemplates &&
+         (context->grouplist[group].templateoverlap == use_overlap_io))
+      {
+         ecx_send_templates(context, group, idxstack);
+      }
       /* LRW blocked by one or more slaves ? */
-      if(context->grouplist[group].blockLRW)
+      else if(context->grouplist[group].blockLRW)
       {
          /* if inputs available generate LRD */
          if(context->grouplist[group].Ibytes)
@@ -1763,8 +2508,12 @@ static int ecx_main_send_processdata(ecx_contextt *context, uint8 group, boolean
                {
                   sublength = (uint16)context->grouplist[group].IOsegment[currentsegment++];
                }
-               /* get new index */
+               /* get new index, the frames left out are missing in the receive */
                idx = ecx_getindex(context->port);
+               if (idx == EC_NOINDEX)
+               {
+                  break;
+               }
                w1 = LO_WORD(LogAdr);
                w2 = HI_WORD(LogAdr);
                DCO = 0;
@@ -1777,10 +2526,12 @@ static int ecx_main_send_processdata(ecx_contextt *context, uint8 group, boolean
                                            ECT_REG_DCSYSTIME, sizeof(int64), context->DCtime);
                   first = FALSE;
                }
+               /* add datagrams riding along that fit */
+               ecx_addcyclic(context, group, idxstack, idx);
                /* send frame */
                ecx_outframe_red(context->port, idx);
                /* push index and data pointer on stack */
-               ecx_pushindex(context, idx, data, sublength, DCO);
+               ecx_pushindex(idxstack, idx, group, 0, data, sublength, DCO);
                length -= sublength;
                LogAdr += sublength;
                data += sublength;
@@ -1801,12 +2552,17 @@ static int ecx_main_send_processdata(ecx_contextt *context, uint8 group, boolean
                {
                   sublength = (uint16)length;
                }
-               /* get new index */
+               /* get new index, the frames left out are missing in the receive */
                idx = ecx_getindex(context->port);
+               if (idx == EC_NOINDEX)
+               {
+                  break;
+               }
                w1 = LO_WORD(LogAdr);
                w2 = HI_WORD(LogAdr);
                DCO = 0;
-               ecx_setupdatagram(context->port, &(context->port->txbuf[idx]), EC_CMD_LWR, idx, w1, w2, sublength, data);
+               /* outputs are taken straight from the IOmap at transmit */
+               ecx_setupdatagram(context->port, &(context->port->txbuf[idx]), EC_CMD_LWR, idx, w1, w2, sublength, NULL);
                if(first)
                {
                   /* FPRMW in second datagram */
@@ -1815,10 +2571,12 @@ static int ecx_main_send_processdata(ecx_contextt *context, uint8 group, boolean
                                            ECT_REG_DCSYSTIME, sizeof(int64), context->DCtime);
                   first = FALSE;
                }
+               /* add datagrams riding along that fit */
+               ecx_addcyclic(context, group, idxstack, idx);
                /* send frame */
-               ecx_outframe_red(context->port, idx);
+               ecx_outframe_gather(context->port, idx, data, ETH_HEADERSIZE + EC_HEADERSIZE, sublength);
                /* push index and data pointer on stack */
-               ecx_pushindex(context, idx, data, sublength, DCO);
+               ecx_pushindex(idxstack, idx, group, 0, data, sublength, DCO);
                length -= sublength;
                LogAdr += sublength;
                data += sublength;
@@ -1838,17 +2596,25 @@ static int ecx_main_send_processdata(ecx_contextt *context, uint8 group, boolean
             /* Clear offset, don't compensate for overlapping IOmap if we only got inputs */
             iomapinputoffset = 0;
          }
+         /* the FRMW rides in the frame of the segment the mapping kept room in */
+         dcsegment = (context->grouplist[group].DCsegment < context->grouplist[group].nsegments) ?
+            context->grouplist[group].DCsegment : 0;
          /* segment transfer if needed */
          do
          {
             sublength = (uint16)context->grouplist[group].IOsegment[currentsegment++];
-            /* get new index */
+            /* get new index, the frames left out are missing in the receive */
             idx = ecx_getindex(context->port);
+            if (idx == EC_NOINDEX)
+            {
+               break;
+            }
             w1 = LO_WORD(LogAdr);
             w2 = HI_WORD(LogAdr);
             DCO = 0;
-            ecx_setupdatagram(context->port, &(context->port->txbuf[idx]), EC_CMD_LRW, idx, w1, w2, sublength, data);
-            if(first)
+            /* process data is taken straight from the IOmap at transmit */
+            ecx_setupdatagram(context->port, &(context->port->txbuf[idx]), EC_CMD_LRW, idx, w1, w2, sublength, NULL);
+            if(first && ((currentsegment - 1) == dcsegment))
             {
                /* FPRMW in second datagram */
                DCO = ecx_adddatagram(context->port, &(context->port->txbuf[idx]), EC_CMD_FRMW, idx, FALSE,
@@ -1856,19 +2622,22 @@ static int ecx_main_send_processdata(ecx_contextt *context, uint8 group, boolean
                                         ECT_REG_DCSYSTIME, sizeof(int64), context->DCtime);
                first = FALSE;
             }
-            /* send frame */
-            ecx_outframe_red(context->port, idx);
-            /* push index and data pointer on stack.
-             * the iomapinputoffset compensate for where the inputs are stored 
+            /* the iomapinputoffset compensate for where the inputs are stored 
              * in the IOmap if we use an overlapping IOmap. If a regular IOmap
              * is used it should always be 0.
              */
-            ecx_pushindex(context, idx, (data + iomapinputoffset), sublength, DCO);      
+            /* add datagrams riding along that fit */
+            ecx_addcyclic(context, group, idxstack, idx);
+            /* send frame */
+            ecx_outframe_gather(context->port, idx, data, ETH_HEADERSIZE + EC_HEADERSIZE, sublength);
+            /* push index and data pointer on stack */
+            ecx_pushindex(idxstack, idx, group, 0, data + iomapinputoffset, sublength, DCO);
             length -= sublength;
             LogAdr += sublength;
             data += sublength;
          } while (length && (currentsegment < context->grouplist[group].nsegments));
       }
+      ecx_txbatch_flush(context->port);
    }
 
    return wkc;
@@ -1888,7 +2657,7 @@ static int ecx_main_send_processdata(ecx_contextt *context, uint8 group, boolean
 */
 int ecx_send_overlap_processdata_group(ecx_contextt *context, uint8 group)
 {
-   return ecx_main_send_processdata(context, group, TRUE);
+   return ecx_main_send_processdata(context, group, TRUE, &(context->grouplist[group].idxstack));
 }
 
 /** Transmit processdata to slaves.
@@ -1898,26 +2667,140 @@ int ecx_send_overlap_processdata_group(ecx_contextt *context, uint8 group)
 * The inputs are gathered with the receive processdata function.
 * In contrast to the base LRW function this function is non-blocking.
 * If the processdata does not fit in one datagram, multiple are used.
-* In order to recombine the slave response, a stack is used.
+* In order to recombine the slave response, a stack is used. Every group has
+* its own stack, so different groups can be cycled from different threads.
 * @param[in]  context        = context struct
 * @param[in]  group          = group number
 * @return >0 if processdata is transmitted.
 */
 int ecx_send_processdata_group(ecx_contextt *context, uint8 group)
 {
-   return ecx_main_send_processdata(context, group, FALSE);
+   return ecx_main_send_processdata(context, group, FALSE, &(context->grouplist[group].idxstack));
 }
 
-/** Receive processdata from slaves.
- * Second part from ec_send_processdata().
- * Received datagrams are recombined with the processdata with help from the stack.
- * If a datagram contains input processdata it copies it to the processdata structure.
- * @param[in]  context        = context struct
- * @param[in]  group          = group number
- * @param[in]  timeout        = Timeout in us.
+/** Transmit processdata to slaves at a launch time.
+* As ecx_send_processdata_group(), but the frames are handed to the NIC
+* driver with a launch time, so they leave the NIC at that time regardless of
+* the wake up jitter of the calling thread. Drivers without time triggered
+* transmit send the frames immediately, see ecx_setlaunchtime().
+* @param[in]  context        = context struct
+* @param[in]  group          = group number
+* @param[in]  launchtime     = launch time in ns, see ecx_dclaunchtime()
+* @return >0 if processdata is transmitted.
+*/
+int ecx_send_timed_processdata_group(ecx_contextt *context, uint8 group, int64 launchtime)
+{
+   int wkc;
+
+   ecx_setlaunchtime(context->port, launchtime);
+   wkc = ecx_main_send_processdata(context, group, FALSE, &(context->grouplist[group].idxstack));
+   ecx_setlaunchtime(context->port, 0);
+
+   return wkc;
+}
+
+/** Track the offset between the clock of the launch times and the DC time,
+ * right after a DC time is received. The receive latency only adds to the
+ * offset, so the lowest offset seen is kept, and the offset creeps up to
+ * follow the drift of the reference clock against the launch time clock.
+ * @param[in]  context        = context struct
+ */
+static void ecx_trackDCoffset(ecx_contextt *context)
+{
+   int64 now, diff;
+
+   now = ecx_txclocktime(context->port);
+   if (!now)
+   {
+      return;
+   }
+   diff = now - *(context->DCtime);
+   if (!context->DCtxoffset || (diff < context->DCtxoffset))
+   {
+      context->DCtxoffset = diff;
+   }
+   else
+   {
+      context->DCtxoffset += (diff - context->DCtxoffset) / 64;
+   }
+}
+
+/** Copy the returned data of a frame to the IOmap. For a stack with
+ * inputsonly set, only the part inside the input area of the group is
+ * copied, so the outputs of later cycles are not overwritten.
+ * @param[in]  grp            = group of the frame
+ * @param[in]  idxstack       = stack of the cycle
+ * @param[in]  pos            = stack location of the frame
+ * @param[in]  src            = data of the received datagram
+ */
+static void ecx_copyinputs(ec_groupt *grp, ec_idxstackT *idxstack, int pos, const uint8 *src)
+{
+   uint8 *data, *lo, *hi;
+
+   data = idxstack->data[pos];
+   /* received in place by the driver */
+   if (!data)
+   {
+      return;
+   }
+   if (!idxstack->inputsonly)
+   {
+      memcpy(data, src, idxstack->length[pos]);
+      return;
+   }
+   lo = (data > grp->inputs) ? data : grp->inputs;
+   hi = data + idxstack->length[pos];
+   if (hi > grp->inputs + grp->Ibytes)
+   {
+      hi = grp->inputs + grp->Ibytes;
+   }
+   if (hi > lo)
+   {
+      memcpy(lo, src + (lo - data), hi - lo);
+   }
+}
+
+/** Let the driver receive the inputs of the frames of a cycle straight into
+ * the IOmap, see ecx_inframe_scatter(). Called at the start of the receive,
+ * so the IOmap is only written while its owner waits for the frames. Frames
+ * already received keep their data pointer and are copied as usual.
+ * @param[in]  context        = context struct
+ * @param[in]  idxstack       = stack of the cycle
+ */
+static void ecx_scatterinputs(ecx_contextt *context, ec_idxstackT *idxstack)
+{
+   uint8 cmd, idx;
+   int pos;
+
+   /* pipelined cycles only take the input area, see ecx_copyinputs() */
+   if (idxstack->inputsonly)
+   {
+      return;
+   }
+   for (pos = idxstack->pulled; pos < idxstack->pushed; pos++)
+   {
+      idx = idxstack->idx[pos];
+      cmd = context->port->txbuf[idx][ETH_HEADERSIZE + EC_CMDOFFSET];
+      if (idxstack->data[pos] && ((cmd == EC_CMD_LRD) || (cmd == EC_CMD_LRW)) &&
+          ecx_inframe_scatter(context->port, idx, idxstack->data[pos], ETH_HEADERSIZE + EC_HEADERSIZE,
+                              idxstack->length[pos]))
+      {
+         idxstack->data[pos] = NULL;
+      }
+   }
+}
+
+/** Receive processdata from slaves.
+ * @param[in]  context        = context struct
+ * @param[in]  group          = group number
+ * @param[in]  idxstack       = stack of the cycle
+ * @param[in]  timeout        = Timeout in us per frame, used without deadline.
+ * @param[in]  deadline       = Timer shared by all frames, NULL to use timeout.
+ * @param[out] status         = Status of each frame, NULL if not needed.
  * @return Work counter.
  */
-int ecx_receive_processdata_group(ecx_contextt *context, uint8 group, int timeout)
+static int ecx_main_receive_processdata(ecx_contextt *context, uint8 group, ec_idxstackT *idxstack,
+   int timeout, osal_timert *deadline, ec_framestatust *status)
 {
    uint8 idx;
    int pos;
@@ -1925,21 +2808,48 @@ int ecx_receive_processdata_group(ecx_contextt *context, uint8 group, int timeou
    uint16 le_wkc = 0;
    int valid_wkc = 0;
    int64 le_DCtime;
-   ec_idxstackT *idxstack;
    ec_bufT *rxbuf;
 
-   /* just to prevent compiler warning for unused group */
-   wkc2 = group;
-
-   idxstack = context->idxstack;
    rxbuf = context->port->rxbuf;
+   if (status)
+   {
+      status->frames = idxstack->pushed;
+      status->lost = 0;
+   }
+   ecx_scatterinputs(context, idxstack);
    /* get first index */
-   pos = ecx_pullindex(context);
+   pos = ecx_pullindex(idxstack);
    /* read the same number of frames as send */
    while (pos >= 0)
    {
       idx = idxstack->idx[pos];
-      wkc2 = ecx_waitinframe(context->port, idx, timeout);
+      if (deadline)
+      {
+         /* frames that arrive while waiting are sorted into their buffers */
+         wkc2 = ecx_waitinframe_timer(context->port, idx, deadline);
+      }
+      else
+      {
+         wkc2 = ecx_waitinframe(context->port, idx, timeout);
+      }
+      if ((wkc2 > EC_NOFRAME) && context->grouplist[group].ncyclic)
+      {
+         ecx_cyclicresult(context, group, idx);
+         /* the frame wkc is the one of the last datagram, take the process data one */
+         memcpy(&le_wkc, &(rxbuf[idx][EC_HEADERSIZE + idxstack->length[pos]]), EC_WKCSIZE);
+         wkc2 = etohs(le_wkc);
+      }
+      if (status)
+      {
+         if (pos < EC_MAXIDXSTACK)
+         {
+            status->wkc[pos] = (wkc2 > EC_NOFRAME) ? wkc2 : EC_NOFRAME;
+         }
+         if (wkc2 <= EC_NOFRAME)
+         {
+            status->lost++;
+         }
+      }
       /* check if there is input data in frame */
       if (wkc2 > EC_NOFRAME)
       {
@@ -1947,16 +2857,18 @@ int ecx_receive_processdata_group(ecx_contextt *context, uint8 group, int timeou
          {
             if(idxstack->dcoffset[pos] > 0)
             {
-               memcpy(idxstack->data[pos], &(rxbuf[idx][EC_HEADERSIZE]), idxstack->length[pos]);
+               /* copy input data back to process data buffer */
+               ecx_copyinputs(&(context->grouplist[group]), idxstack, pos, &(rxbuf[idx][EC_HEADERSIZE]));
                memcpy(&le_wkc, &(rxbuf[idx][EC_HEADERSIZE + idxstack->length[pos]]), EC_WKCSIZE);
                wkc = etohs(le_wkc);
                memcpy(&le_DCtime, &(rxbuf[idx][idxstack->dcoffset[pos]]), sizeof(le_DCtime));
                *(context->DCtime) = etohll(le_DCtime);
+               ecx_trackDCoffset(context);
             }
             else
             {
                /* copy input data back to process data buffer */
-               memcpy(idxstack->data[pos], &(rxbuf[idx][EC_HEADERSIZE]), idxstack->length[pos]);
+               ecx_copyinputs(&(context->grouplist[group]), idxstack, pos, &(rxbuf[idx][EC_HEADERSIZE]));
                wkc += wkc2;
             }
             valid_wkc = 1;
@@ -1970,6 +2882,7 @@ int ecx_receive_processdata_group(ecx_contextt *context, uint8 group, int timeou
                wkc = etohs(le_wkc) * 2;
                memcpy(&le_DCtime, &(rxbuf[idx][idxstack->dcoffset[pos]]), sizeof(le_DCtime));
                *(context->DCtime) = etohll(le_DCtime);
+               ecx_trackDCoffset(context);
             }
             else
             {
@@ -1982,10 +2895,385 @@ int ecx_receive_processdata_group(ecx_contextt *context, uint8 group, int timeou
       /* release buffer */
       ecx_setbufstat(context->port, idx, EC_BUF_EMPTY);
       /* get next index */
-      pos = ecx_pullindex(context);
+      pos = ecx_pullindex(idxstack);
+   }
+
+   ecx_clearindex(idxstack);
+
+   /* if no frames has arrived */
+   if (valid_wkc == 0)
+   {
+      return EC_NOFRAME;
+   }
+   return wkc;
+}
+
+
+/** Receive processdata from slaves.
+ * Second part from ec_send_processdata().
+ * Received datagrams are recombined with the processdata with help from the stack.
+ * If a datagram contains input processdata it copies it to the processdata structure.
+ * @param[in]  context        = context struct
+ * @param[in]  group          = group number
+ * @param[in]  timeout        = Timeout in us.
+ * @return Work counter.
+ */
+int ecx_receive_processdata_group(ecx_contextt *context, uint8 group, int timeout)
+{
+   return ecx_main_receive_processdata(context, group, &(context->grouplist[group].idxstack), timeout, NULL, NULL);
+}
+
+/** Receive processdata from slaves with one deadline for the whole cycle.
+ * Like ecx_receive_processdata_group(), but all frames share one timer so a
+ * lost frame delays the cycle no further than the deadline, independent of
+ * the number of frames. Frames are accepted in any order of arrival.
+ * @param[in]  context        = context struct
+ * @param[in]  group          = group number
+ * @param[in]  deadline       = Timer started by the caller, e.g. at the start of the cycle.
+ * @param[out] status         = Work counter of each frame and number of lost frames, NULL if not needed.
+ * @return Work counter.
+ */
+int ecx_receive_processdata_deadline(ecx_contextt *context, uint8 group, osal_timert *deadline,
+   ec_framestatust *status)
+{
+   return ecx_main_receive_processdata(context, group, &(context->grouplist[group].idxstack), 0, deadline, status);
+}
+
+/** Transmit a pipelined processdata cycle.
+ * @param[in]  context        = context struct
+ * @param[in]  group          = group number
+ * @param[in]  use_overlap_io = TRUE for the overlapping IOmap
+ * @param[out] cycle          = tag of the transmitted cycle
+ * @return >0 if processdata is transmitted, 0 if the pipeline is full or the
+ * group is not mapped.
+ */
+static int ecx_main_send_pipelined(ecx_contextt *context, uint8 group, boolean use_overlap_io,
+   uint32 *cycle)
+{
+   ec_groupt *grp;
+   ec_idxstackT *idxstack;
+   int wkc;
+
+   grp = &(context->grouplist[group]);
+   if (grp->pipecount >= EC_MAXPIPELINE)
+   {
+      return 0;
+   }
+   /* allocated by the mapping */
+   if (grp->pipeline == NULL)
+   {
+      return 0;
+   }
+   idxstack = &(grp->pipeline[grp->pipehead]);
+   ecx_clearindex(idxstack);
+   idxstack->cycle = grp->pipecycle;
+   idxstack->inputsonly = TRUE;
+   wkc = ecx_main_send_processdata(context, group, use_overlap_io, idxstack);
+   if (wkc > 0)
+   {
+      if (cycle)
+      {
+         *cycle = grp->pipecycle;
+      }
+      grp->pipecycle++;
+      grp->pipehead = (grp->pipehead + 1) % EC_MAXPIPELINE;
+      grp->pipecount++;
+   }
+
+   return wkc;
+}
+
+/** Transmit processdata to slaves without waiting for the previous cycles.
+* As ecx_send_processdata_group(), but up to EC_MAXPIPELINE cycles can be in
+* flight, so the next cycle is transmitted while the previous one is still on
+* the wire. Every cycle is tagged with a sequence number, the cycles are
+* received in order with ecx_receive_processdata_pipelined(). Only the input
+* area of the IOmap is written on receive, so outputs already prepared for a
+* later cycle are kept. The port needs maxbuf frame buffers for all frames
+* in flight.
+* @param[in]  context        = context struct
+* @param[in]  group          = group number
+* @param[out] cycle          = tag of the transmitted cycle, NULL if not needed
+* @return >0 if processdata is transmitted, 0 if EC_MAXPIPELINE cycles are in flight.
+*/
+int ecx_send_processdata_pipelined(ecx_contextt *context, uint8 group, uint32 *cycle)
+{
+   return ecx_main_send_pipelined(context, group, FALSE, cycle);
+}
+
+/** Transmit processdata to slaves without waiting for the previous cycles.
+* As ecx_send_processdata_pipelined() for the overlapping IOmap.
+* @param[in]  context        = context struct
+* @param[in]  group          = group number
+* @param[out] cycle          = tag of the transmitted cycle, NULL if not needed
+* @return >0 if processdata is transmitted, 0 if EC_MAXPIPELINE cycles are in flight.
+*/
+int ecx_send_overlap_processdata_pipelined(ecx_contextt *context, uint8 group, uint32 *cycle)
+{
+   return ecx_main_send_pipelined(context, group, TRUE, cycle);
+}
+
+/** Receive the oldest pipelined processdata cycle in flight.
+ * Second part of ecx_send_processdata_pipelined().
+ * @param[in]  context        = context struct
+ * @param[in]  group          = group number
+ * @param[in]  timeout        = Timeout in us.
+ * @param[out] cycle          = tag of the received cycle, NULL if not needed
+ * @return Work counter, EC_NOFRAME if no cycle is in flight.
+ */
+int ecx_receive_processdata_pipelined(ecx_contextt *context, uint8 group, int timeout, uint32 *cycle)
+{
+   ec_groupt *grp;
+   ec_idxstackT *idxstack;
+
+   grp = &(context->grouplist[group]);
+   if (!grp->pipecount)
+   {
+      return EC_NOFRAME;
+   }
+   idxstack = &(grp->pipeline[(grp->pipehead + EC_MAXPIPELINE - grp->pipecount) % EC_MAXPIPELINE]);
+   grp->pipecount--;
+   if (cycle)
+   {
+      *cycle = idxstack->cycle;
+   }
+
+   return ecx_main_receive_processdata(context, group, idxstack, timeout, NULL, NULL);
+}
+
+/** Transmit a packed frame.
+ * @param[in]  context        = context struct
+ * @param[in]  idx            = index of frame
+ * @param[in]  length         = length of frame including ethernet header
+ */
+static void ecx_send_packedframe(ecx_contextt *context, uint8 idx, int length)
+{
+   ec_comt *datagramP;
+
+   datagramP = (ec_comt *)&(context->port->txbuf[idx][ETH_HEADERSIZE]);
+   datagramP->elength = htoes(EC_ECATTYPE + length - ETH_HEADERSIZE - EC_ELENGTHSIZE);
+   context->port->txbuflength[idx] = length;
+   ecx_outframe_red(context->port, idx);
+}
+
+/** Transmit processdata of several groups packed into shared frames.
+* The datagrams of all IO segments of the groups are chained into as few
+* frames as possible, so small groups need neither a frame nor a roundtrip
+* of their own. The datagrams are those of ecx_compile_group(), groups not
+* compiled for the IOmap they are mapped with are compiled first. The frames
+* are tracked in the index stack of the first group in the list, receive them
+* with ecx_receive_processdata_packed() and the same list. The groups must not
+* be cycled on their own at the same time.
+* @param[in]  context        = context struct
+* @param[in]  groups         = group numbers
+* @param[in]  ngroups        = number of groups
+* @return >0 if processdata is transmitted, EC_ERROR if the list is empty.
+*/
+int ecx_send_processdata_packed(ecx_contextt *context, const uint8 *groups, int ngroups)
+{
+   ec_groupt *grp;
+   ec_frametemplatet *tp;
+   ec_idxstackT *idxstack;
+   ec_comt *datagramP;
+   uint8 *frameP = NULL;
+   uint8 idx = 0;
+   int i, t, length, dglength, last, offset, DCO;
+   int wkc = 0;
+
+   if (!groups || (ngroups <= 0))
+   {
+      return EC_ERROR;
+   }
+   idxstack = &(context->grouplist[groups[0]].idxstack);
+   idxstack->inputsonly = FALSE;
+   length = 0;
+   for (i = 0; i < ngroups; i++)
+   {
+      grp = &(context->grouplist[groups[i]]);
+      if (!grp->ntemplates || (grp->templateoverlap != grp->overlapmap))
+      {
+         ecx_compile_group(context, groups[i], grp->overlapmap);
+      }
+      length += grp->ntemplates;
+   }
+   /* room is made by the mapping */
+   if ((idxstack->pushed + length) > idxstack->size)
+   {
+      return 0;
    }
+   length = 0;
+   last = 0;
+   ecx_txbatch_begin(context->port);
+   for (i = 0; i < ngroups; i++)
+   {
+      grp = &(context->grouplist[groups[i]]);
+      for (t = 0; t < grp->ntemplates; t++)
+      {
+         tp = &(grp->templates[t]);
+         dglength = EC_HEADERSIZE - EC_ELENGTHSIZE + tp->length + tp->trailerlength;
+         /* datagram does not fit in the frame, transmit it and start a new one */
+         if (length && ((length + dglength) > (int)(ETH_HEADERSIZE + EC_HEADERSIZE + EC_MAXLRWDATA + EC_WKCSIZE)))
+         {
+            ecx_send_packedframe(context, idx, length);
+            length = 0;
+         }
+         if (!length)
+         {
+            /* the datagrams left out are missing in the receive */
+            idx = ecx_getindex(context->port);
+            if (idx == EC_NOINDEX)
+            {
+               break;
+            }
+            frameP = context->port->txbuf[idx];
+            length = ETH_HEADERSIZE + EC_ELENGTHSIZE;
+         }
+         else
+         {
+            /* add "datagram follows" flag to the previous datagram */
+            datagramP = (ec_comt *)&frameP[last];
+            datagramP->dlength = htoes(etohs(datagramP->dlength) | EC_DATAGRAMFOLLOWS);
+         }
+         /* offset of the datagram in the rx buffer, which has no ethernet header */
+         offset = length - ETH_HEADERSIZE - EC_ELENGTHSIZE;
+         memcpy(&frameP[length], &(tp->header[EC_ELENGTHSIZE]), EC_HEADERSIZE - EC_ELENGTHSIZE);
+         datagramP = (ec_comt *)&frameP[length - EC_ELENGTHSIZE];
+         datagramP->index = idx;
+         last = length - EC_ELENGTHSIZE;
+         if (tp->txdata)
+         {
+            memcpy(&frameP[length + EC_HEADERSIZE - EC_ELENGTHSIZE], tp->txdata, tp->length);
+         }
+         else
+         {
+            memset(&frameP[length + EC_HEADERSIZE - EC_ELENGTHSIZE], 0, tp->length);
+         }
+         memcpy(&frameP[length + EC_HEADERSIZE - EC_ELENGTHSIZE + tp->length], tp->trailer, tp->trailerlength);
+         DCO = 0;
+         if (tp->DCO)
+         {
+            /* FRMW datagram with the DC time follows the data */
+            last = length + EC_HEADERSIZE - EC_ELENGTHSIZE + tp->length + EC_WKCSIZE - EC_ELENGTHSIZE;
+            datagramP = (ec_comt *)&frameP[last];
+            datagramP->index = idx;
+            DCO = offset + tp->DCO;
+            memcpy(&frameP[ETH_HEADERSIZE + DCO], context->DCtime, sizeof(int64));
+         }
+         ecx_pushindex(idxstack, idx, groups[i], (uint16)offset, tp->rxdata, tp->length, (uint16)DCO);
+         length += dglength;
+         wkc = 1;
+      }
+   }
+   if (length)
+   {
+      ecx_send_packedframe(context, idx, length);
+   }
+   ecx_txbatch_flush(context->port);
 
-   ecx_clearindex(context);
+   return wkc;
+}
+
+/** Receive processdata of several groups packed by ecx_send_processdata_packed().
+ * The datagrams are split back per group, the inputs are copied to the IOmap
+ * of their group and the work counters are summed per group.
+ * @param[in]  context        = context struct
+ * @param[in]  groups         = group numbers, as passed to ecx_send_processdata_packed()
+ * @param[in]  ngroups        = number of groups
+ * @param[in]  timeout        = Timeout in us per frame.
+ * @param[out] groupwkc       = Work counter of each group, EC_NOFRAME if none of
+ *                              its frames arrived. NULL if not needed.
+ * @return Sum of the work counters, EC_NOFRAME if no frame arrived, EC_ERROR
+ * if the list is empty.
+ */
+int ecx_receive_processdata_packed(ecx_contextt *context, const uint8 *groups, int ngroups, int timeout,
+   int *groupwkc)
+{
+   ec_idxstackT *idxstack;
+   ec_bufT *rxbuf;
+   int pos, i, wkc, wkcf;
+   int lastidx;
+   int valid_wkc = 0;
+   uint16 le_wkc;
+   int64 le_DCtime;
+   uint8 idx;
+   uint16 offset;
+   uint8 *datagram;
+
+   if (!groups || (ngroups <= 0))
+   {
+      return EC_ERROR;
+   }
+   idxstack = &(context->grouplist[groups[0]].idxstack);
+   rxbuf = context->port->rxbuf;
+   if (groupwkc)
+   {
+      for (i = 0; i < ngroups; i++)
+      {
+         groupwkc[i] = EC_NOFRAME;
+      }
+   }
+   wkc = 0;
+   wkcf = EC_NOFRAME;
+   lastidx = -1;
+   pos = ecx_pullindex(idxstack);
+   while (pos >= 0)
+   {
+      idx = idxstack->idx[pos];
+      /* datagrams of one frame are consecutive on the stack */
+      if (idx != lastidx)
+      {
+         if (lastidx >= 0)
+         {
+            ecx_setbufstat(context->port, (uint8)lastidx, EC_BUF_EMPTY);
+         }
+         wkcf = ecx_waitinframe(context->port, idx, timeout);
+         lastidx = idx;
+      }
+      if (wkcf > EC_NOFRAME)
+      {
+         offset = idxstack->offset[pos];
+         datagram = &(rxbuf[idx][offset]);
+         memcpy(&le_wkc, &datagram[EC_HEADERSIZE + idxstack->length[pos]], EC_WKCSIZE);
+         /* output WKC counts 2 times when using LRW, emulate the same for LWR */
+         if (datagram[EC_CMDOFFSET] == EC_CMD_LWR)
+         {
+            le_wkc = htoes(etohs(le_wkc) * 2);
+         }
+         else if (idxstack->data[pos])
+         {
+            memcpy(idxstack->data[pos], &datagram[EC_HEADERSIZE], idxstack->length[pos]);
+         }
+         if (idxstack->dcoffset[pos] > 0)
+         {
+            memcpy(&le_DCtime, &(rxbuf[idx][idxstack->dcoffset[pos]]), sizeof(le_DCtime));
+            *(context->DCtime) = etohll(le_DCtime);
+            ecx_trackDCoffset(context);
+         }
+         wkc += etohs(le_wkc);
+         if (groupwkc)
+         {
+            for (i = 0; i < ngroups; i++)
+            {
+               if (groups[i] == idxstack->group[pos])
+               {
+                  if (groupwkc[i] == EC_NOFRAME)
+                  {
+                     groupwkc[i] = 0;
+                  }
+                  groupwkc[i] += etohs(le_wkc);
+                  break;
+               }
+            }
+         }
+         valid_wkc = 1;
+      }
+      pos = ecx_pullindex(idxstack);
+   }
+   if (lastidx >= 0)
+   {
+      ecx_setbufstat(context->port, (uint8)lastidx, EC_BUF_EMPTY);
+   }
+   ecx_clearindex(idxstack);
 
    /* if no frames has arrived */
    if (valid_wkc == 0)
@@ -1995,6 +3283,101 @@ int ecx_receive_processdata_group(ecx_contextt *context, uint8 group, int timeou
    return wkc;
 }
 
+/** Register a datagram that rides along in the process data frames of a
+ * group. The datagram is appended to the first frame of every interval'th
+ * cycle with room left for it. Its data, work counter and result count are
+ * updated in place when the frame returns, the caller may set an update
+ * callback that is run at that moment. Register after the group is mapped,
+ * mapping the group clears the list.
+ * @param[in]  context        = context struct
+ * @param[in]  group          = group number
+ * @param[in]  com            = command, e.g. EC_CMD_BRD or EC_CMD_FPRD
+ * @param[in]  ADP            = Address Position
+ * @param[in]  ADO            = Address Offset
+ * @param[in]  length         = length of datagram data, max EC_MAXCYCLICDATA
+ * @param[in]  interval       = send every interval'th cycle, 0 is taken as 1
+ * @return datagram descriptor, NULL if the list is full, the group is not
+ * mapped or length too large.
+ */
+ec_cyclicdatagramt *ecx_add_cyclicdatagram(ecx_contextt *context, uint8 group, uint8 com, uint16 ADP, uint16 ADO,
+   uint16 length, uint16 interval)
+{
+   ec_groupt *grp;
+   ec_cyclicdatagramt *dg;
+
+   grp = &(context->grouplist[group]);
+   if ((grp->ncyclic >= EC_MAXCYCLIC) || (length > EC_MAXCYCLICDATA))
+   {
+      return NULL;
+   }
+   /* allocated by the mapping */
+   if (grp->cyclic == NULL)
+   {
+      return NULL;
+   }
+   dg = &(grp->cyclic[grp->ncyclic]);
+   memset(dg, 0x00, sizeof(ec_cyclicdatagramt));
+   dg->command = com;
+   dg->ADP = ADP;
+   dg->ADO = ADO;
+   dg->length = length;
+   dg->interval = interval ? interval : 1;
+   grp->ncyclic++;
+   return dg;
+}
+
+/** Update callback of the AL status datagram, stores the result in the slavelist.
+ * @param[in]  context        = context struct
+ * @param[in]  dg             = datagram descriptor
+ */
+static void ecx_cyclic_alstatus(ecx_contextt *context, ec_cyclicdatagramt *dg)
+{
+   ec_alstatust alstat;
+
+   if (dg->wkc > 0)
+   {
+      memcpy(&alstat, dg->data, dg->length);
+      context->slavelist[dg->slave].state = etohs(alstat.alstatus);
+      if (dg->slave)
+      {
+         context->slavelist[dg->slave].ALstatuscode = etohs(alstat.alstatuscode);
+      }
+      ecx_update_slavestate(context, dg->slave);
+   }
+}
+
+/** Register an AL status read that rides along in the process data frames
+ * of a group, so the state of the slaves is monitored without extra frames.
+ * For slave 0 the ORed state of all slaves is read with BRD and stored in
+ * slavelist[0].state, the work counter tells how many slaves answered.
+ * Otherwise the AL status and status code of the slave are read with FPRD
+ * and stored in its slavelist entry.
+ * @param[in]  context        = context struct
+ * @param[in]  group          = group number
+ * @param[in]  slave          = slave number, 0 for all slaves
+ * @param[in]  interval       = read every interval'th cycle
+ * @return datagram descriptor, NULL if the list is full.
+ */
+ec_cyclicdatagramt *ecx_add_alstatusdatagram(ecx_contextt *context, uint8 group, uint16 slave, uint16 interval)
+{
+   ec_cyclicdatagramt *dg;
+
+   if (slave == 0)
+   {
+      dg = ecx_add_cyclicdatagram(context, group, EC_CMD_BRD, 0x0000, ECT_REG_ALSTAT, sizeof(uint16), interval);
+   }
+   else
+   {
+      dg = ecx_add_cyclicdatagram(context, group, EC_CMD_FPRD, context->slavelist[slave].configadr,
+                                  ECT_REG_ALSTAT, sizeof(ec_alstatust), interval);
+   }
+   if (dg)
+   {
+      dg->slave = slave;
+      dg->update = ecx_cyclic_alstatus;
+   }
+   return dg;
+}
 
 int ecx_send_processdata(ecx_contextt *context)
 {
@@ -2350,6 +3733,17 @@ uint32 ec_readeeprom2(uint16 slave, int timeout)
    return ecx_readeeprom2 (&ecx_context, slave, timeout);
 }
 
+/** Precompile the process data frames of a group.
+ * @param[in]  group          = group number
+ * @param[in]  overlap        = TRUE to compile for the overlapping IOmap
+ * @return number of frames per cycle
+ * @see ecx_compile_group
+ */
+int ec_compile_group(uint8 group, boolean overlap)
+{
+   return ecx_compile_group(&ecx_context, group, overlap);
+}
+
 /** Transmit processdata to slaves.
  * Uses LRW, or LRD/LWR if LRW is not allowed (blockLRW).
  * Both the input and output processdata are transmitted.
@@ -2384,6 +3778,17 @@ int ec_send_overlap_processdata_group(uint8 group)
    return ecx_send_overlap_processdata_group(&ecx_context, group);
 }
 
+/** Transmit processdata to slaves at a launch time.
+ * @param[in]  group          = group number
+ * @param[in]  launchtime     = launch time in ns
+ * @return >0 if processdata is transmitted.
+ * @see ecx_send_timed_processdata_group
+ */
+int ec_send_timed_processdata_group(uint8 group, int64 launchtime)
+{
+   return ecx_send_timed_processdata_group(&ecx_context, group, launchtime);
+}
+
 /** Receive processdata from slaves.
  * Second part from ec_send_processdata().
  * Received datagrams are recombined with the processdata with help from the stack.
@@ -2398,6 +3803,104 @@ int ec_receive_processdata_group(uint8 group, int timeout)
    return ecx_receive_processdata_group (&ecx_context, group, timeout);
 }
 
+/** Receive processdata from slaves with one deadline for the whole cycle.
+ * @param[in]  group          = group number
+ * @param[in]  deadline       = Timer started by the caller, e.g. at the start of the cycle.
+ * @param[out] status         = Work counter of each frame and number of lost frames, NULL if not needed.
+ * @return Work counter.
+ * @see ecx_receive_processdata_deadline
+ */
+int ec_receive_processdata_deadline(uint8 group, osal_timert *deadline, ec_framestatust *status)
+{
+   return ecx_receive_processdata_deadline(&ecx_context, group, deadline, status);
+}
+
+/** Transmit processdata to slaves without waiting for the previous cycles.
+ * @param[in]  group          = group number
+ * @param[out] cycle          = tag of the transmitted cycle, NULL if not needed
+ * @return >0 if processdata is transmitted, 0 if EC_MAXPIPELINE cycles are in flight.
+ * @see ecx_send_processdata_pipelined
+ */
+int ec_send_processdata_pipelined(uint8 group, uint32 *cycle)
+{
+   return ecx_send_processdata_pipelined(&ecx_context, group, cycle);
+}
+
+/** Transmit processdata to slaves without waiting for the previous cycles.
+ * @param[in]  group          = group number
+ * @param[out] cycle          = tag of the transmitted cycle, NULL if not needed
+ * @return >0 if processdata is transmitted, 0 if EC_MAXPIPELINE cycles are in flight.
+ * @see ecx_send_overlap_processdata_pipelined
+ */
+int ec_send_overlap_processdata_pipelined(uint8 group, uint32 *cycle)
+{
+   return ecx_send_overlap_processdata_pipelined(&ecx_context, group, cycle);
+}
+
+/** Receive the oldest pipelined processdata cycle in flight.
+ * @param[in]  group          = group number
+ * @param[in]  timeout        = Timeout in us.
+ * @param[out] cycle          = tag of the received cycle, NULL if not needed
+ * @return Work counter, EC_NOFRAME if no cycle is in flight.
+ * @see ecx_receive_processdata_pipelined
+ */
+int ec_receive_processdata_pipelined(uint8 group, int timeout, uint32 *cycle)
+{
+   return ecx_receive_processdata_pipelined(&ecx_context, group, timeout, cycle);
+}
+
+/** Transmit processdata of several groups packed into shared frames.
+ * @param[in]  groups         = group numbers
+ * @param[in]  ngroups        = number of groups
+ * @return >0 if processdata is transmitted.
+ * @see ecx_send_processdata_packed
+ */
+int ec_send_processdata_packed(const uint8 *groups, int ngroups)
+{
+   return ecx_send_processdata_packed(&ecx_context, groups, ngroups);
+}
+
+/** Receive processdata of several groups packed into shared frames.
+ * @param[in]  groups         = group numbers, as passed to ec_send_processdata_packed()
+ * @param[in]  ngroups        = number of groups
+ * @param[in]  timeout        = Timeout in us per frame.
+ * @param[out] groupwkc       = Work counter of each group, NULL if not needed.
+ * @return Sum of the work counters, EC_NOFRAME if no frame arrived.
+ * @see ecx_receive_processdata_packed
+ */
+int ec_receive_processdata_packed(const uint8 *groups, int ngroups, int timeout, int *groupwkc)
+{
+   return ecx_receive_processdata_packed(&ecx_context, groups, ngroups, timeout, groupwkc);
+}
+
+/** Register a datagram that rides along in the process data frames of a group.
+ * @param[in]  group          = group number
+ * @param[in]  com            = command, e.g. EC_CMD_BRD or EC_CMD_FPRD
+ * @param[in]  ADP            = Address Position
+ * @param[in]  ADO            = Address Offset
+ * @param[in]  length         = length of datagram data, max EC_MAXCYCLICDATA
+ * @param[in]  interval       = send every interval'th cycle
+ * @return datagram descriptor, NULL if the list is full or length too large.
+ * @see ecx_add_cyclicdatagram
+ */
+ec_cyclicdatagramt *ec_add_cyclicdatagram(uint8 group, uint8 com, uint16 ADP, uint16 ADO, uint16 length,
+   uint16 interval)
+{
+   return ecx_add_cyclicdatagram(&ecx_context, group, com, ADP, ADO, length, interval);
+}
+
+/** Register an AL status read that rides along in the process data frames of a group.
+ * @param[in]  group          = group number
+ * @param[in]  slave          = slave number, 0 for all slaves
+ * @param[in]  interval       = read every interval'th cycle
+ * @return datagram descriptor, NULL if the list is full.
+ * @see ecx_add_alstatusdatagram
+ */
+ec_cyclicdatagramt *ec_add_alstatusdatagram(uint8 group, uint16 slave, uint16 interval)
+{
+   return ecx_add_alstatusdatagram(&ecx_context, group, slave, interval);
+}
+
 int ec_send_processdata(void)
 {
    return ec_send_processdata_group(0);
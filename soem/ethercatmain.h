@@ -22,15 +22,37 @@ extern "C"
 /** max. length of readable name in slavelist and Object Description List */
 #define EC_MAXNAME        40
 /** max. number of slaves in array */
-#define EC_MAXSLAVE       200
+#ifndef EC_MAXSLAVE
+#   define EC_MAXSLAVE       200
+#endif
 /** max. number of groups */
-#define EC_MAXGROUP       2
-/** max. number of IO segments per group */
-#define EC_MAXIOSEGMENTS  64
+#ifndef EC_MAXGROUP
+#   define EC_MAXGROUP       2
+#endif
+/** default max. number of IO segments per group, see ecx_contextt.maxsegments */
+#ifndef EC_MAXIOSEGMENTS
+#   define EC_MAXIOSEGMENTS  64
+#endif
+/** number of frames of a process data transfer reported in ec_framestatust,
+ * a LRD and a LWR for each IO segment */
+#define EC_MAXIDXSTACK    (2 * EC_MAXIOSEGMENTS)
+/** max. length of the part of a process data frame following the data,
+ * WKC and FRMW datagram with DC time and its WKC */
+#define EC_FRAMETRAILER   (EC_WKCSIZE + EC_HEADERSIZE - EC_ELENGTHSIZE + sizeof(int64) + EC_WKCSIZE)
+/** DCsegment of a group without DC slaves, no frame carries the FRMW */
+#define EC_NODCSEGMENT    0xffff
+/** max. number of pipelined process data cycles in flight per group */
+#define EC_MAXPIPELINE    4
+/** max. number of datagrams riding along in the process data frames per group */
+#define EC_MAXCYCLIC      8
+/** max. data length of a datagram riding along in the process data frames */
+#define EC_MAXCYCLICDATA  32
 /** max. mailbox size */
 #define EC_MAXMBX         1486
 /** max. eeprom PDO entries */
-#define EC_MAXEEPDO       0x200
+#ifndef EC_MAXEEPDO
+#   define EC_MAXEEPDO       0x200
+#endif
 /** max. SM used */
 #define EC_MAXSM          8
 /** max. FMMU used */
@@ -233,8 +255,121 @@ typedef struct ec_slave
    int              (*PO2SOconfigx)(ecx_contextt * context, uint16 slave);
    /** readable name */
    char             name[EC_MAXNAME + 1];
+   /** first entry of the slave in the PDO entry table */
+   uint16           firstPDOentry;
+   /** number of entries of the slave in the PDO entry table */
+   uint16           nPDOentry;
 } ec_slavet;
 
+/** Cyclic part of a slave. The fields the process data and state checks use
+ * every cycle, copied out of ec_slavet into a compact array so walking the
+ * slaves touches one small record per slave. Kept in sync by the
+ * configuration, mapping and state functions, ec_slavet stays the master copy.
+ */
+typedef struct ec_slavecyclic
+{
+   /** pointer to output data in IOmap */
+   uint8            *outputs;
+   /** pointer to input data in IOmap */
+   uint8            *inputs;
+   /** output bytes, if Obits < 8 then Obytes = 0 */
+   uint32           Obytes;
+   /** input bytes, if Ibits < 8 then Ibytes = 0 */
+   uint32           Ibytes;
+   /** output bits */
+   uint16           Obits;
+   /** input bits */
+   uint16           Ibits;
+   /** state of slave */
+   uint16           state;
+   /** AL status code */
+   uint16           ALstatuscode;
+   /** Configured address */
+   uint16           configadr;
+   /** startbit in first output byte */
+   uint8            Ostartbit;
+   /** startbit in first input byte */
+   uint8            Istartbit;
+   /** group */
+   uint8            group;
+} ec_slavecyclict;
+
+/** stack structure to store segmented LRD/LWR/LRW constructs. The entries
+ * are allocated in one block when the group is mapped, see
+ * ecx_alloc_group(). */
+typedef struct ec_idxstack
+{
+   uint16  pushed;
+   uint16  pulled;
+   /** number of entries allocated, 0 if none */
+   uint16  size;
+   /** cycle tag of a pipelined cycle, see ecx_send_processdata_pipelined() */
+   uint32  cycle;
+   /** TRUE to copy only the input area back, used by pipelined cycles */
+   boolean inputsonly;
+   uint8   *idx;
+   void    **data;
+   uint16  *length;
+   uint16  *dcoffset;
+   /** group of the datagram, frames can hold datagrams of several groups */
+   uint8   *group;
+   /** offset of the datagram in the rx buffer, 0 for the first datagram */
+   uint16  *offset;
+} ec_idxstackT;
+
+/** precompiled process data frame of one IO segment, see ecx_compile_group() */
+typedef struct ec_frametemplate
+{
+   /** EtherCAT header of the frame, the index is set per cycle */
+   uint8            header[EC_HEADERSIZE];
+   /** part of the frame following the data */
+   uint8            trailer[EC_FRAMETRAILER];
+   /** length of trailer */
+   uint16           trailerlength;
+   /** length of data */
+   uint16           length;
+   /** offset of DC time in rx frame, 0 if the frame has no DC datagram */
+   uint16           DCO;
+   /** data transmitted, NULL if the data part is cleared (LRD) */
+   uint8            *txdata;
+   /** destination of the returning data in the IOmap */
+   uint8            *rxdata;
+} ec_frametemplatet;
+
+/** datagram riding along in the process data frames of a group, see
+ * ecx_add_cyclicdatagram() */
+typedef struct ec_cyclicdatagram
+{
+   /** command, e.g. EC_CMD_BRD or EC_CMD_FPRD */
+   uint8            command;
+   /** address position */
+   uint16           ADP;
+   /** address offset */
+   uint16           ADO;
+   /** length of data */
+   uint16           length;
+   /** transmitted every interval cycles, 1 = every cycle */
+   uint16           interval;
+   /** slave the result belongs to, 0 for broadcasts */
+   uint16           slave;
+   /** data transmitted, replaced by the returned data */
+   uint8            data[EC_MAXCYCLICDATA];
+   /** work counter of the last result */
+   int              wkc;
+   /** number of results received */
+   uint32           results;
+   /** called after a result arrived, e.g. to update the slave list. NULL if none */
+   void             (*update)(ecx_contextt *context, struct ec_cyclicdatagram *dg);
+   /** internal, datagram waits for a frame with room for it */
+   boolean          due;
+   /** internal, datagram is in flight in frame idx */
+   boolean          pending;
+   /** internal, frame of the datagram */
+   uint8            idx;
+   /** internal, offset of the data in the rx frame */
+   uint16           dataoffset;
+} ec_cyclicdatagramt;
+
 /** for list of ethercat slave groups */
 typedef struct ec_group
 {
@@ -262,14 +397,51 @@ typedef struct ec_group
    uint16           Isegment;
    /** Offset in input segment */
    uint16           Ioffset;
+   /** segment whose frame carries the FRMW of the DC time, set by the
+    * mapping functions. Room for the FRMW is kept in this segment only. */
+   uint16           DCsegment;
    /** Expected workcounter outputs */
    uint16           outputsWKC;
    /** Expected workcounter inputs */
    uint16           inputsWKC;
    /** check slave states */
    boolean          docheckstate;
-   /** IO segmentation list. Datagrams must not break SM in two. */
-   uint32           IOsegment[EC_MAXIOSEGMENTS];
+   /** frames of a process data cycle, set by the mapping functions */
+   uint16           nframes;
+   /** IO segmentation list. Datagrams must not break SM in two. Allocated
+    * with maxsegments entries by the mapping functions. */
+   uint32           *IOsegment;
+   /** entries of IOsegment */
+   uint16           maxsegments;
+   /** TRUE if mapped with ecx_config_overlap_map_group() */
+   boolean          overlapmap;
+   /** number of precompiled frames, 0 if the group is not compiled */
+   uint16           ntemplates;
+   /** TRUE if the frames are compiled for the overlapping IOmap */
+   boolean          templateoverlap;
+   /** precompiled frames in transmit order, allocated by ecx_alloc_group() */
+   ec_frametemplatet *templates;
+   /** entries of templates */
+   uint16           maxtemplates;
+   /** process data frames in flight between send and receive. Every group
+    * has its own, so groups can be cycled from different threads. */
+   ec_idxstackT     idxstack;
+   /** EC_MAXPIPELINE pipelined cycles, see ecx_send_processdata_pipelined(),
+    * allocated by ecx_alloc_group() */
+   ec_idxstackT     *pipeline;
+   /** next pipeline entry to transmit */
+   uint8            pipehead;
+   /** number of pipelined cycles in flight */
+   uint8            pipecount;
+   /** tag of the next pipelined cycle */
+   uint32           pipecycle;
+   /** number of datagrams riding along */
+   uint8            ncyclic;
+   /** EC_MAXCYCLIC datagrams riding along in the process data frames,
+    * allocated by ecx_alloc_group() */
+   ec_cyclicdatagramt *cyclic;
+   /** number of process data cycles transmitted */
+   uint32           cyclecount;
 } ec_groupt;
 
 /** SII FMMU structure */
@@ -332,16 +504,18 @@ typedef struct PACKED ec_alstatus
 } ec_alstatust;
 PACKED_END
 
-/** stack structure to store segmented LRD/LWR/LRW constructs */
-typedef struct ec_idxstack
+/** receive status of the frames of a process data cycle, one frame per IO
+ * segment in the order they were transmitted */
+typedef struct ec_framestatus
 {
-   uint8   pushed;
-   uint8   pulled;
-   uint8   idx[EC_MAXBUF];
-   void    *data[EC_MAXBUF];
-   uint16  length[EC_MAXBUF];
-   uint16  dcoffset[EC_MAXBUF];
-} ec_idxstackT;
+   /** number of frames of the cycle */
+   uint16  frames;
+   /** number of frames not received before the deadline */
+   uint16  lost;
+   /** work counter of each frame, EC_NOFRAME if lost. Only the first
+    * EC_MAXIDXSTACK frames are listed. */
+   int     wkc[EC_MAXIDXSTACK];
+} ec_framestatust;
 
 /** ringbuf for error storage */
 typedef struct ec_ering
@@ -381,6 +555,41 @@ typedef struct PACKED ec_PDOdesc
 } ec_PDOdesct;
 PACKED_END
 
+/** One object mapped in the process data of a slave, as found while reading
+ * the PDO mapping, with its place in the IOmap */
+typedef struct ec_PDOentry
+{
+   /** object index, 0 for a gap */
+   uint16  index;
+   /** object subindex */
+   uint8   subindex;
+   /** length in bits */
+   uint8   bitlength;
+   /** PDO the object is mapped in */
+   uint16  PDO;
+   /** SM of the PDO */
+   uint8   SM;
+   /** TRUE for an output (RxPDO), FALSE for an input (TxPDO) */
+   uint8   output;
+   /** bit position in the data of the SM */
+   uint32  SMbit;
+   /** byte offset from the start of the IOmap of the group */
+   uint32  offset;
+   /** bit in the byte at offset */
+   uint8   bit;
+} ec_PDOentryt;
+
+/** PDO entries recorded by one mapper thread, see ecx_startPDOthreads() */
+typedef struct ec_PDOrecord
+{
+   /** slave being recorded, 0 if none */
+   uint16        slave;
+   /** number of entries recorded */
+   int           n;
+   /** recorded entries, maxPDOentry of them */
+   ec_PDOentryt  *entry;
+} ec_PDOrecordt;
+
 /** Context structure , referenced by all ecx functions*/
 struct ecx_context
 {
@@ -404,7 +613,7 @@ struct ecx_context
    uint16         esislave;
    /** internal, reference to error list */
    ec_eringt      *elist;
-   /** internal, reference to processdata stack buffer info */
+   /** internal, unused, the processdata stacks are kept per group */
    ec_idxstackT   *idxstack;
    /** reference to ecaterror state */
    boolean        *ecaterror;
@@ -429,13 +638,52 @@ struct ecx_context
    /** userdata, promotes application configuration esp. in EC_VER2 with multiple 
     * ec_context instances. Note: userdata memory is managed by application, not SOEM */
    void           *userdata;
+   /** internal, slavelist allocated by ecx_create_context(), it grows to the
+    * number of slaves found */
+   boolean        ownslavelist;
+   /** cyclic part of the slavelist, same numbering, NULL if not kept */
+   ec_slavecyclict *slavecyclic;
+   /** PDO entry table of all slaves, provided by the application, NULL if not kept */
+   ec_PDOentryt   *PDOentry;
+   /** size of the PDO entry table */
+   int            maxPDOentry;
+   /** internal, entries in use in the PDO entry table */
+   int            nPDOentry;
+   /** internal, slave the PDO entries are being recorded for, 0 if none */
+   uint16         PDOentryslave;
+   /** internal, records of the mapper threads, NULL if mapping in one thread */
+   ec_PDOrecordt  *PDOrecord;
+   /** internal, mapper thread of each slave while PDOrecord is in use */
+   uint8          *PDOthread;
+   /** IO segments per group allocated by the mapping functions, 0 selects
+    * EC_MAXIOSEGMENTS. Set before mapping. */
+   int            maxsegments;
+   /** internal, groups hold memory allocated by the mapping, see ecx_free_groups() */
+   boolean        groupalloc;
+   /** internal, launch time clock minus DC time, tracked while the DC time
+    * is received, 0 if unknown, see ecx_dclaunchtime() */
+   int64          DCtxoffset;
 };
 
+/** Sizes of the tables of a context made by ecx_create_context() */
+typedef struct ec_contextsize
+{
+   /** slavelist entries including the master record, 0 to size it from the
+    * number of slaves found */
+   int            maxslave;
+   /** grouplist entries */
+   int            maxgroup;
+   /** IO segments per group, 0 selects EC_MAXIOSEGMENTS */
+   int            maxsegments;
+} ec_contextsizet;
+
 #ifdef EC_VER1
 /** global struct to hold default master context */
 extern ecx_contextt  ecx_context;
 /** main slave data structure array */
 extern ec_slavet   ec_slave[EC_MAXSLAVE];
+/** cyclic part of the slave data */
+extern ec_slavecyclict ec_slavecyclic[EC_MAXSLAVE];
 /** number of slaves found by configuration function */
 extern int         ec_slavecount;
 /** slave group structure */
@@ -474,9 +722,19 @@ uint64 ec_readeepromFP(uint16 configadr, uint16 eeproma, int timeout);
 int ec_writeeepromFP(uint16 configadr, uint16 eeproma, uint16 data, int timeout);
 void ec_readeeprom1(uint16 slave, uint16 eeproma);
 uint32 ec_readeeprom2(uint16 slave, int timeout);
+int ec_compile_group(uint8 group, boolean overlap);
 int ec_send_processdata_group(uint8 group);
 int ec_send_overlap_processdata_group(uint8 group);
+int ec_send_timed_processdata_group(uint8 group, int64 launchtime);
 int ec_receive_processdata_group(uint8 group, int timeout);
+int ec_receive_processdata_deadline(uint8 group, osal_timert *deadline, ec_framestatust *status);
+int ec_send_processdata_pipelined(uint8 group, uint32 *cycle);
+int ec_send_overlap_processdata_pipelined(uint8 group, uint32 *cycle);
+int ec_receive_processdata_pipelined(uint8 group, int timeout, uint32 *cycle);
+int ec_send_processdata_packed(const uint8 *groups, int ngroups);
+ec_cyclicdatagramt *ec_add_cyclicdatagram(uint8 group, uint8 com, uint16 ADP, uint16 ADO, uint16 length, uint16 interval);
+ec_cyclicdatagramt *ec_add_alstatusdatagram(uint8 group, uint16 slave, uint16 interval);
+int ec_receive_processdata_packed(const uint8 *groups, int ngroups, int timeout, int *groupwkc);
 int ec_send_processdata(void);
 int ec_send_overlap_processdata(void);
 int ec_receive_processdata(int timeout);
@@ -493,6 +751,13 @@ void ecx_packeterror(ecx_contextt *context, uint16 Slave, uint16 Index, uint8 Su
 int ecx_init(ecx_contextt *context, const char * ifname);
 int ecx_init_redundant(ecx_contextt *context, ecx_redportt *redport, const char *ifname, char *if2name);
 void ecx_close(ecx_contextt *context);
+ecx_contextt *ecx_create_context(const ec_contextsizet *size);
+void ecx_destroy_context(ecx_contextt *context);
+int ecx_alloc_group(ecx_contextt *context, uint8 group);
+void ecx_free_groups(ecx_contextt *context);
+int ecx_resize_slavelist(ecx_contextt *context, int maxslave);
+void ecx_update_slavecyclic(ecx_contextt *context);
+void ecx_update_slavecyclic_slave(ecx_contextt *context, uint16 slave);
 uint8 ecx_siigetbyte(ecx_contextt *context, uint16 slave, uint16 address);
 int16 ecx_siifind(ecx_contextt *context, uint16 slave, uint16 cat);
 void ecx_siistring(ecx_contextt *context, char *str, uint16 slave, uint16 Sn);
@@ -518,10 +783,21 @@ int ecx_writeeepromFP(ecx_contextt *context, uint16 configadr, uint16 eeproma, u
 void ecx_readeeprom1(ecx_contextt *context, uint16 slave, uint16 eeproma);
 uint32 ecx_readeeprom2(ecx_contextt *context, uint16 slave, int timeout);
 int ecx_send_overlap_processdata_group(ecx_contextt *context, uint8 group);
+int ecx_send_timed_processdata_group(ecx_contextt *context, uint8 group, int64 launchtime);
 int ecx_receive_processdata_group(ecx_contextt *context, uint8 group, int timeout);
+int ecx_receive_processdata_deadline(ecx_contextt *context, uint8 group, osal_timert *deadline, ec_framestatust *status);
+int ecx_send_processdata_pipelined(ecx_contextt *context, uint8 group, uint32 *cycle);
+int ecx_send_overlap_processdata_pipelined(ecx_contextt *context, uint8 group, uint32 *cycle);
+int ecx_receive_processdata_pipelined(ecx_contextt *context, uint8 group, int timeout, uint32 *cycle);
+int ecx_send_processdata_packed(ecx_contextt *context, const uint8 *groups, int ngroups);
+ec_cyclicdatagramt *ecx_add_cyclicdatagram(ecx_contextt *context, uint8 group, uint8 com, uint16 ADP, uint16 ADO,
+   uint16 length, uint16 interval);
+ec_cyclicdatagramt *ecx_add_alstatusdatagram(ecx_contextt *context, uint8 group, uint16 slave, uint16 interval);
+int ecx_receive_processdata_packed(ecx_contextt *context, const uint8 *groups, int ngroups, int timeout, int *groupwkc);
 int ecx_send_processdata(ecx_contextt *context);
 int ecx_send_overlap_processdata(ecx_contextt *context);
 int ecx_receive_processdata(ecx_contextt *context, int timeout);
+int ecx_compile_group(ecx_contextt *context, uint8 group, boolean overlap);
 int ecx_send_processdata_group(ecx_contextt *context, uint8 group);
 
 #ifdef __cplusplus
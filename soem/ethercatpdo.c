@@ -0,0 +1,461 @@
+/*
+ * Licensed under the GNU General Public License version 2 with exceptions. See
+ * LICENSE file in the project root for full license information
+ */
+
+/** \file
+ * \brief
+ * PDO entry table.
+ *
+ * While the PDO mapping of the slaves is read, by CoE or from the SII, the
+ * mapped objects are recorded in a table provided by the application in
+ * context->PDOentry. After the IOmap is configured every entry knows its
+ * byte and bit in the IOmap, so objects can be found by index and
+ * subindex, and a header with constant offsets can be made for a fixed line.
+ * The entries of a slave are consecutive in the table. Mapper threads,
+ * EC_MAX_MAPT > 1, record in a table of their own that is merged into the
+ * shared table by the thread that started them.
+ */
+#include <stdio.h>
+#include <string.h>
+#include "osal.h"
+#include "oshw.h"
+#include "ethercattype.h"
+#include "ethercatbase.h"
+#include "ethercatmain.h"
+#include "ethercatpdo.h"
+
+/** Start recording the PDO entries of a slave, entries recorded before for
+ * it are dropped when they are the last in the table.
+ * @param[in]  context        = context struct
+ * @param[in]  slave          = slave number, 0 to stop recording
+ */
+void ecx_beginPDOentries(ecx_contextt *context, uint16 slave)
+{
+   ec_slavet *sl;
+   ec_PDOrecordt *rec;
+
+   if (context->PDOentry == NULL)
+   {
+      return;
+   }
+   /* mapper thread, the record is merged by ecx_mergePDOentries() */
+   if (context->PDOrecord)
+   {
+      if (slave)
+      {
+         rec = &(context->PDOrecord[context->PDOthread[slave]]);
+         rec->slave = slave;
+         rec->n = 0;
+      }
+      return;
+   }
+   context->PDOentryslave = slave;
+   if (slave)
+   {
+      sl = &(context->slavelist[slave]);
+      if (sl->nPDOentry && ((sl->firstPDOentry + sl->nPDOentry) == context->nPDOentry))
+      {
+         context->nPDOentry = sl->firstPDOentry;
+      }
+      sl->firstPDOentry = (uint16)context->nPDOentry;
+      sl->nPDOentry = 0;
+   }
+}
+
+/** Record one mapped object of the slave being recorded. Entries that do
+ * not fit in the table are not kept.
+ * @param[in]  context        = context struct
+ * @param[in]  slave          = slave number
+ * @param[in]  PDO            = PDO the object is mapped in
+ * @param[in]  SM             = SM of the PDO
+ * @param[in]  output         = TRUE for an output (RxPDO)
+ * @param[in]  mapping        = object mapping, index << 16 | subindex << 8 | bitlength
+ */
+void ecx_addPDOentry(ecx_contextt *context, uint16 slave, uint16 PDO, uint8 SM, boolean output, uint32 mapping)
+{
+   ec_slavet *sl;
+   ec_PDOrecordt *rec;
+   ec_PDOentryt *first;
+   ec_PDOentryt *entry;
+   uint32 SMbit;
+   int i, n;
+
+   if (context->PDOentry == NULL)
+   {
+      return;
+   }
+   if (context->PDOrecord)
+   {
+      rec = &(context->PDOrecord[context->PDOthread[slave]]);
+      if ((slave != rec->slave) || (rec->n >= context->maxPDOentry))
+      {
+         return;
+      }
+      first = rec->entry;
+      n = rec->n++;
+   }
+   else
+   {
+      if ((slave != context->PDOentryslave) || (context->nPDOentry >= context->maxPDOentry))
+      {
+         return;
+      }
+      sl = &(context->slavelist[slave]);
+      first = &(context->PDOentry[sl->firstPDOentry]);
+      n = context->nPDOentry - sl->firstPDOentry;
+      context->nPDOentry++;
+      sl->nPDOentry++;
+   }
+   /* objects follow each other in the data of their SM */
+   SMbit = 0;
+   for (i = 0; i < n; i++)
+   {
+      if (first[i].SM == SM)
+      {
+         SMbit += first[i].bitlength;
+      }
+   }
+   entry = &(first[n]);
+   memset(entry, 0x00, sizeof(ec_PDOentryt));
+   entry->index = (uint16)(mapping >> 16);
+   entry->subindex = (uint8)(mapping >> 8);
+   entry->bitlength = (uint8)mapping;
+   entry->PDO = PDO;
+   entry->SM = SM;
+   entry->output = output;
+   entry->SMbit = SMbit;
+}
+
+/** Let mapper threads record PDO entries, each thread in a record of its
+ * own. Called before the mapper threads are started, the records are moved
+ * into the table by ecx_mergePDOentries() and ecx_finishPDOthreads().
+ * @param[in]  context        = context struct
+ * @param[in]  threads        = number of mapper threads
+ * @return TRUE if the threads can map, FALSE if out of memory, map in one
+ * thread then.
+ */
+boolean ecx_startPDOthreads(ecx_contextt *context, int threads)
+{
+   ec_PDOentryt *entry;
+   int i;
+
+   if (context->PDOentry == NULL)
+   {
+      return TRUE;
+   }
+   context->PDOrecord = (ec_PDOrecordt *)osal_malloc(threads * sizeof(ec_PDOrecordt));
+   context->PDOthread = (uint8 *)osal_malloc(context->maxslave);
+   entry = (ec_PDOentryt *)osal_malloc(threads * context->maxPDOentry * sizeof(ec_PDOentryt));
+   if ((context->PDOrecord == NULL) || (context->PDOthread == NULL) || (entry == NULL))
+   {
+      if (context->PDOrecord)
+      {
+         osal_free(context->PDOrecord);
+      }
+      if (context->PDOthread)
+      {
+         osal_free(context->PDOthread);
+      }
+      if (entry)
+      {
+         osal_free(entry);
+      }
+      context->PDOrecord = NULL;
+      context->PDOthread = NULL;
+      return FALSE;
+   }
+   memset(context->PDOthread, 0x00, context->maxslave);
+   for (i = 0; i < threads; i++)
+   {
+      context->PDOrecord[i].slave = 0;
+      context->PDOrecord[i].n = 0;
+      context->PDOrecord[i].entry = &(entry[i * context->maxPDOentry]);
+   }
+   return TRUE;
+}
+
+/** Move the entries a mapper thread recorded for its last slave into the
+ * table and hand the record of the thread to the next slave. Called by the
+ * thread that starts the mapper threads, when the mapper thread is done.
+ * @param[in]  context        = context struct
+ * @param[in]  thread_n       = mapper thread
+ * @param[in]  slave          = next slave of the thread, 0 if none
+ */
+void ecx_mergePDOentries(ecx_contextt *context, int thread_n, uint16 slave)
+{
+   ec_PDOrecordt *rec;
+   ec_slavet *sl;
+   int i;
+
+   if (context->PDOrecord == NULL)
+   {
+      return;
+   }
+   rec = &(context->PDOrecord[thread_n]);
+   if (rec->slave)
+   {
+      sl = &(context->slavelist[rec->slave]);
+      sl->firstPDOentry = (uint16)context->nPDOentry;
+      sl->nPDOentry = 0;
+      for (i = 0; (i < rec->n) && (context->nPDOentry < context->maxPDOentry); i++)
+      {
+         context->PDOentry[context->nPDOentry++] = rec->entry[i];
+         sl->nPDOentry++;
+      }
+   }
+   rec->slave = 0;
+   rec->n = 0;
+   if (slave)
+   {
+      context->PDOthread[slave] = (uint8)thread_n;
+   }
+}
+
+/** Merge the records of all mapper threads into the table and go back to
+ * recording in one thread. Called after all mapper threads are done.
+ * @param[in]  context        = context struct
+ * @param[in]  threads        = number of mapper threads
+ */
+void ecx_finishPDOthreads(ecx_contextt *context, int threads)
+{
+   int i;
+
+   if (context->PDOrecord == NULL)
+   {
+      return;
+   }
+   for (i = 0; i < threads; i++)
+   {
+      ecx_mergePDOentries(context, i, 0);
+   }
+   /* the entries of all records are one block */
+   osal_free(context->PDOrecord[0].entry);
+   osal_free(context->PDOrecord);
+   osal_free(context->PDOthread);
+   context->PDOrecord = NULL;
+   context->PDOthread = NULL;
+}
+
+/** Record the PDO entries of a slave as a copy of those of a slave with the
+ * same mapping.
+ * @param[in]  context        = context struct
+ * @param[in]  slave          = slave number
+ * @param[in]  fromslave      = slave number to copy from
+ */
+void ecx_copyPDOentries(ecx_contextt *context, uint16 slave, uint16 fromslave)
+{
+   int i, n;
+
+   if (context->PDOentry == NULL)
+   {
+      return;
+   }
+   ecx_beginPDOentries(context, slave);
+   n = context->slavelist[fromslave].nPDOentry;
+   for (i = context->slavelist[fromslave].firstPDOentry; n && (context->nPDOentry < context->maxPDOentry); i++, n--)
+   {
+      context->PDOentry[context->nPDOentry++] = context->PDOentry[i];
+      context->slavelist[slave].nPDOentry++;
+   }
+   ecx_beginPDOentries(context, 0);
+}
+
+/** Mapped size of the data of one SM of a slave, the sum of the bit lengths
+ * of its recorded entries. The data of an SM starts on a byte in the ESC, so
+ * the size is rounded up to whole bytes.
+ * @param[in]  context        = context struct
+ * @param[in]  sl             = slave
+ * @param[in]  SM             = SM number
+ * @param[in]  output         = TRUE for the output entries
+ * @return size in bits
+ */
+static uint32 ecx_SMbits(ecx_contextt *context, ec_slavet *sl, uint8 SM, boolean output)
+{
+   uint32 bits = 0;
+   int i;
+
+   for (i = sl->firstPDOentry; i < (sl->firstPDOentry + sl->nPDOentry); i++)
+   {
+      if ((context->PDOentry[i].SM == SM) && ((boolean)context->PDOentry[i].output == output))
+      {
+         bits += context->PDOentry[i].bitlength;
+      }
+   }
+   return (bits + 7) & ~(uint32)7;
+}
+
+/** Find the place in the IOmap of the PDO entries of the slaves of a group.
+ * Called by the map functions once the IO of the slaves is mapped.
+ * @param[in]  context        = context struct
+ * @param[in]  group          = group number, 0 for all groups
+ */
+void ecx_locatePDOentries(ecx_contextt *context, uint8 group)
+{
+   ec_slavet *sl;
+   ec_PDOentryt *entry;
+   uint8 *base;
+   uint32 pos;
+   int slave, i, SMc;
+
+   if (context->PDOentry == NULL)
+   {
+      return;
+   }
+   for (slave = 1; slave <= *(context->slavecount); slave++)
+   {
+      sl = &(context->slavelist[slave]);
+      if (group && (group != sl->group))
+      {
+         continue;
+      }
+      for (i = sl->firstPDOentry; i < (sl->firstPDOentry + sl->nPDOentry); i++)
+      {
+         entry = &(context->PDOentry[i]);
+         base = entry->output ? sl->outputs : sl->inputs;
+         if (base == NULL)
+         {
+            continue;
+         }
+         pos = (entry->output ? sl->Ostartbit : sl->Istartbit) + entry->SMbit;
+         /* the data of the SMs of one direction follow each other in SM order */
+         for (SMc = 0; SMc < entry->SM; SMc++)
+         {
+            if (sl->SMtype[SMc] == (entry->output ? 3 : 4))
+            {
+               pos += ecx_SMbits(context, sl, (uint8)SMc, entry->output);
+            }
+         }
+         entry->offset = (uint32)(base - context->grouplist[group].outputs) + (pos >> 3);
+         entry->bit = (uint8)(pos & 0x07);
+      }
+   }
+}
+
+/** Find a mapped object of a slave.
+ * @param[in]  context        = context struct
+ * @param[in]  slave          = slave number
+ * @param[in]  index          = object index
+ * @param[in]  subindex       = object subindex
+ * @return PDO entry, NULL if the object is not mapped or not recorded.
+ */
+ec_PDOentryt *ecx_findPDOentry(ecx_contextt *context, uint16 slave, uint16 index, uint8 subindex)
+{
+   ec_slavet *sl;
+   int i;
+
+   if ((context->PDOentry == NULL) || (slave > *(context->slavecount)))
+   {
+      return NULL;
+   }
+   sl = &(context->slavelist[slave]);
+   for (i = sl->firstPDOentry; i < (sl->firstPDOentry + sl->nPDOentry); i++)
+   {
+      if ((context->PDOentry[i].index == index) && (context->PDOentry[i].subindex == subindex))
+      {
+         return &(context->PDOentry[i]);
+      }
+   }
+   return NULL;
+}
+
+/** Append a line to a text buffer if it fits, the text stays NUL terminated.
+ * @param[out] buf            = text buffer
+ * @param[in]  size           = size of text buffer
+ * @param[in]  len            = length of the text so far
+ * @param[in]  line           = line to append
+ * @return length of the text with the line.
+ */
+static int ecx_appendline(char *buf, int size, int len, const char *line)
+{
+   int n;
+
+   n = (int)strlen(line);
+   if ((len + n) < size)
+   {
+      memcpy(&buf[len], line, n);
+      buf[len + n] = '\0';
+   }
+   return len + n;
+}
+
+/** Make a C header with the IOmap offsets of all recorded PDO entries, for
+ * application code of a fixed line that reads objects at constant offsets.
+ * For every object of slave s three defines are made:\n
+ * prefix_Ss_I_iiii_ss or prefix_Ss_O_iiii_ss = byte offset in the IOmap of the group\n
+ * ..._BIT = bit in that byte\n
+ * ..._BITLEN = length in bits
+ * @param[in]  context        = context struct
+ * @param[in]  prefix         = prefix of the defines, f.e. "LINE1"
+ * @param[out] buf            = text buffer, NUL terminated
+ * @param[in]  size           = size of text buffer
+ * @return length of the header, the header is complete if less than size.
+ */
+int ecx_PDOheader(ecx_contextt *context, const char *prefix, char *buf, int size)
+{
+   char line[256];
+   char name[64];
+   ec_PDOentryt *entry;
+   ec_slavet *sl;
+   int slave, i, len;
+
+   if (size > 0)
+   {
+      buf[0] = '\0';
+   }
+   len = ecx_appendline(buf, size, 0, "/* PDO entry offsets in the IOmap, made by ecx_PDOheader() */\n");
+   if (context->PDOentry)
+   {
+      for (slave = 1; slave <= *(context->slavecount); slave++)
+      {
+         sl = &(context->slavelist[slave]);
+         if (sl->nPDOentry == 0)
+         {
+            continue;
+         }
+         sprintf(line, "\n/* slave %d %s */\n", slave, sl->name);
+         len = ecx_appendline(buf, size, len, line);
+         for (i = sl->firstPDOentry; i < (sl->firstPDOentry + sl->nPDOentry); i++)
+         {
+            entry = &(context->PDOentry[i]);
+            /* gaps in the mapping */
+            if (entry->index == 0)
+            {
+               continue;
+            }
+            sprintf(name, "%.24s_S%d_%c_%4.4X_%2.2X", prefix, slave, entry->output ? 'O' : 'I',
+                    entry->index, entry->subindex);
+            sprintf(line, "#define %s %u\n#define %s_BIT %u\n#define %s_BITLEN %u\n", name,
+                    (unsigned)entry->offset, name, (unsigned)entry->bit, name, (unsigned)entry->bitlength);
+            len = ecx_appendline(buf, size, len, line);
+         }
+      }
+   }
+   return len;
+}
+
+#ifdef EC_VER1
+/** Find a mapped object of a slave.
+ * @param[in]  slave          = slave number
+ * @param[in]  index          = object index
+ * @param[in]  subindex       = object subindex
+ * @return PDO entry, NULL if the object is not mapped or not recorded.
+ * @see ecx_findPDOentry
+ */
+ec_PDOentryt *ec_findPDOentry(uint16 slave, uint16 index, uint8 subindex)
+{
+   return ecx_findPDOentry(&ecx_context, slave, index, subindex);
+}
+
+/** Make a C header with the IOmap offsets of all recorded PDO entries.
+ * @param[in]  prefix         = prefix of the defines, f.e. "LINE1"
+ * @param[out] buf            = text buffer, NUL terminated
+ * @param[in]  size           = size of text buffer
+ * @return length of the header, the header is complete if less than size.
+ * @see ecx_PDOheader
+ */
+int ec_PDOheader(const char *prefix, char *buf, int size)
+{
+   return ecx_PDOheader(&ecx_context, prefix, buf, size);
+}
+#endif
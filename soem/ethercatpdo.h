@@ -0,0 +1,38 @@
+/*
+ * Licensed under the GNU General Public License version 2 with exceptions. See
+ * LICENSE file in the project root for full license information
+ */
+
+/** \file
+ * \brief
+ * Headerfile for ethercatpdo.c
+ */
+
+#ifndef _EC_ECATPDO_H
+#define _EC_ECATPDO_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#ifdef EC_VER1
+ec_PDOentryt *ec_findPDOentry(uint16 slave, uint16 index, uint8 subindex);
+int ec_PDOheader(const char *prefix, char *buf, int size);
+#endif
+
+void ecx_beginPDOentries(ecx_contextt *context, uint16 slave);
+void ecx_addPDOentry(ecx_contextt *context, uint16 slave, uint16 PDO, uint8 SM, boolean output, uint32 mapping);
+void ecx_copyPDOentries(ecx_contextt *context, uint16 slave, uint16 fromslave);
+boolean ecx_startPDOthreads(ecx_contextt *context, int threads);
+void ecx_mergePDOentries(ecx_contextt *context, int thread_n, uint16 slave);
+void ecx_finishPDOthreads(ecx_contextt *context, int threads);
+void ecx_locatePDOentries(ecx_contextt *context, uint8 group);
+ec_PDOentryt *ecx_findPDOentry(ecx_contextt *context, uint16 slave, uint16 index, uint8 subindex);
+int ecx_PDOheader(ecx_contextt *context, const char *prefix, char *buf, int size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _EC_ECATPDO_H */
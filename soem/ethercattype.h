@@ -60,6 +60,11 @@ extern "C"
 #define EC_ECATTYPE        0x1000
 /** number of frame buffers per channel (tx, rx1 rx2) */
 #define EC_MAXBUF          16
+/** max. number of frame buffers per channel a NIC driver with a runtime
+ * sized frame pool can be set up with, limited by the 8 bit frame index */
+#define EC_MAXBUFPOOL      255
+/** frame index returned by ecx_getindex() when all frame buffers are in use */
+#define EC_NOINDEX         0xff
 /** timeout value in us for tx frame to return to rx */
 #define EC_TIMEOUTRET      2000
 /** timeout value in us for safe data transfer, max. triple retry */
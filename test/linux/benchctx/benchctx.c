@@ -0,0 +1,110 @@
+/** \file
+ * \brief Synthetic slaves for the benchmarks that run without a NIC
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "benchctx.h"
+
+/** Monotonic time.
+ * @return time in ns
+ */
+double bench_now_ns(void)
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/** Create a context without a port for synthetic slaves.
+ * @param[in] maxslave  = size of the slavelist, slave 0 included
+ * @param[in] maxgroup  = size of the grouplist
+ * @return context, NULL if out of memory
+ */
+ecx_contextt *bench_create_context(int maxslave, int maxgroup)
+{
+   ec_contextsizet size;
+
+   memset(&size, 0x00, sizeof(size));
+   size.maxslave = maxslave;
+   size.maxgroup = maxgroup;
+   return ecx_create_context(&size);
+}
+
+/** Fill the slavelist with synthetic slaves in operational state. Slave n
+ * is of type n % ntypes.
+ * @param[in] context   = context struct
+ * @param[in] slaves    = number of slaves, less than the size of the slavelist
+ * @param[in] type      = slave types
+ * @param[in] ntypes    = number of slave types
+ * @param[in] group     = group of the slaves
+ */
+void bench_add_slaves(ecx_contextt *context, int slaves, const bench_slavetypet *type,
+   int ntypes, uint8 group)
+{
+   ec_slavet *sl;
+   const bench_slavetypet *t;
+   int slave;
+
+   memset(context->slavelist, 0x00, sizeof(ec_slavet) * (slaves + 1));
+   *(context->slavecount) = slaves;
+   for (slave = 1; slave <= slaves; slave++)
+   {
+      sl = &(context->slavelist[slave]);
+      t = &type[slave % ntypes];
+      sl->configadr = (uint16)(0x1000 + slave);
+      sl->state = EC_STATE_OPERATIONAL;
+      sl->Obits = (uint16)t->obits;
+      sl->Obytes = (t->obits < 8) ? 0 : t->obits / 8;
+      sl->Ibits = (uint16)t->ibits;
+      sl->Ibytes = (t->ibits < 8) ? 0 : t->ibits / 8;
+      sl->hasdc = t->dc;
+      sl->group = group;
+      snprintf(sl->name, sizeof(sl->name), "slave %d", slave);
+   }
+}
+
+/** Lay the slaves out in an IOmap as the sequential mapping does: slaves of
+ * less than 8 bits share bytes, wider ones start on a byte. Group 0 gets the
+ * outputs and inputs.
+ * @param[in] context   = context struct
+ * @param[in] outputs   = output area of the IOmap
+ * @param[in] inputs    = input area of the IOmap
+ */
+void bench_map_slaves(ecx_contextt *context, uint8 *outputs, uint8 *inputs)
+{
+   ec_slavet *sl;
+   uint32 obit = 0, ibit = 0;
+   int slave;
+
+   for (slave = 1; slave <= *(context->slavecount); slave++)
+   {
+      sl = &(context->slavelist[slave]);
+      if (sl->Obits)
+      {
+         if (sl->Obytes)
+         {
+            obit = (obit + 7) & ~7U;
+         }
+         sl->outputs = outputs + obit / 8;
+         sl->Ostartbit = (uint8)(obit & 0x07);
+         obit += sl->Obits;
+      }
+      if (sl->Ibits)
+      {
+         if (sl->Ibytes)
+         {
+            ibit = (ibit + 7) & ~7U;
+         }
+         sl->inputs = inputs + ibit / 8;
+         sl->Istartbit = (uint8)(ibit & 0x07);
+         ibit += sl->Ibits;
+      }
+   }
+   context->grouplist[0].outputs = outputs;
+   context->grouplist[0].Obytes = (obit + 7) / 8;
+   context->grouplist[0].inputs = inputs;
+   context->grouplist[0].Ibytes = (ibit + 7) / 8;
+}
@@ -0,0 +1,31 @@
+/** \file
+ * \brief Synthetic slaves for the benchmarks that run without a NIC
+ *
+ * layoutplan, slavewalk and bitio fill the slavelist of a context of their
+ * own with slaves of a few types and, where they touch process data, lay
+ * them out in an IOmap as the sequential mapping does. No NIC is opened.
+ */
+
+#ifndef _BENCHCTX_H
+#define _BENCHCTX_H
+
+#include "ethercat.h"
+
+/** type of a synthetic slave */
+typedef struct
+{
+   /** output bits, a slave of 8 bits and more has bits / 8 bytes */
+   int              obits;
+   /** input bits, a slave of 8 bits and more has bits / 8 bytes */
+   int              ibits;
+   /** TRUE if the slave has DC */
+   boolean          dc;
+} bench_slavetypet;
+
+double bench_now_ns(void);
+ecx_contextt *bench_create_context(int maxslave, int maxgroup);
+void bench_add_slaves(ecx_contextt *context, int slaves, const bench_slavetypet *type,
+   int ntypes, uint8 group);
+void bench_map_slaves(ecx_contextt *context, uint8 *outputs, uint8 *inputs);
+
+#endif
@@ -0,0 +1,195 @@
+/** \file
+ * \brief Benchmark of the bit IO gather and scatter
+ *
+ * Usage : bitio [channels] [loops]
+ *
+ * Builds digital IO slaves of 2, 4 and 8 bits with benchctx. All input
+ * channels are copied to a dense array with one byte per channel and all
+ * output channels back, once with ec_bitgather() and ec_bitscatter() and
+ * once bit by bit per slave, as applications unpack them. Both results are
+ * compared.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "benchctx.h"
+
+#define MAXCHANNELS 65536
+/** slave types, picked by slave number */
+static const bench_slavetypet slavetype[] =
+{
+   { 8, 8, FALSE }, { 4, 4, FALSE }, { 2, 2, FALSE }, { 8, 8, FALSE }, { 4, 4, FALSE }
+};
+#define NTYPES ((int)(sizeof(slavetype) / sizeof(slavetype[0])))
+
+static uint8 IOmap[2 * MAXCHANNELS / 8 + 2];
+static uint8 dense[MAXCHANNELS];
+static uint8 check[MAXCHANNELS];
+static ec_bitrunt runs[MAXCHANNELS / 2];
+
+/** Add slaves until they have the channels, outputs and inputs alike.
+ * @return number of slaves
+ */
+static int build(ecx_contextt *context, int channels, int maxslave)
+{
+   int slave = 0, added = 0;
+
+   while ((added < channels) && ((slave + 1) < maxslave))
+   {
+      added += slavetype[++slave % NTYPES].obits;
+   }
+   bench_add_slaves(context, slave, slavetype, NTYPES, 0);
+   bench_map_slaves(context, IOmap, IOmap + MAXCHANNELS / 8 + 1);
+   return slave;
+}
+
+/** Copy the inputs to the dense array bit by bit. */
+static void gather_bits(ecx_contextt *context, uint8 *channels)
+{
+   ec_slavet *sl;
+   int slave, b, bit;
+
+   for (slave = 1; slave <= *(context->slavecount); slave++)
+   {
+      sl = &(context->slavelist[slave]);
+      for (b = 0; b < sl->Ibits; b++)
+      {
+         bit = sl->Istartbit + b;
+         *channels++ = (sl->inputs[bit >> 3] >> (bit & 0x07)) & 0x01;
+      }
+   }
+}
+
+/** Copy the dense array to the outputs bit by bit. */
+static void scatter_bits(ecx_contextt *context, const uint8 *channels)
+{
+   ec_slavet *sl;
+   int slave, b, bit;
+
+   for (slave = 1; slave <= *(context->slavecount); slave++)
+   {
+      sl = &(context->slavelist[slave]);
+      for (b = 0; b < sl->Obits; b++)
+      {
+         bit = sl->Ostartbit + b;
+         if (*channels++)
+         {
+            sl->outputs[bit >> 3] |= (uint8)(1 << (bit & 0x07));
+         }
+         else
+         {
+            sl->outputs[bit >> 3] &= (uint8)~(1 << (bit & 0x07));
+         }
+      }
+   }
+}
+
+int main(int argc, char *argv[])
+{
+   ecx_contextt *context;
+   ec_bitmapt imap, omap;
+   uint8 outputs[MAXCHANNELS / 8 + 1];
+   int channels = 3000;
+   int loops = 100000;
+   int slaves, i, errors = 0;
+   double t0, gather, scatter, gatherbits, scatterbits;
+
+   if (argc > 1)
+   {
+      channels = atoi(argv[1]);
+   }
+   if (argc > 2)
+   {
+      loops = atoi(argv[2]);
+   }
+   /* alignment of the 8 bit slaves takes up to 7 bits per slave */
+   if ((channels < 1) || (channels > MAXCHANNELS / 2))
+   {
+      channels = 3000;
+   }
+   if (loops < 1)
+   {
+      loops = 1;
+   }
+   context = bench_create_context(channels + 1, 1);
+   if (context == NULL)
+   {
+      printf("out of memory\n");
+      return 1;
+   }
+   slaves = build(context, channels, channels + 1);
+   imap.run = runs;
+   imap.maxruns = MAXCHANNELS / 4;
+   omap.run = runs + MAXCHANNELS / 4;
+   omap.maxruns = MAXCHANNELS / 4;
+   if ((ecx_bitmap_init(context, 0, FALSE, 8, &imap, NULL) < 0) ||
+       (ecx_bitmap_init(context, 0, TRUE, 8, &omap, NULL) < 0))
+   {
+      printf("too many runs\n");
+      return 1;
+   }
+   for (i = 0; i < (int)sizeof(IOmap); i++)
+   {
+      IOmap[i] = (uint8)rand();
+   }
+
+   /* both ways give the same channels and outputs */
+   ec_bitgather(&imap, dense);
+   gather_bits(context, check);
+   if (memcmp(dense, check, imap.nchannels))
+   {
+      errors++;
+   }
+   for (i = 0; i < (int)omap.nchannels; i++)
+   {
+      dense[i] = (uint8)(rand() & 0x01);
+   }
+   ec_bitscatter(&omap, dense);
+   memcpy(outputs, IOmap, sizeof(outputs));
+   scatter_bits(context, dense);
+   if (memcmp(outputs, IOmap, sizeof(outputs)))
+   {
+      errors++;
+   }
+
+   t0 = bench_now_ns();
+   for (i = 0; i < loops; i++)
+   {
+      ec_bitgather(&imap, dense);
+   }
+   gather = (bench_now_ns() - t0) / loops;
+   t0 = bench_now_ns();
+   for (i = 0; i < loops; i++)
+   {
+      ec_bitscatter(&omap, dense);
+   }
+   scatter = (bench_now_ns() - t0) / loops;
+   t0 = bench_now_ns();
+   for (i = 0; i < loops; i++)
+   {
+      gather_bits(context, dense);
+   }
+   gatherbits = (bench_now_ns() - t0) / loops;
+   t0 = bench_now_ns();
+   for (i = 0; i < loops; i++)
+   {
+      scatter_bits(context, dense);
+   }
+   scatterbits = (bench_now_ns() - t0) / loops;
+
+   printf("bitio, %d slaves, %d input and %d output channels in %d and %d runs\n",
+      slaves, (int)imap.nchannels, (int)omap.nchannels, imap.nruns, omap.nruns);
+   printf("  %-24s %10s %10s\n", "", "gather ns", "scatter ns");
+   printf("  %-24s %10.0f %10.0f\n", "ec_bitgather/scatter", gather, scatter);
+   printf("  %-24s %10.0f %10.0f\n", "bit by bit", gatherbits, scatterbits);
+   ecx_destroy_context(context);
+   if (errors)
+   {
+      printf("results differ\n");
+      return 1;
+   }
+
+   return 0;
+}
@@ -0,0 +1,241 @@
+/** \file
+ * \brief Stress test of the lock free frame index allocation
+ *
+ * Usage : getindex_stress ifname [threads] [seconds]
+ * ifname is NIC interface, f.e. eth0 or uring:eth0. No slaves are needed,
+ * no frames are transmitted.
+ *
+ * Several threads claim frame indexes with ecx_getindex() and release them
+ * with ecx_setbufstat() as fast as they can, each thread holding a few
+ * indexes at a time. An index handed to two threads at the same time is
+ * counted as a collision. The test runs in two phases:
+ *  - the threads together hold fewer indexes than the port has, so every
+ *    claim must get a free index
+ *  - twice as many threads as the pool can serve, so the pool runs empty
+ *    and claims get EC_NOINDEX, which must happen without collisions
+ * Before that a single thread claims every index, the next claim must get
+ * EC_NOINDEX. The test fails on any collision or unexpected EC_NOINDEX.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+
+#include "ethercat.h"
+
+#define MAXTHREADS 32
+/** indexes a thread holds before it releases the oldest */
+#define HOLD 4
+
+static ecx_portt port;
+/** thread holding each index, 0 if none */
+static int owner[EC_MAXBUFPOOL];
+static volatile int running = 1;
+/** TRUE when the pool is allowed to run empty */
+static int overload = FALSE;
+
+typedef struct
+{
+   int n;
+   pthread_t thread;
+   long long claims;
+   long long collisions;
+   long long badstate;
+   /** claims that got EC_NOINDEX */
+   long long empty;
+} worker_t;
+
+static void *worker(void *arg)
+{
+   worker_t *w = arg;
+   uint8 held[HOLD];
+   int nheld = 0;
+   int expected;
+   uint8 idx;
+
+   while (running)
+   {
+      idx = ecx_getindex(&port);
+      w->claims++;
+      if (idx == EC_NOINDEX)
+      {
+         w->empty++;
+         /* make room, as a caller retrying later would */
+         if (nheld)
+         {
+            __atomic_store_n(&owner[held[0]], 0, __ATOMIC_RELEASE);
+            ecx_setbufstat(&port, held[0], EC_BUF_EMPTY);
+            memmove(&held[0], &held[1], HOLD - 1);
+            nheld--;
+         }
+         continue;
+      }
+      expected = 0;
+      if (!__atomic_compare_exchange_n(&owner[idx], &expected, w->n, FALSE,
+             __ATOMIC_ACQ_REL, __ATOMIC_RELAXED))
+      {
+         w->collisions++;
+         continue;
+      }
+      if (__atomic_load_n(&(port.rxbufstat[idx]), __ATOMIC_ACQUIRE) != EC_BUF_ALLOC)
+      {
+         w->badstate++;
+      }
+      if (nheld == HOLD)
+      {
+         /* release the oldest, ownership is dropped before the index */
+         __atomic_store_n(&owner[held[0]], 0, __ATOMIC_RELEASE);
+         ecx_setbufstat(&port, held[0], EC_BUF_EMPTY);
+         memmove(&held[0], &held[1], HOLD - 1);
+         nheld--;
+      }
+      held[nheld++] = idx;
+   }
+   while (nheld)
+   {
+      nheld--;
+      __atomic_store_n(&owner[held[nheld]], 0, __ATOMIC_RELEASE);
+      ecx_setbufstat(&port, held[nheld], EC_BUF_EMPTY);
+   }
+   return NULL;
+}
+
+/** Claim every index from one thread, the pool must then be empty.
+ * @return TRUE if passed
+ */
+static int exhaust(void)
+{
+   int i, ok = TRUE;
+
+   for (i = 0; i < port.maxbuf; i++)
+   {
+      if (ecx_getindex(&port) == EC_NOINDEX)
+      {
+         ok = FALSE;
+      }
+   }
+   if (ecx_getindex(&port) != EC_NOINDEX)
+   {
+      ok = FALSE;
+   }
+   for (i = 0; i < port.maxbuf; i++)
+   {
+      ecx_setbufstat(&port, (uint8)i, EC_BUF_EMPTY);
+   }
+   printf("exhaust    : %s\n", ok ? "EC_NOINDEX after all indexes" : "wrong");
+   return ok;
+}
+
+/** Run the workers for a while and report.
+ * @return TRUE if passed
+ */
+static int run(int threads, int seconds)
+{
+   worker_t workers[MAXTHREADS];
+   long long claims = 0, collisions = 0, badstate = 0, empty = 0;
+   struct timespec t0, t1;
+   double elapsed;
+   int i, ok;
+
+   printf("%s, %d threads holding %d of %d indexes, %d s\n",
+      overload ? "overload" : "normal", threads, HOLD, port.maxbuf, seconds);
+   running = 1;
+   memset(owner, 0, sizeof(owner));
+   clock_gettime(CLOCK_MONOTONIC, &t0);
+   for (i = 0; i < threads; i++)
+   {
+      memset(&workers[i], 0, sizeof(worker_t));
+      workers[i].n = i + 1;
+      pthread_create(&workers[i].thread, NULL, worker, &workers[i]);
+   }
+   osal_usleep(seconds * 1000000);
+   running = 0;
+   for (i = 0; i < threads; i++)
+   {
+      pthread_join(workers[i].thread, NULL);
+      claims += workers[i].claims;
+      collisions += workers[i].collisions;
+      badstate += workers[i].badstate;
+      empty += workers[i].empty;
+   }
+   clock_gettime(CLOCK_MONOTONIC, &t1);
+   elapsed = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+
+   printf("claims     : %lld (%.0f per second)\n", claims, claims / elapsed);
+   printf("collisions : %lld\n", collisions);
+   printf("bad state  : %lld\n", badstate);
+   printf("no index   : %lld\n", empty);
+   ok = !collisions && !badstate;
+   /* without overload every claim gets an index, with it the pool must run empty */
+   if (overload ? !empty : empty)
+   {
+      ok = FALSE;
+   }
+   return ok;
+}
+
+int main(int argc, char *argv[])
+{
+   int threads = 8;
+   int seconds = 5;
+   int ok;
+
+   if (argc < 2)
+   {
+      printf("Usage: getindex_stress ifname [threads] [seconds]\n");
+      return 1;
+   }
+   if (argc > 2)
+   {
+      threads = atoi(argv[2]);
+   }
+   if (argc > 3)
+   {
+      seconds = atoi(argv[3]);
+   }
+   if (threads < 1)
+   {
+      threads = 1;
+   }
+   if (threads > MAXTHREADS)
+   {
+      threads = MAXTHREADS;
+   }
+   if (seconds < 1)
+   {
+      seconds = 1;
+   }
+   memset(&port, 0, sizeof(port));
+   if (!ecx_setupnic(&port, argv[1], FALSE))
+   {
+      printf("No socket connection on %s\nExecute as root\n", argv[1]);
+      return 1;
+   }
+   printf("getindex_stress on %s\n", argv[1]);
+   ok = exhaust();
+   /* a thread holds one more while it claims the next */
+   if (threads * (HOLD + 1) >= port.maxbuf)
+   {
+      threads = (port.maxbuf - 1) / (HOLD + 1);
+   }
+   ok &= run(threads, seconds);
+   /* twice the threads the pool can serve */
+   overload = TRUE;
+   threads = 2 * port.maxbuf / HOLD;
+   if (threads > MAXTHREADS)
+   {
+      threads = MAXTHREADS;
+   }
+   ok &= run(threads, seconds);
+   ecx_closenic(&port);
+
+   if (!ok)
+   {
+      printf("FAILED\n");
+      return 1;
+   }
+   printf("passed\n");
+   return 0;
+}
@@ -0,0 +1,181 @@
+/** \file
+ * \brief Benchmark of the IO segment layout planner
+ *
+ * Usage : layoutplan [loops]
+ *
+ * Builds synthetic slave populations with benchctx and plans their process
+ * data layout with ecx_config_plan_group().
+ * For every population the frames and bytes per cycle are listed for:
+ *  - the old rule, keeping room for the DC datagram in every segment
+ *  - the layout chosen by the planner, with its mapping options
+ *  - the layout chosen when the input only slaves may be split off into a
+ *    group transmitted every INPUTCYCLE'th cycle
+ * and the time one plan takes.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "benchctx.h"
+
+#define MAXSLAVE 1001
+#define INPUTCYCLE 10
+
+typedef struct
+{
+   const char *name;
+   int slaves;
+   /** slave types, a slave type is picked by slave number */
+   int types;
+   const bench_slavetypet *type;
+} population_t;
+
+static const bench_slavetypet io[] =
+{
+   { 16, 0, FALSE }, { 0, 16, FALSE }, { 32, 0, FALSE }, { 0, 32, FALSE }, { 64, 64, FALSE }
+};
+static const bench_slavetypet io_dc[] =
+{
+   { 16, 0, TRUE }, { 0, 16, TRUE }, { 32, 0, TRUE }, { 0, 32, TRUE }, { 64, 64, TRUE }
+};
+static const bench_slavetypet drive[] =
+{
+   { 256, 320, TRUE }, { 256, 320, TRUE }, { 16, 0, TRUE }
+};
+static const bench_slavetypet sense[] =
+{
+   { 0, 96, TRUE }, { 0, 192, TRUE }, { 0, 48, TRUE }, { 8, 8, TRUE }
+};
+static const bench_slavetypet gate[] =
+{
+   { 2968, 2968, TRUE }
+};
+
+static const population_t populations[] =
+{
+   { "200 digital/analog IO",        200, 5, io },
+   { "100 drives + couplers",        100, 3, drive },
+   { "1000 mixed IO",               1000, 5, io_dc },
+   { "500 sensors, mostly inputs",   500, 4, sense },
+   { "24 fieldbus gateways",          24, 1, gate },
+};
+
+/** frames of the old rule, every segment keeps room for the DC datagram */
+static int oldrule(ecx_contextt *context, int *wirebytes)
+{
+   int slave, pass, size, frames = 1, bytes = 0, diff;
+   int limit = EC_MAXLRWDATA - EC_FIRSTDCDATAGRAM;
+
+   size = 0;
+   for (pass = 0; pass < 2; pass++)
+   {
+      for (slave = 1; slave <= *(context->slavecount); slave++)
+      {
+         diff = pass ? context->slavelist[slave].Ibytes : context->slavelist[slave].Obytes;
+         if (!diff)
+         {
+            continue;
+         }
+         if (size + diff > limit)
+         {
+            frames++;
+            size = 0;
+         }
+         size += diff;
+         bytes += diff;
+      }
+   }
+   *wirebytes = bytes + frames * (ETH_HEADERSIZE + EC_HEADERSIZE + EC_WKCSIZE);
+   if (context->slavelist[1].hasdc)
+   {
+      *wirebytes += EC_FIRSTDCDATAGRAM;
+   }
+   return frames;
+}
+
+static void line(const char *what, int frames, int wirebytes, double us)
+{
+   printf("  %-34s frames %4d  bytes/cycle %7d", what, frames, wirebytes);
+   if (us > 0)
+   {
+      printf("  %8.2f us/plan", us);
+   }
+   printf("\n");
+}
+
+static void options(const ec_groupplant *plan)
+{
+   printf("    %s IOmap, FRMW ", plan->overlap ? "overlapping" :
+      (plan->aligned ? "byte aligned" : "sequential"));
+   if (plan->DCsegment == EC_NODCSEGMENT)
+   {
+      printf("none");
+   }
+   else
+   {
+      printf("in frame %d", plan->DCsegment);
+   }
+   if (plan->splitinputs)
+   {
+      printf(", input only slaves split off: frames %d bytes %d every %dth cycle",
+         plan->inputnframes, plan->inputwirebytes, INPUTCYCLE);
+   }
+   printf("\n");
+}
+
+int main(int argc, char *argv[])
+{
+   ecx_contextt *context;
+   ec_groupplant plan;
+   const population_t *pop;
+   int loops = 1000;
+   int p, i, frames, wirebytes;
+   double t0, us;
+
+   if (argc > 1)
+   {
+      loops = atoi(argv[1]);
+      if (loops < 1)
+      {
+         loops = 1;
+      }
+   }
+   context = bench_create_context(MAXSLAVE, 3);
+   if (context == NULL)
+   {
+      printf("out of memory\n");
+      return 1;
+   }
+   printf("layoutplan, %d plans per result\n", loops);
+   for (p = 0; p < (int)(sizeof(populations) / sizeof(populations[0])); p++)
+   {
+      pop = &populations[p];
+      bench_add_slaves(context, pop->slaves, pop->type, pop->types, 1);
+      printf("%s\n", pop->name);
+
+      frames = oldrule(context, &wirebytes);
+      line("old rule, DC room in every frame", frames, wirebytes, 0);
+
+      t0 = bench_now_ns();
+      for (i = 0; i < loops; i++)
+      {
+         ecx_config_plan_group(context, 1, 0, &plan);
+      }
+      us = (bench_now_ns() - t0) / 1e3 / loops;
+      line("planner", plan.nframes, plan.wirebytes, us);
+      options(&plan);
+
+      t0 = bench_now_ns();
+      for (i = 0; i < loops; i++)
+      {
+         ecx_config_plan_group(context, 1, INPUTCYCLE, &plan);
+      }
+      us = (bench_now_ns() - t0) / 1e3 / loops;
+      line("planner, inputs may be split off", plan.nframes, plan.wirebytes, us);
+      options(&plan);
+   }
+   ecx_destroy_context(context);
+
+   return 0;
+}
@@ -0,0 +1,492 @@
+/** \file
+ * \brief Benchmark of the linux NIC driver on a veth pair
+ *
+ * Usage : nicbench ifname peer [cycles] [segments]
+ * ifname and peer are the two ends of a veth pair, f.e.
+ *   ip link add vb0 type veth peer name vb1
+ *   ip link set vb0 up; ip link set vb1 up
+ *   nicbench vb0 vb1
+ *
+ * A reflector thread on the peer plays the slaves: it returns every
+ * EtherCAT frame with the second bit of the source MAC set. The master side
+ * is a context with one group of hand made IO segments, no slaves are
+ * configured. Every cycle transmits and receives all segment frames with
+ * ecx_send_processdata_group() and ecx_receive_processdata_group().
+ *
+ * Transports: time, system calls, frames and process data bytes copied
+ * between IOmap and frame buffers per cycle, for the plain socket and the
+ * mmap:, uring: and xdp: transports. Calls counted by the driver, polls of
+ * the mmap and xdp rings need none.
+ *
+ * Batch: transmit time per cycle of the segment frames sent one by one with
+ * ecx_outframe_red(), as the send loop did before batching, against the
+ * same frames queued between ecx_txbatch_begin() and ecx_txbatch_flush().
+ *
+ * Wait modes: CPU time of the cycle thread and the round trip latency of
+ * the process data, with ECT_WAIT_SPIN, ECT_WAIT_POLL and ECT_WAIT_POLL with
+ * a busy poll window. Cycles of one frame run at a fixed period and the
+ * reflector holds the frame back for a while, as a long line would.
+ *
+ * Copies: process data bytes copied per cycle between the IOmap and the
+ * frame buffers, with port->txgather and port->rxscatter off as set by
+ * ecx_setupnic() and with both on.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <poll.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/ioctl.h>
+#include <net/if.h>
+#include <netinet/in.h>
+#include <linux/if_packet.h>
+
+#include "ethercat.h"
+
+#define ETH_P_ECAT 0x88A4
+/** size of one IO segment, half outputs and half inputs */
+#define SEGMENTSIZE 1024
+#define MAXSEGMENTS 8
+/** cycle period and round trip of the reflector in us, wait mode benchmark */
+#define WAITPERIOD 1000
+#define WAITDELAY 200
+#define WAITCYCLES 2000
+
+typedef struct
+{
+   ecx_contextt *context;
+   uint8 IOmap[SEGMENTSIZE * MAXSEGMENTS];
+} bench_t;
+
+static volatile int reflecting = 1;
+/** us the reflector holds a frame back */
+static volatile int reflectdelay = 0;
+
+/** Count every datagram of a frame as processed by one slave. */
+static void reflect_wkc(uint8 *frame, int n)
+{
+   /* datagram header without the frame length, and work counter */
+   const int dghead = (int)(EC_HEADERSIZE - EC_ELENGTHSIZE);
+   const int wkcsize = (int)EC_WKCSIZE;
+   int pos = (int)(ETH_HEADERSIZE + EC_ELENGTHSIZE);
+   uint16 dlength, wkc;
+
+   while ((pos + dghead + wkcsize) <= n)
+   {
+      dlength = (uint16)(frame[pos + 6] | (frame[pos + 7] << 8));
+      pos += dghead + (dlength & 0x07ff);
+      if ((pos + wkcsize) > n)
+      {
+         break;
+      }
+      wkc = (uint16)(frame[pos] | (frame[pos + 1] << 8)) + 1;
+      frame[pos] = (uint8)wkc;
+      frame[pos + 1] = (uint8)(wkc >> 8);
+      pos += wkcsize;
+      if (!(dlength & EC_DATAGRAMFOLLOWS))
+      {
+         break;
+      }
+   }
+}
+
+static double now_us(void)
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+/** Return every EtherCAT frame received on the peer, as the slaves do. */
+static void *reflector(void *arg)
+{
+   const char *peer = arg;
+   struct sockaddr_ll sll;
+   struct ifreq ifr;
+   struct pollfd pfd;
+   uint8 frame[EC_BUFSIZE];
+   double t;
+   int s, n;
+
+   s = socket(PF_PACKET, SOCK_RAW, htons(ETH_P_ECAT));
+   memset(&ifr, 0, sizeof(ifr));
+   strncpy(ifr.ifr_name, peer, IFNAMSIZ - 1);
+   if ((s < 0) || (ioctl(s, SIOCGIFINDEX, &ifr) < 0))
+   {
+      printf("reflector: no socket on %s\n", peer);
+      return NULL;
+   }
+   memset(&sll, 0, sizeof(sll));
+   sll.sll_family = AF_PACKET;
+   sll.sll_ifindex = ifr.ifr_ifindex;
+   sll.sll_protocol = htons(ETH_P_ECAT);
+   bind(s, (struct sockaddr *)&sll, sizeof(sll));
+   pfd.fd = s;
+   pfd.events = POLLIN;
+   while (reflecting)
+   {
+      if (poll(&pfd, 1, 100) <= 0)
+      {
+         continue;
+      }
+      n = recv(s, frame, sizeof(frame), 0);
+      if (n > (int)(ETH_HEADERSIZE + EC_HEADERSIZE))
+      {
+         /* a slave marks the frame as passed */
+         frame[6] |= 0x02;
+         reflect_wkc(frame, n);
+         if (reflectdelay)
+         {
+            /* spin, a sleep would add its own wake up latency */
+            t = now_us() + reflectdelay;
+            while (now_us() < t);
+         }
+         send(s, frame, n, 0);
+      }
+   }
+   close(s);
+   return NULL;
+}
+
+
+static void bench_close(bench_t *b)
+{
+   if (b->context)
+   {
+      ecx_close(b->context);
+      ecx_destroy_context(b->context);
+      b->context = NULL;
+   }
+}
+
+/** Open the port and lay out one group of segments with LRW frames. */
+static int bench_open(bench_t *b, const char *ifname, int segments)
+{
+   ec_contextsizet size;
+   ec_groupt *grp;
+   int i;
+
+   memset(&size, 0, sizeof(size));
+   size.maxslave = 2;
+   size.maxgroup = 1;
+   b->context = ecx_create_context(&size);
+   if (b->context == NULL)
+   {
+      return 0;
+   }
+   if (!ecx_init(b->context, ifname))
+   {
+      ecx_destroy_context(b->context);
+      b->context = NULL;
+      return 0;
+   }
+   grp = &(b->context->grouplist[0]);
+   /* released by ecx_close() as if the mapping had allocated it */
+   grp->IOsegment = (uint32 *)malloc(segments * sizeof(uint32));
+   grp->maxsegments = (uint16)segments;
+   for (i = 0; i < segments; i++)
+   {
+      grp->IOsegment[i] = SEGMENTSIZE;
+   }
+   grp->nsegments = (uint16)segments;
+   grp->Obytes = segments * SEGMENTSIZE / 2;
+   grp->Ibytes = segments * SEGMENTSIZE / 2;
+   grp->outputs = b->IOmap;
+   grp->inputs = b->IOmap + grp->Obytes;
+   grp->logstartaddr = 0;
+   /* the tables the mapping would allocate */
+   if (!ecx_alloc_group(b->context, 0))
+   {
+      bench_close(b);
+      return 0;
+   }
+   return 1;
+}
+
+/** Run cycles with fresh port counters.
+ * @return us per cycle
+ */
+static double bench_run(bench_t *b, int cycles)
+{
+   double t0;
+   int i, lost = 0;
+
+   /* warm up */
+   for (i = 0; i < 100; i++)
+   {
+      ecx_send_processdata_group(b->context, 0);
+      ecx_receive_processdata_group(b->context, 0, EC_TIMEOUTRET);
+   }
+   memset(&(b->context->port->stats), 0, sizeof(ec_nicstatt));
+   t0 = now_us();
+   for (i = 0; i < cycles; i++)
+   {
+      ecx_send_processdata_group(b->context, 0);
+      if (ecx_receive_processdata_group(b->context, 0, EC_TIMEOUTRET) <= 0)
+      {
+         lost++;
+      }
+   }
+   if (lost)
+   {
+      printf("    %d of %d cycles lost frames\n", lost, cycles);
+   }
+   return (now_us() - t0) / cycles;
+}
+
+/** Transmit one LRW frame per segment and wait for all of them.
+ * @param[in] batch   = TRUE to queue the frames and flush them at once
+ * @param[out] txus   = us per cycle spent transmitting
+ * @return us per cycle
+ */
+static double bench_txloop(bench_t *b, int cycles, int batch, double *txus)
+{
+   ecx_portt *port = b->context->port;
+   ec_groupt *grp = &(b->context->grouplist[0]);
+   uint8 idx[MAXSEGMENTS];
+   uint8 *data;
+   double t0, t1, tx = 0;
+   int i, seg, lost = 0;
+
+   memset(&(port->stats), 0, sizeof(ec_nicstatt));
+   t0 = now_us();
+   for (i = 0; i < cycles; i++)
+   {
+      t1 = now_us();
+      if (batch)
+      {
+         ecx_txbatch_begin(port);
+      }
+      data = grp->outputs;
+      for (seg = 0; seg < grp->nsegments; seg++)
+      {
+         idx[seg] = ecx_getindex(port);
+         ecx_setupdatagram(port, &(port->txbuf[idx[seg]]), EC_CMD_LRW, idx[seg],
+            LO_WORD(seg * SEGMENTSIZE), HI_WORD(seg * SEGMENTSIZE), SEGMENTSIZE, data);
+         ecx_outframe_red(port, idx[seg]);
+         data += SEGMENTSIZE;
+      }
+      if (batch)
+      {
+         ecx_txbatch_flush(port);
+      }
+      tx += now_us() - t1;
+      for (seg = 0; seg < grp->nsegments; seg++)
+      {
+         if (ecx_waitinframe(port, idx[seg], EC_TIMEOUTRET) <= 0)
+         {
+            lost++;
+         }
+         ecx_setbufstat(port, idx[seg], EC_BUF_EMPTY);
+      }
+   }
+   if (lost)
+   {
+      printf("    %d frames lost\n", lost);
+   }
+   *txus = tx / cycles;
+   return (now_us() - t0) / cycles;
+}
+
+static void bench_batch(bench_t *b, const char *ifname, int cycles, int segments)
+{
+   static const char *mode[] = { "frame by frame", "batched" };
+   ec_nicstatt *st;
+   double us, txus;
+   int batch;
+
+   printf("batch, %d segment frames per cycle on %s\n", segments, ifname);
+   if (!bench_open(b, ifname, segments))
+   {
+      printf("    not available\n");
+      return;
+   }
+   printf("    %-16s %10s %10s %10s %10s\n", "", "us/cycle", "tx us", "tx calls",
+      "per flush");
+   for (batch = 0; batch < 2; batch++)
+   {
+      us = bench_txloop(b, cycles, batch, &txus);
+      st = &(b->context->port->stats);
+      printf("    %-16s %10.1f %10.2f %10.2f %10.2f\n", mode[batch], us, txus,
+         (double)st->txcalls / cycles,
+         st->txflushes ? (double)st->txflushframes / st->txflushes : 0.0);
+   }
+   bench_close(b);
+}
+
+/** CPU time of the calling thread, the reflector is not counted */
+static double cpu_us(void)
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+   return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static void bench_waitmodes(bench_t *b, const char *ifname)
+{
+   static const char *mode[] = { "spin", "poll", "poll, busy poll" };
+   static const int waitmode[] = { ECT_WAIT_SPIN, ECT_WAIT_POLL, ECT_WAIT_POLL };
+   static const int busypoll[] = { 0, 0, 50 };
+   struct timespec next;
+   double t0, cpu0, lat, latsum, latmax, cpu, wall;
+   int m, i, lost;
+
+   printf("wait modes, %d cycles of %d us, one frame returning after %d us, on %s\n",
+      WAITCYCLES, WAITPERIOD, WAITDELAY, ifname);
+   printf("    %-16s %10s %10s %10s %10s\n", "", "cpu %", "cpu us", "lat us", "max us");
+   reflectdelay = WAITDELAY;
+   for (m = 0; m < (int)(sizeof(mode) / sizeof(mode[0])); m++)
+   {
+      if (!bench_open(b, ifname, 1))
+      {
+         printf("    not available\n");
+         break;
+      }
+      if (!ecx_setwaitmode(b->context->port, waitmode[m], busypoll[m]))
+      {
+         printf("    %-16s busy poll not set\n", mode[m]);
+      }
+      latsum = latmax = 0;
+      lost = 0;
+      clock_gettime(CLOCK_MONOTONIC, &next);
+      wall = now_us();
+      cpu0 = cpu_us();
+      for (i = 0; i < WAITCYCLES; i++)
+      {
+         next.tv_nsec += WAITPERIOD * 1000;
+         if (next.tv_nsec >= 1000000000)
+         {
+            next.tv_nsec -= 1000000000;
+            next.tv_sec++;
+         }
+         clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+         t0 = now_us();
+         ecx_send_processdata_group(b->context, 0);
+         if (ecx_receive_processdata_group(b->context, 0, EC_TIMEOUTRET) <= 0)
+         {
+            lost++;
+         }
+         lat = now_us() - t0;
+         latsum += lat;
+         if (lat > latmax)
+         {
+            latmax = lat;
+         }
+      }
+      cpu = cpu_us() - cpu0;
+      wall = now_us() - wall;
+      printf("    %-16s %10.1f %10.1f %10.1f %10.1f\n", mode[m], 100.0 * cpu / wall,
+         cpu / WAITCYCLES, latsum / WAITCYCLES, latmax);
+      if (lost)
+      {
+         printf("    %d of %d cycles lost frames\n", lost, WAITCYCLES);
+      }
+      bench_close(b);
+   }
+   reflectdelay = 0;
+}
+
+static void bench_copies(bench_t *b, const char *ifname, int cycles, int segments)
+{
+   static const char *prefix[] = { "", "mmap:", "uring:", "xdp:" };
+   char name[64];
+   ec_nicstatt *st;
+   double us;
+   int i, on;
+
+   printf("copies, %d segment frames per cycle\n", segments);
+   printf("    %-16s %-4s %10s %10s %10s\n", "", "", "us/cycle", "tx copy", "rx copy");
+   for (i = 0; i < (int)(sizeof(prefix) / sizeof(prefix[0])); i++)
+   {
+      snprintf(name, sizeof(name), "%s%s", prefix[i], ifname);
+      for (on = 0; on < 2; on++)
+      {
+         if (!bench_open(b, name, segments))
+         {
+            printf("    %-16s not available\n", name);
+            break;
+         }
+         b->context->port->txgather = on;
+         b->context->port->rxscatter = on;
+         us = bench_run(b, cycles);
+         st = &(b->context->port->stats);
+         printf("    %-16s %-4s %10.1f %10.0f %10.0f\n", name, on ? "on" : "off", us,
+            (double)st->txcopybytes / cycles, (double)st->rxcopybytes / cycles);
+         bench_close(b);
+      }
+   }
+}
+
+static void bench_transports(bench_t *b, const char *ifname, int cycles, int segments)
+{
+   static const char *prefix[] = { "", "mmap:", "uring:", "xdp:" };
+   char name[64];
+   ec_nicstatt *st;
+   double us;
+   int i;
+
+   printf("transports, %d segment frames per cycle\n", segments);
+   printf("    %-16s %10s %10s %10s %10s %10s\n", "", "us/cycle", "tx calls", "rx calls", "frames",
+      "copied");
+   for (i = 0; i < (int)(sizeof(prefix) / sizeof(prefix[0])); i++)
+   {
+      snprintf(name, sizeof(name), "%s%s", prefix[i], ifname);
+      if (!bench_open(b, name, segments))
+      {
+         printf("    %-16s not available\n", name);
+         continue;
+      }
+      us = bench_run(b, cycles);
+      st = &(b->context->port->stats);
+      printf("    %-16s %10.1f %10.2f %10.2f %10.2f %10.0f\n", name, us,
+         (double)st->txcalls / cycles, (double)st->rxcalls / cycles,
+         (double)st->rxframes / cycles, (double)(st->txcopybytes + st->rxcopybytes) / cycles);
+      bench_close(b);
+   }
+}
+
+int main(int argc, char *argv[])
+{
+   static bench_t b;
+   pthread_t thread;
+   int cycles = 10000;
+   int segments = 4;
+
+   if (argc < 3)
+   {
+      printf("Usage: nicbench ifname peer [cycles] [segments]\n");
+      return 1;
+   }
+   if (argc > 3)
+   {
+      cycles = atoi(argv[3]);
+   }
+   if (argc > 4)
+   {
+      segments = atoi(argv[4]);
+   }
+   if (cycles < 1)
+   {
+      cycles = 1;
+   }
+   if ((segments < 1) || (segments > MAXSEGMENTS))
+   {
+      segments = 4;
+   }
+   pthread_create(&thread, NULL, reflector, argv[2]);
+   /* let the reflector bind */
+   osal_usleep(100000);
+
+   bench_transports(&b, argv[1], cycles, segments);
+   bench_batch(&b, argv[1], cycles, segments);
+   bench_waitmodes(&b, argv[1]);
+   bench_copies(&b, argv[1], cycles, segments);
+
+   reflecting = 0;
+   pthread_join(thread, NULL);
+   return 0;
+}
@@ -0,0 +1,153 @@
+/** \file
+ * \brief Benchmark of walking the slaves in the cyclic path
+ *
+ * Usage : slavewalk [slaves] [loops]
+ *
+ * Builds synthetic slaves with benchctx, mapped one after another, and syncs
+ * their cyclic part with ecx_update_slavecyclic(). Every walk checks the
+ * state of each slave, reads its first input byte and writes its first
+ * output byte, as an application does every cycle. The walk over
+ * context->slavelist is timed against the walk over context->slavecyclic,
+ * once with the slave data in the cache and once after the cache is flushed
+ * by a large buffer.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "benchctx.h"
+
+/** bytes written between two cold walks to push the slaves out of the cache */
+#define FLUSHSIZE (32 * 1024 * 1024)
+/** output and input bytes of a slave */
+#define IOBYTES 4
+
+static const bench_slavetypet iotype = { IOBYTES * 8, IOBYTES * 8, FALSE };
+
+static uint8 *flushbuf;
+
+static void flush_cache(void)
+{
+   static uint8 n;
+   memset(flushbuf, ++n, FLUSHSIZE);
+}
+
+static int walk_slavelist(ecx_contextt *context)
+{
+   ec_slavet *sl;
+   int slave, notop = 0;
+
+   for (slave = 1; slave <= *(context->slavecount); slave++)
+   {
+      sl = &(context->slavelist[slave]);
+      if (sl->state != EC_STATE_OPERATIONAL)
+      {
+         notop++;
+      }
+      if (sl->Obytes && sl->Ibytes)
+      {
+         sl->outputs[0] = sl->inputs[0] + 1;
+      }
+   }
+   return notop;
+}
+
+static int walk_slavecyclic(ecx_contextt *context)
+{
+   ec_slavecyclict *sc;
+   int slave, notop = 0;
+
+   for (slave = 1; slave <= *(context->slavecount); slave++)
+   {
+      sc = &(context->slavecyclic[slave]);
+      if (sc->state != EC_STATE_OPERATIONAL)
+      {
+         notop++;
+      }
+      if (sc->Obytes && sc->Ibytes)
+      {
+         sc->outputs[0] = sc->inputs[0] + 1;
+      }
+   }
+   return notop;
+}
+
+/** Time a walk.
+ * @param[in] cold    = TRUE to flush the cache before every walk
+ * @return ns per walk
+ */
+static double bench(ecx_contextt *context, int (*walk)(ecx_contextt *), int loops, int cold)
+{
+   double t0, ns = 0;
+   int i, notop = 0;
+
+   for (i = 0; i < loops; i++)
+   {
+      if (cold)
+      {
+         flush_cache();
+      }
+      t0 = bench_now_ns();
+      notop += walk(context);
+      ns += bench_now_ns() - t0;
+   }
+   if (notop)
+   {
+      printf("  %d slaves not in OP\n", notop);
+   }
+   return ns / loops;
+}
+
+int main(int argc, char *argv[])
+{
+   ecx_contextt *context;
+   uint8 *IOmap;
+   int slaves = 1000;
+   int loops = 1000;
+   double list, cyclic;
+
+   if (argc > 1)
+   {
+      slaves = atoi(argv[1]);
+   }
+   if (argc > 2)
+   {
+      loops = atoi(argv[2]);
+   }
+   if (slaves < 1)
+   {
+      slaves = 1;
+   }
+   if (loops < 1)
+   {
+      loops = 1;
+   }
+   context = bench_create_context(slaves + 1, 1);
+   IOmap = (uint8 *)calloc(2 * slaves, IOBYTES);
+   flushbuf = (uint8 *)malloc(FLUSHSIZE);
+   if ((context == NULL) || (IOmap == NULL) || (flushbuf == NULL))
+   {
+      printf("out of memory\n");
+      return 1;
+   }
+   bench_add_slaves(context, slaves, &iotype, 1, 0);
+   bench_map_slaves(context, IOmap, IOmap + slaves * IOBYTES);
+   ecx_update_slavecyclic(context);
+
+   printf("slavewalk, %d slaves, %d walks per result\n", slaves, loops);
+   printf("  %-24s %8d bytes per slave\n", "ec_slavet", (int)sizeof(ec_slavet));
+   printf("  %-24s %8d bytes per slave\n", "ec_slavecyclict", (int)sizeof(ec_slavecyclict));
+   list = bench(context, walk_slavelist, loops, FALSE);
+   cyclic = bench(context, walk_slavecyclic, loops, FALSE);
+   printf("  %-24s %8.0f ns slavelist %8.0f ns slavecyclic\n", "cached", list, cyclic);
+   list = bench(context, walk_slavelist, loops / 10 + 1, TRUE);
+   cyclic = bench(context, walk_slavecyclic, loops / 10 + 1, TRUE);
+   printf("  %-24s %8.0f ns slavelist %8.0f ns slavecyclic\n", "cold cache", list, cyclic);
+
+   free(flushbuf);
+   free(IOmap);
+   ecx_destroy_context(context);
+
+   return 0;
+}